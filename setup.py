@@ -13,8 +13,9 @@ from distutils.spawn import spawn
 import os
 del os.link
 
+# getdate.y is a reentrant (api.pure) bison grammar, so no POSIX yacc mode
 if newer('./src/getdate.y', './src/getdate.c'):
-    execute(spawn, (['bison', '-y', '-o', './src/getdate.c', './src/getdate.y'],))
+    execute(spawn, (['bison', '-o', './src/getdate.c', './src/getdate.y'],))
 
 setup(name='python-kadmin',
       version='0.1.1',
@@ -38,6 +39,19 @@ setup(name='python-kadmin',
                   "src/PyKAdminPolicyObject.c",
                   "src/PyKAdminCommon.c",
                   "src/PyKAdminXDR.c",
+                  "src/PyKAdminNameIndex.c",
+                  "src/PyKAdminName.c",
+                  "src/PyKAdminCache.c",
+                  "src/PyKAdminPolicyTable.c",
+                  "src/PyKAdminDate.c",
+                  "src/PyKAdminSession.c",
+                  "src/PyKAdminOptions.c",
+                  "src/PyKAdminController.c",
+                  "src/PyKAdminRenewal.c",
+                  "src/PyKAdminFailover.c",
+                  "src/PyKAdminReplica.c",
+                  "src/PyKAdminGateway.c",
+                  "src/PyKAdminCommitQueue.c",
                   "src/getdate.c"
                   ],
               #extra_compile_args=["-O0"]
@@ -69,7 +83,7 @@ setup(name='python-kadmin-local',
       ext_modules=[
           Extension(
               "kadmin_local",
-              libraries=["krb5", "kadm5srv", "kdb5"],
+              libraries=["krb5", "kadm5srv", "kdb5", "pthread"],
               include_dirs=["/usr/include/", "/usr/include/et/"],
               sources=[
                   "src/kadmin.c",
@@ -80,6 +94,20 @@ setup(name='python-kadmin-local',
                   "src/PyKAdminPolicyObject.c",
                   "src/PyKAdminCommon.c",
                   "src/PyKAdminXDR.c",
+                  "src/PyKAdminNameIndex.c",
+                  "src/PyKAdminName.c",
+                  "src/PyKAdminCache.c",
+                  "src/PyKAdminPolicyTable.c",
+                  "src/PyKAdminDate.c",
+                  "src/PyKAdminSession.c",
+                  "src/PyKAdminOptions.c",
+                  "src/PyKAdminController.c",
+                  "src/PyKAdminRenewal.c",
+                  "src/PyKAdminFailover.c",
+                  "src/PyKAdminReplica.c",
+                  "src/PyKAdminGateway.c",
+                  "src/PyKAdminCommitQueue.c",
+                  "src/PyKAdminLMDB.c",
                   "src/getdate.c"
                   ],
               define_macros=[('KADMIN_LOCAL', '')]
@@ -0,0 +1,265 @@
+
+#include "PyKAdminCache.h"
+#include "PyKAdminCommon.h"
+
+#include <errno.h>
+
+#define kCACHE_MIN_BUCKETS 16
+
+typedef struct _pykadmin_cache_node {
+
+    char *name;
+    size_t hash;
+    double expires;
+    kadm5_principal_ent_rec entry;
+
+    // most recently used first
+    struct _pykadmin_cache_node *prev;
+    struct _pykadmin_cache_node *next;
+
+    struct _pykadmin_cache_node *chain;
+
+} pykadmin_cache_node_t;
+
+struct _pykadmin_cache {
+
+    size_t max_entries;
+    double ttl;
+
+    size_t count;
+    size_t bucket_count;
+    pykadmin_cache_node_t **buckets;
+
+    pykadmin_cache_node_t *head;
+    pykadmin_cache_node_t *tail;
+
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long evictions;
+    unsigned long long invalidations;
+};
+
+
+pykadmin_cache_t *pykadmin_cache_create(size_t max_entries, double ttl) {
+
+    pykadmin_cache_t *cache = calloc(1, sizeof(pykadmin_cache_t));
+
+    if (cache) {
+
+        cache->max_entries  = max_entries;
+        cache->ttl          = ttl;
+        cache->bucket_count = kCACHE_MIN_BUCKETS;
+
+        while (cache->bucket_count < max_entries)
+            cache->bucket_count *= 2;
+
+        cache->buckets = calloc(cache->bucket_count, sizeof(pykadmin_cache_node_t *));
+
+        if (!cache->buckets) {
+            free(cache);
+            cache = NULL;
+        }
+    }
+
+    return cache;
+}
+
+static pykadmin_cache_node_t **_pykadmin_cache_find(pykadmin_cache_t *cache, const char *name, size_t hash) {
+
+    pykadmin_cache_node_t **link = &cache->buckets[hash & (cache->bucket_count - 1)];
+
+    while (*link && (((*link)->hash != hash) || strcmp((*link)->name, name)))
+        link = &(*link)->chain;
+
+    return link;
+}
+
+static void _pykadmin_cache_unlink(pykadmin_cache_t *cache, pykadmin_cache_node_t *node) {
+
+    if (node->prev)
+        node->prev->next = node->next;
+    else
+        cache->head = node->next;
+
+    if (node->next)
+        node->next->prev = node->prev;
+    else
+        cache->tail = node->prev;
+
+    node->prev = node->next = NULL;
+}
+
+static void _pykadmin_cache_push_front(pykadmin_cache_t *cache, pykadmin_cache_node_t *node) {
+
+    node->prev = NULL;
+    node->next = cache->head;
+
+    if (cache->head)
+        cache->head->prev = node;
+    else
+        cache->tail = node;
+
+    cache->head = node;
+}
+
+static void _pykadmin_cache_remove(krb5_context context, pykadmin_cache_t *cache, pykadmin_cache_node_t *node) {
+
+    pykadmin_cache_node_t **link = _pykadmin_cache_find(cache, node->name, node->hash);
+
+    *link = node->chain;
+
+    _pykadmin_cache_unlink(cache, node);
+
+    pykadmin_free_kadm_ent_rec(context, &node->entry);
+    free(node->name);
+    free(node);
+
+    cache->count--;
+}
+
+static char *_pykadmin_cache_key(krb5_context context, krb5_const_principal principal) {
+
+    char *unparsed = NULL;
+    char *name     = NULL;
+
+    if (principal && !krb5_unparse_name(context, principal, &unparsed)) {
+        name = strdup(unparsed);
+        krb5_free_unparsed_name(context, unparsed);
+    }
+
+    return name;
+}
+
+void pykadmin_cache_clear(krb5_context context, pykadmin_cache_t *cache) {
+
+    if (cache) {
+        while (cache->head)
+            _pykadmin_cache_remove(context, cache, cache->head);
+    }
+}
+
+void pykadmin_cache_destroy(krb5_context context, pykadmin_cache_t *cache) {
+
+    if (cache) {
+        pykadmin_cache_clear(context, cache);
+        free(cache->buckets);
+        free(cache);
+    }
+}
+
+int pykadmin_cache_get(krb5_context context, pykadmin_cache_t *cache, krb5_const_principal principal, kadm5_principal_ent_rec *entry) {
+
+    pykadmin_cache_node_t *node = NULL;
+    char *name  = NULL;
+    size_t hash = 0;
+    int hit     = 0;
+
+    if (!cache || !(name = _pykadmin_cache_key(context, principal)))
+        return 0;
+
+    hash = pykadmin_string_hash(name);
+    node = *_pykadmin_cache_find(cache, name, hash);
+
+    if (node && (node->expires <= pykadmin_monotonic())) {
+        _pykadmin_cache_remove(context, cache, node);
+        node = NULL;
+    }
+
+    if (node && !pykadmin_copy_kadm_ent_rec(context, &node->entry, entry)) {
+
+        _pykadmin_cache_unlink(cache, node);
+        _pykadmin_cache_push_front(cache, node);
+
+        hit = 1;
+    }
+
+    if (hit)
+        cache->hits++;
+    else
+        cache->misses++;
+
+    free(name);
+
+    return hit;
+}
+
+krb5_error_code pykadmin_cache_put(krb5_context context, pykadmin_cache_t *cache, kadm5_principal_ent_rec *entry) {
+
+    krb5_error_code retval = 0;
+    pykadmin_cache_node_t *node = NULL;
+    pykadmin_cache_node_t **link = NULL;
+
+    if (!cache || !cache->max_entries)
+        return 0;
+
+    node = calloc(1, sizeof(pykadmin_cache_node_t));
+    if (!node)
+        return ENOMEM;
+
+    node->name = _pykadmin_cache_key(context, entry->principal);
+    if (!node->name) {
+        free(node);
+        return ENOMEM;
+    }
+
+    if ((retval = pykadmin_copy_kadm_ent_rec(context, entry, &node->entry))) {
+        free(node->name);
+        free(node);
+        return retval;
+    }
+
+    node->hash    = pykadmin_string_hash(node->name);
+    node->expires = pykadmin_monotonic() + cache->ttl;
+
+    // replace any older copy
+    if (*(link = _pykadmin_cache_find(cache, node->name, node->hash)))
+        _pykadmin_cache_remove(context, cache, *link);
+
+    while (cache->count >= cache->max_entries) {
+        _pykadmin_cache_remove(context, cache, cache->tail);
+        cache->evictions++;
+    }
+
+    link  = _pykadmin_cache_find(cache, node->name, node->hash);
+    *link = node;
+
+    _pykadmin_cache_push_front(cache, node);
+    cache->count++;
+
+    return 0;
+}
+
+void pykadmin_cache_invalidate(krb5_context context, pykadmin_cache_t *cache, krb5_const_principal principal) {
+
+    pykadmin_cache_node_t *node = NULL;
+    char *name = NULL;
+    size_t hash = 0;
+
+    if (!cache || !(name = _pykadmin_cache_key(context, principal)))
+        return;
+
+    hash = pykadmin_string_hash(name);
+    node = *_pykadmin_cache_find(cache, name, hash);
+
+    if (node) {
+        _pykadmin_cache_remove(context, cache, node);
+        cache->invalidations++;
+    }
+
+    free(name);
+}
+
+void pykadmin_cache_stats(pykadmin_cache_t *cache, pykadmin_cache_stats_t *stats) {
+
+    memset(stats, 0, sizeof(pykadmin_cache_stats_t));
+
+    if (cache) {
+        stats->entries       = cache->count;
+        stats->max_entries   = cache->max_entries;
+        stats->ttl           = cache->ttl;
+        stats->hits          = cache->hits;
+        stats->misses        = cache->misses;
+        stats->evictions     = cache->evictions;
+        stats->invalidations = cache->invalidations;
+    }
+}
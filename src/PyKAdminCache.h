@@ -0,0 +1,42 @@
+
+#ifndef PYKADMINCACHE_H
+#define PYKADMINCACHE_H
+
+#include <kadm5/admin.h>
+#include <krb5/krb5.h>
+#include <stddef.h>
+
+/*
+    per-handle LRU cache of kadm5 principal entries for getprinc.
+
+    entries are deep copies keyed by the unparsed (canonical) form of the parsed principal
+    and expire after ttl seconds. writes made through the owning handle invalidate the
+    affected principal; writes from elsewhere are only bounded by the ttl.
+*/
+
+typedef struct _pykadmin_cache pykadmin_cache_t;
+
+typedef struct {
+    size_t entries;
+    size_t max_entries;
+    double ttl;
+
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long evictions;
+    unsigned long long invalidations;
+} pykadmin_cache_stats_t;
+
+pykadmin_cache_t *pykadmin_cache_create(size_t max_entries, double ttl);
+void pykadmin_cache_destroy(krb5_context context, pykadmin_cache_t *cache);
+
+/* 1 and a copy in entry on a fresh hit, 0 on a miss */
+int pykadmin_cache_get(krb5_context context, pykadmin_cache_t *cache, krb5_const_principal principal, kadm5_principal_ent_rec *entry);
+krb5_error_code pykadmin_cache_put(krb5_context context, pykadmin_cache_t *cache, kadm5_principal_ent_rec *entry);
+
+void pykadmin_cache_invalidate(krb5_context context, pykadmin_cache_t *cache, krb5_const_principal principal);
+void pykadmin_cache_clear(krb5_context context, pykadmin_cache_t *cache);
+
+void pykadmin_cache_stats(pykadmin_cache_t *cache, pykadmin_cache_stats_t *stats);
+
+#endif
@@ -0,0 +1,684 @@
+
+#include "PyKAdminCommitQueue.h"
+#include "PyKAdminErrors.h"
+#include "PyKAdminCommon.h"
+#include "PyKAdminCache.h"
+
+#include <errno.h>
+#include <time.h>
+
+// fields a later commit can simply overwrite; anything else (tl_data, ...) is written at once
+#define kCOMMIT_QUEUE_MERGEABLE (KADM5_PRINC_EXPIRE_TIME | KADM5_PW_EXPIRATION | KADM5_ATTRIBUTES \
+                                | KADM5_MAX_LIFE | KADM5_MAX_RLIFE | KADM5_KVNO | KADM5_POLICY   \
+                                | KADM5_POLICY_CLR | KADM5_FAIL_AUTH_COUNT)
+
+#define kCOMMIT_QUEUE_MIN_INDEX 16
+
+// every live queue, so the exit hook can write them out; guarded by the GIL
+static pykadmin_commit_queue_t *pykadmin_commit_queues = NULL;
+static int pykadmin_commit_queue_exiting = 0;
+
+
+static void _pykadmin_commit_item_free(krb5_context context, pykadmin_commit_item_t *item) {
+
+    if (item->entry.principal)
+        krb5_free_principal(context, item->entry.principal);
+
+    free(item->entry.policy);
+    free(item->name);
+
+    memset(item, 0, sizeof(pykadmin_commit_item_t));
+}
+
+// the index slot holding name, or the empty slot it would go in
+static size_t _pykadmin_commit_queue_slot(pykadmin_commit_queue_t *queue, const char *name) {
+
+    size_t mask = queue->index_size - 1;
+    size_t slot = pykadmin_string_hash(name) & mask;
+
+    while (queue->index[slot] && strcmp(queue->items[queue->index[slot] - 1].name, name))
+        slot = (slot + 1) & mask;
+
+    return slot;
+}
+
+// re-insert every item; the table never shrinks, so this can't fail
+static void _pykadmin_commit_queue_reindex(pykadmin_commit_queue_t *queue) {
+
+    size_t index = 0;
+
+    memset(queue->index, 0, queue->index_size * sizeof(size_t));
+
+    for (index = 0; index < queue->count; index++)
+        queue->index[_pykadmin_commit_queue_slot(queue, queue->items[index].name)] = index + 1;
+}
+
+// room for one more item, keeping the index at most half full
+static int _pykadmin_commit_queue_reserve(pykadmin_commit_queue_t *queue) {
+
+    pykadmin_commit_item_t *items = NULL;
+    size_t *index = NULL;
+    size_t capacity = 0;
+    size_t size = 0;
+
+    if (queue->count == queue->capacity) {
+
+        capacity = queue->capacity ? queue->capacity * 2 : kCOMMIT_QUEUE_MIN_INDEX / 2;
+
+        items = realloc(queue->items, capacity * sizeof(pykadmin_commit_item_t));
+        if (!items)
+            return -1;
+
+        queue->items    = items;
+        queue->capacity = capacity;
+    }
+
+    if ((queue->count + 1) * 2 > queue->index_size) {
+
+        size = queue->index_size * 2;
+
+        index = calloc(size, sizeof(size_t));
+        if (!index)
+            return -1;
+
+        free(queue->index);
+        queue->index      = index;
+        queue->index_size = size;
+
+        _pykadmin_commit_queue_reindex(queue);
+    }
+
+    return 0;
+}
+
+// take items [0, count) out of the queue into batch, keeping the rest in order
+static void _pykadmin_commit_queue_detach(pykadmin_commit_queue_t *queue, size_t count, pykadmin_commit_item_t *batch) {
+
+    memcpy(batch, queue->items, count * sizeof(pykadmin_commit_item_t));
+    memmove(queue->items, queue->items + count, (queue->count - count) * sizeof(pykadmin_commit_item_t));
+    queue->count -= count;
+
+    _pykadmin_commit_queue_reindex(queue);
+
+    pthread_mutex_lock(&queue->mutex);
+    queue->oldest = queue->count ? queue->items[0].queued : 0;
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+// take the item at position out of the queue into item
+static void _pykadmin_commit_queue_remove(pykadmin_commit_queue_t *queue, size_t position, pykadmin_commit_item_t *item) {
+
+    *item = queue->items[position];
+
+    memmove(queue->items + position, queue->items + position + 1, (queue->count - position - 1) * sizeof(pykadmin_commit_item_t));
+    queue->count--;
+
+    _pykadmin_commit_queue_reindex(queue);
+
+    pthread_mutex_lock(&queue->mutex);
+    queue->oldest = queue->count ? queue->items[0].queued : 0;
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+/*
+    in a forked child the items are the parent's to write and the thread, locks and
+    failures belong to the parent's process; start over empty.
+*/
+static void _pykadmin_commit_queue_after_fork(pykadmin_commit_queue_t *queue) {
+
+    size_t index = 0;
+
+    if (queue->generation == pykadmin_fork_generation)
+        return;
+
+    for (index = 0; index < queue->count; index++)
+        _pykadmin_commit_item_free(queue->kadmin->context, &queue->items[index]);
+
+    queue->count = 0;
+    _pykadmin_commit_queue_reindex(queue);
+
+    // the parent's thread may have held these at the fork
+    queue->flush_lock = PyThread_allocate_lock();
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->changed, NULL);
+
+    queue->oldest   = 0;
+    queue->started  = 0;
+    queue->stopping = 0;
+
+    if (queue->failures)
+        PyDict_Clear(queue->failures);
+
+    queue->generation = pykadmin_fork_generation;
+}
+
+static void _pykadmin_commit_queue_lock(pykadmin_commit_queue_t *queue) {
+
+    // a batch holding the lock needs the GIL to finish
+    if (!PyThread_acquire_lock(queue->flush_lock, NOWAIT_LOCK)) {
+        Py_BEGIN_ALLOW_THREADS
+        PyThread_acquire_lock(queue->flush_lock, WAIT_LOCK);
+        Py_END_ALLOW_THREADS
+    }
+}
+
+// modify the principal with the item's fields. GIL and flush_lock held.
+static kadm5_ret_t _pykadmin_commit_queue_write(pykadmin_commit_queue_t *queue, pykadmin_commit_item_t *item) {
+
+    PyKAdminObject *kadmin = queue->kadmin;
+    kadm5_ret_t retval = KADM5_OK;
+
+    PyKAdmin_WRITE(kadmin, retval, item->entry.principal, kadm5_modify_principal(kadmin->server_handle, &item->entry, item->mask));
+
+    pykadmin_cache_invalidate(kadmin->context, kadmin->cache, item->entry.principal);
+
+    queue->writes++;
+    if (retval != KADM5_OK)
+        queue->errors++;
+
+    return retval;
+}
+
+// results[name] = True, or the exception kadm5_modify_principal raises for retval
+static int _pykadmin_commit_queue_record(PyObject *results, const char *name, kadm5_ret_t retval) {
+
+    PyObject *type  = NULL;
+    PyObject *value = NULL;
+    PyObject *trace = NULL;
+    int result = 0;
+
+    if (retval == KADM5_OK)
+        return PyDict_SetItemString(results, name, Py_True);
+
+    PyKAdminError_raise_error(retval, "kadm5_modify_principal");
+
+    PyErr_Fetch(&type, &value, &trace);
+    PyErr_NormalizeException(&type, &value, &trace);
+
+    result = value ? PyDict_SetItemString(results, name, value) : -1;
+
+    Py_XDECREF(type);
+    Py_XDECREF(value);
+    Py_XDECREF(trace);
+
+    return result;
+}
+
+/*
+    write the items first queued at or before cutoff (all of them when cutoff < 0) and
+    record each result in results (a dict; failures only when only_failures). every
+    item is written even when recording fails. -1 with an exception set.
+*/
+static int _pykadmin_commit_queue_write_due(pykadmin_commit_queue_t *queue, double cutoff, PyObject *results, int only_failures) {
+
+    pykadmin_commit_item_t *batch = NULL;
+    kadm5_ret_t retval = KADM5_OK;
+    PyObject *type  = NULL;
+    PyObject *value = NULL;
+    PyObject *trace = NULL;
+    size_t count = 0;
+    size_t index = 0;
+    int result = 0;
+
+    _pykadmin_commit_queue_lock(queue);
+
+    while (count < queue->count && (cutoff < 0 || queue->items[count].queued <= cutoff))
+        count++;
+
+    if (!count)
+        goto cleanup;
+
+    batch = malloc(count * sizeof(pykadmin_commit_item_t));
+    if (!batch) {
+        PyErr_NoMemory();
+        result = -1;
+        goto cleanup;
+    }
+
+    // out of the queue first: commits made while a write has the GIL released start new items
+    _pykadmin_commit_queue_detach(queue, count, batch);
+
+    for (index = 0; index < count; index++) {
+
+        retval = _pykadmin_commit_queue_write(queue, &batch[index]);
+
+        if (results && !result && (retval != KADM5_OK || !only_failures)) {
+            result = _pykadmin_commit_queue_record(results, batch[index].name, retval);
+            // held back until the rest are written
+            if (result)
+                PyErr_Fetch(&type, &value, &trace);
+        }
+
+        // a write may have logged the handle in again with a new context
+        _pykadmin_commit_item_free(queue->kadmin->context, &batch[index]);
+    }
+
+cleanup:
+
+    PyThread_release_lock(queue->flush_lock);
+    free(batch);
+
+    if (type)
+        PyErr_Restore(type, value, trace);
+
+    return result;
+}
+
+static void *_pykadmin_commit_queue_main(void *data) {
+
+    pykadmin_commit_queue_t *queue = data;
+    PyGILState_STATE gil;
+    struct timespec until;
+    double wait = 0;
+
+    pthread_mutex_lock(&queue->mutex);
+
+    while (!queue->stopping) {
+
+        if (!queue->oldest || queue->delay <= 0) {
+            pthread_cond_wait(&queue->changed, &queue->mutex);
+            continue;
+        }
+
+        wait = queue->oldest + queue->delay - pykadmin_monotonic();
+
+        if (wait > 0) {
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_sec  += (time_t)wait;
+            until.tv_nsec += (long)((wait - (time_t)wait) * 1e9);
+            if (until.tv_nsec >= 1000000000L) {
+                until.tv_sec++;
+                until.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&queue->changed, &queue->mutex, &until);
+            continue;
+        }
+
+        pthread_mutex_unlock(&queue->mutex);
+
+        gil = PyGILState_Ensure();
+
+        // destroy sets stopping with the GIL held, and writes what is left itself
+        if (!queue->stopping && _pykadmin_commit_queue_write_due(queue, pykadmin_monotonic() - queue->delay, queue->failures, 1))
+            PyErr_Clear();
+
+        PyGILState_Release(gil);
+
+        pthread_mutex_lock(&queue->mutex);
+    }
+
+    pthread_mutex_unlock(&queue->mutex);
+
+    return NULL;
+}
+
+static int _pykadmin_commit_queue_start(pykadmin_commit_queue_t *queue) {
+
+    if (queue->started || queue->delay <= 0 || pykadmin_commit_queue_exiting)
+        return 0;
+
+#   if PY_VERSION_HEX < 0x03070000
+    PyEval_InitThreads();
+#   endif
+
+    errno = pthread_create(&queue->thread, NULL, _pykadmin_commit_queue_main, queue);
+    if (errno) {
+        PyErr_SetFromErrno(PyExc_OSError);
+        return -1;
+    }
+
+    queue->started = 1;
+
+    return 0;
+}
+
+static void _pykadmin_commit_queue_stop(pykadmin_commit_queue_t *queue) {
+
+    if (!queue->started)
+        return;
+
+    pthread_mutex_lock(&queue->mutex);
+    queue->stopping = 1;
+    pthread_cond_broadcast(&queue->changed);
+    pthread_mutex_unlock(&queue->mutex);
+
+    // without the GIL, so a batch the thread is writing can finish
+    Py_BEGIN_ALLOW_THREADS
+    pthread_join(queue->thread, NULL);
+    Py_END_ALLOW_THREADS
+
+    queue->started  = 0;
+    queue->stopping = 0;
+}
+
+// fold entry's mask fields into item; the later value wins
+static int _pykadmin_commit_item_merge(pykadmin_commit_item_t *item, kadm5_principal_ent_rec *entry, long mask) {
+
+    char *policy = NULL;
+
+    if (mask & KADM5_POLICY) {
+
+        policy = strdup(entry->policy);
+        if (!policy)
+            return -1;
+
+        free(item->entry.policy);
+        item->entry.policy = policy;
+        item->mask &= ~KADM5_POLICY_CLR;
+    }
+
+    if (mask & KADM5_POLICY_CLR) {
+        free(item->entry.policy);
+        item->entry.policy = NULL;
+        item->mask &= ~KADM5_POLICY;
+    }
+
+    if (mask & KADM5_PRINC_EXPIRE_TIME)
+        item->entry.princ_expire_time = entry->princ_expire_time;
+
+    if (mask & KADM5_PW_EXPIRATION)
+        item->entry.pw_expiration = entry->pw_expiration;
+
+    if (mask & KADM5_ATTRIBUTES)
+        item->entry.attributes = entry->attributes;
+
+    if (mask & KADM5_MAX_LIFE)
+        item->entry.max_life = entry->max_life;
+
+    if (mask & KADM5_MAX_RLIFE)
+        item->entry.max_renewable_life = entry->max_renewable_life;
+
+    if (mask & KADM5_KVNO)
+        item->entry.kvno = entry->kvno;
+
+    if (mask & KADM5_FAIL_AUTH_COUNT)
+        item->entry.fail_auth_count = entry->fail_auth_count;
+
+    item->mask |= mask;
+
+    return 0;
+}
+
+
+pykadmin_commit_queue_t *pykadmin_commit_queue_create(PyKAdminObject *kadmin, double delay, size_t max_pending) {
+
+    pykadmin_commit_queue_t *queue = calloc(1, sizeof(pykadmin_commit_queue_t));
+
+    if (!queue)
+        goto fail;
+
+    queue->index = calloc(kCOMMIT_QUEUE_MIN_INDEX, sizeof(size_t));
+    if (!queue->index)
+        goto fail;
+
+    queue->index_size = kCOMMIT_QUEUE_MIN_INDEX;
+
+    queue->failures = PyDict_New();
+    if (!queue->failures)
+        goto fail;
+
+    queue->flush_lock = PyThread_allocate_lock();
+    if (!queue->flush_lock)
+        goto fail;
+
+    pthread_mutex_init(&queue->mutex, NULL);
+    pthread_cond_init(&queue->changed, NULL);
+
+    queue->kadmin      = kadmin;
+    queue->delay       = delay;
+    queue->max_pending = max_pending;
+    queue->generation  = pykadmin_fork_generation;
+
+    queue->next = pykadmin_commit_queues;
+    pykadmin_commit_queues = queue;
+
+    return queue;
+
+fail:
+
+    if (queue) {
+        Py_XDECREF(queue->failures);
+        free(queue->index);
+        free(queue);
+    }
+
+    if (!PyErr_Occurred())
+        PyErr_NoMemory();
+
+    return NULL;
+}
+
+void pykadmin_commit_queue_configure(pykadmin_commit_queue_t *queue, double delay, size_t max_pending) {
+
+    pthread_mutex_lock(&queue->mutex);
+    queue->delay = delay;
+    pthread_cond_signal(&queue->changed);
+    pthread_mutex_unlock(&queue->mutex);
+
+    queue->max_pending = max_pending;
+}
+
+void pykadmin_commit_queue_destroy(pykadmin_commit_queue_t *queue) {
+
+    pykadmin_commit_queue_t **link = NULL;
+
+    if (!queue)
+        return;
+
+    _pykadmin_commit_queue_after_fork(queue);
+
+    for (link = &pykadmin_commit_queues; *link; link = &(*link)->next) {
+        if (*link == queue) {
+            *link = queue->next;
+            break;
+        }
+    }
+
+    _pykadmin_commit_queue_stop(queue);
+
+    // nobody is left to see the results
+    if (_pykadmin_commit_queue_write_due(queue, -1, NULL, 0))
+        PyErr_Clear();
+
+    pthread_cond_destroy(&queue->changed);
+    pthread_mutex_destroy(&queue->mutex);
+    PyThread_free_lock(queue->flush_lock);
+
+    Py_XDECREF(queue->failures);
+    free(queue->index);
+    free(queue->items);
+    free(queue);
+}
+
+int pykadmin_commit_queue_put(pykadmin_commit_queue_t *queue, kadm5_principal_ent_rec *entry, long mask) {
+
+    krb5_context context = queue->kadmin->context;
+    krb5_error_code code = 0;
+    kadm5_ret_t retval = KADM5_OK;
+    pykadmin_commit_item_t *item = NULL;
+    pykadmin_commit_item_t pending;
+    char *name = NULL;
+    size_t slot = 0;
+    int result = -1;
+
+    _pykadmin_commit_queue_after_fork(queue);
+
+    code = krb5_unparse_name(context, entry->principal, &name);
+    if (code) {
+        PyKAdminError_raise_error(code, "krb5_unparse_name");
+        goto cleanup;
+    }
+
+    slot = _pykadmin_commit_queue_slot(queue, name);
+
+    if ((mask & ~kCOMMIT_QUEUE_MERGEABLE) || pykadmin_commit_queue_exiting) {
+
+        /*
+            the caller's commit has to land after what is queued for the principal, and
+            after a batch being written that may hold it
+        */
+        _pykadmin_commit_queue_lock(queue);
+
+        slot = _pykadmin_commit_queue_slot(queue, name);
+
+        if (queue->index[slot]) {
+            _pykadmin_commit_queue_remove(queue, queue->index[slot] - 1, &pending);
+            retval = _pykadmin_commit_queue_write(queue, &pending);
+            _pykadmin_commit_item_free(queue->kadmin->context, &pending);
+        }
+
+        PyThread_release_lock(queue->flush_lock);
+
+        if (retval == KADM5_OK)
+            result = 0;
+        else
+            PyKAdminError_raise_error(retval, "kadm5_modify_principal");
+
+        goto cleanup;
+    }
+
+    if (queue->index[slot]) {
+        item = &queue->items[queue->index[slot] - 1];
+    } else {
+
+        if (_pykadmin_commit_queue_reserve(queue)) {
+            PyErr_NoMemory();
+            goto cleanup;
+        }
+
+        item = &queue->items[queue->count];
+        memset(item, 0, sizeof(pykadmin_commit_item_t));
+
+        code = krb5_copy_principal(context, entry->principal, &item->entry.principal);
+        if (code) {
+            PyKAdminError_raise_error(code, "krb5_copy_principal");
+            goto cleanup;
+        }
+
+        item->name   = name;
+        item->queued = pykadmin_monotonic();
+        name = NULL;
+
+        queue->index[_pykadmin_commit_queue_slot(queue, item->name)] = ++queue->count;
+
+        pthread_mutex_lock(&queue->mutex);
+        if (!queue->oldest)
+            queue->oldest = queue->items[0].queued;
+        pthread_cond_signal(&queue->changed);
+        pthread_mutex_unlock(&queue->mutex);
+    }
+
+    if (_pykadmin_commit_item_merge(item, entry, mask)) {
+        PyErr_NoMemory();
+        goto cleanup;
+    }
+
+    queue->commits++;
+    result = 1;
+
+    if (queue->max_pending && queue->count >= queue->max_pending) {
+        if (_pykadmin_commit_queue_write_due(queue, -1, queue->failures, 1))
+            result = -1;
+    } else if (_pykadmin_commit_queue_start(queue)) {
+        result = -1;
+    }
+
+cleanup:
+
+    if (name)
+        krb5_free_unparsed_name(queue->kadmin->context, name);
+
+    return result;
+}
+
+void pykadmin_commit_queue_drop(pykadmin_commit_queue_t *queue, krb5_const_principal princ) {
+
+    pykadmin_commit_item_t item;
+    char *name = NULL;
+    size_t slot = 0;
+
+    _pykadmin_commit_queue_after_fork(queue);
+
+    if (!queue->count || krb5_unparse_name(queue->kadmin->context, princ, &name))
+        return;
+
+    slot = _pykadmin_commit_queue_slot(queue, name);
+
+    if (queue->index[slot]) {
+        _pykadmin_commit_queue_remove(queue, queue->index[slot] - 1, &item);
+        _pykadmin_commit_item_free(queue->kadmin->context, &item);
+    }
+
+    krb5_free_unparsed_name(queue->kadmin->context, name);
+}
+
+PyObject *pykadmin_commit_queue_flush(pykadmin_commit_queue_t *queue) {
+
+    PyObject *results = NULL;
+
+    _pykadmin_commit_queue_after_fork(queue);
+
+    results = PyDict_New();
+    if (!results)
+        return NULL;
+
+    // background failures first: a later write of the same principal replaces its entry
+    if (PyDict_Update(results, queue->failures)) {
+        Py_DECREF(results);
+        return NULL;
+    }
+
+    PyDict_Clear(queue->failures);
+
+    if (_pykadmin_commit_queue_write_due(queue, -1, results, 0)) {
+        Py_DECREF(results);
+        return NULL;
+    }
+
+    return results;
+}
+
+
+static PyObject *_pykadmin_commit_queue_exit(PyObject *self, PyObject *unused) {
+
+    pykadmin_commit_queue_t *queue = NULL;
+
+    // commits from here on are written directly
+    pykadmin_commit_queue_exiting = 1;
+
+    for (queue = pykadmin_commit_queues; queue; queue = queue->next) {
+
+        _pykadmin_commit_queue_after_fork(queue);
+        _pykadmin_commit_queue_stop(queue);
+
+        if (_pykadmin_commit_queue_write_due(queue, -1, NULL, 0))
+            PyErr_Clear();
+    }
+
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef pykadmin_commit_queue_exit_def = {"_flush_write_behind", (PyCFunction)_pykadmin_commit_queue_exit, METH_NOARGS, ""};
+
+int pykadmin_commit_queue_init(PyObject *module) {
+
+    PyObject *atexit = NULL;
+    PyObject *flush  = NULL;
+    PyObject *result = NULL;
+
+    flush = PyCFunction_New(&pykadmin_commit_queue_exit_def, NULL);
+    if (!flush)
+        return -1;
+
+    atexit = PyImport_ImportModule("atexit");
+    if (atexit) {
+        result = PyObject_CallMethod(atexit, "register", "O", flush);
+        Py_DECREF(atexit);
+    }
+
+    Py_DECREF(flush);
+    Py_XDECREF(result);
+
+    return result ? 0 : -1;
+}
+
@@ -0,0 +1,98 @@
+
+#ifndef PYKADMINCOMMITQUEUE_H
+#define PYKADMINCOMMITQUEUE_H
+
+#include <Python.h>
+#include <kadm5/admin.h>
+#include <krb5/krb5.h>
+#include <pthread.h>
+
+#include "pykadmin.h"
+#include "PyKAdminObject.h"
+
+/*
+    write-behind for principal.commit() (kadm.enable_write_behind).
+
+    a commit queues the entry's changed fields under the principal's name instead of
+    calling kadm5_modify_principal. commits to a principal that is already queued merge
+    into its item (masks or'd, later values winning), so a burst of changes costs one
+    RPC. items are written in the order they were first queued: by a background thread
+    delay seconds after that, when max_pending principals are queued, or on kadm.flush().
+
+    reads still go to kadmind (or the caches) and see a queued change only once it is
+    written. the items and counters are guarded by the GIL; the mutex only hands the
+    thread its wake-ups, in the renewal thread's lock order (GIL, then mutex).
+*/
+
+typedef struct {
+    char *name;
+    kadm5_principal_ent_rec entry;  // principal, and the fields named by mask
+    long mask;
+    double queued;                  // pykadmin_monotonic() of the first commit
+} pykadmin_commit_item_t;
+
+struct _pykadmin_commit_queue {
+    PyKAdminObject *kadmin;         // borrowed: the handle owns the queue
+
+    pykadmin_commit_item_t *items;  // in the order first queued
+    size_t count;
+    size_t capacity;
+
+    size_t *index;                  // open addressing on the name: item + 1, 0 when empty
+    size_t index_size;
+
+    double delay;                   // seconds; 0 for no background writes
+    size_t max_pending;             // 0 for no limit
+
+    // one batch of writes at a time, so a principal's changes reach kadmind in order
+    PyThread_type_lock flush_lock;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+    double oldest;                  // queued time of items[0], 0 when empty; for the thread
+    pthread_t thread;
+    int started;
+    int stopping;
+
+    unsigned long generation;       // pykadmin_fork_generation the items were queued in
+
+    PyObject *failures;             // {name: exception} from background writes, until the next flush()
+
+    unsigned long commits;
+    unsigned long writes;
+    unsigned long errors;
+
+    struct _pykadmin_commit_queue *next;    // live queues, for the exit hook
+};
+
+typedef struct _pykadmin_commit_queue pykadmin_commit_queue_t;
+
+// NULL with an exception set
+pykadmin_commit_queue_t *pykadmin_commit_queue_create(PyKAdminObject *kadmin, double delay, size_t max_pending);
+
+// new settings; the thread (started by the next commit) picks up the delay
+void pykadmin_commit_queue_configure(pykadmin_commit_queue_t *queue, double delay, size_t max_pending);
+
+// writes what is queued (results dropped), stops the thread and frees the queue. GIL held.
+void pykadmin_commit_queue_destroy(pykadmin_commit_queue_t *queue);
+
+/*
+    queue a commit of entry's mask fields. returns 1 when queued, 0 when the mask has
+    changes that can't wait (tl_data, ...) and the caller should commit now; anything
+    queued for the principal was written first. -1 with an exception set.
+*/
+int pykadmin_commit_queue_put(pykadmin_commit_queue_t *queue, kadm5_principal_ent_rec *entry, long mask);
+
+// forget the queued changes to princ (it was deleted)
+void pykadmin_commit_queue_drop(pykadmin_commit_queue_t *queue, krb5_const_principal princ);
+
+/*
+    write everything queued now. returns {name: True or the exception} for those items
+    and for background writes that failed since the last flush. NULL with an exception set.
+*/
+PyObject *pykadmin_commit_queue_flush(pykadmin_commit_queue_t *queue);
+
+// stops every queue's thread after writing what is queued, before the interpreter finalizes
+int pykadmin_commit_queue_init(PyObject *module);
+
+#endif
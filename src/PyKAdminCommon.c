@@ -12,9 +12,24 @@ kadm5_get_principal(void *server_handle, krb5_principal principal,
 
 #include "PyKAdminCommon.h"
 #include <datetime.h>
+#include <time.h>
+#include <errno.h>
 
 #define TIME_NONE ((time_t) -1)
 
+/* FNV-1a, used by the C-side name tables */
+size_t pykadmin_string_hash(const char *string) {
+
+    size_t hash = (size_t)2166136261u;
+
+    while (*string) {
+        hash ^= (unsigned char)*string++;
+        hash *= (size_t)16777619u;
+    }
+
+    return hash;
+}
+
 char *PyUnicode_or_PyBytes_asCString(PyObject *in_str) {
 
     char *out_str = NULL;
@@ -24,17 +39,15 @@ char *PyUnicode_or_PyBytes_asCString(PyObject *in_str) {
         PyObject *ascii = PyUnicode_AsASCIIString(in_str);
 
         if (ascii) {
-            out_str = PyBytes_AsString(ascii);
+            out_str = strdup(PyBytes_AsString(ascii));
             Py_XDECREF(ascii);
         }
 
     } else if (PyBytes_CheckExact(in_str)) {
         
-        out_str = PyBytes_AsString(in_str);
+        out_str = strdup(PyBytes_AsString(in_str));
     }
 
-    out_str = strdup(out_str);
-
     return out_str;
 }
 
@@ -97,7 +110,8 @@ char *pykadmin_timestamp_as_deltastr(int seconds, const char *zero) {
 
 PyObject *pykadmin_pydatetime_from_timestamp(time_t timestamp) {
 
-    PyDateTime_IMPORT;
+    if (!PyDateTimeAPI)
+        PyDateTime_IMPORT;
 
     if (timestamp) {
         PyObject *datetime = NULL;
@@ -121,7 +135,8 @@ PyObject *pykadmin_pydatetime_from_timestamp(time_t timestamp) {
 
 int pykadmin_timestamp_from_pydatetime(PyObject *datetime) {
     
-    PyDateTime_IMPORT;
+    if (!PyDateTimeAPI)
+        PyDateTime_IMPORT;
 
     time_t timestamp = 0; 
     struct tm *timeinfo; 
@@ -150,7 +165,8 @@ int pykadmin_timestamp_from_pydatetime(PyObject *datetime) {
 
 int pykadmin_seconds_from_pydatetime(PyObject *delta) {
     
-    PyDateTime_IMPORT;
+    if (!PyDateTimeAPI)
+        PyDateTime_IMPORT;
 
     time_t seconds = 0; 
 
@@ -163,19 +179,34 @@ int pykadmin_seconds_from_pydatetime(PyObject *delta) {
 
 }
 
-int pykadmin_policy_exists(void *server_handle, const char *name) {
+double pykadmin_monotonic(void) {
+
+    struct timespec now;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &now))
+        return (double)time(NULL);
+
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1e9);
+}
+
+int pykadmin_policy_exists(PyKAdminObject *kadmin, const char *name) {
 
     kadm5_ret_t retval = KADM5_OK;
     kadm5_policy_ent_rec policy; 
 
-    retval = kadm5_get_policy(server_handle, (char *)name, &policy);
+    // answered from the policy table when enabled; a failed reload falls back to the rpc
+    if (kadmin->policies && (PyKAdminObject_load_policies(kadmin, 0) == KADM5_OK) && kadmin->policies)
+        return (pykadmin_policy_table_lookup(kadmin->policies, name) != NULL);
+
+    // reconnecting an inherited handle, pacing and failing over like any read
+    PyKAdmin_CALL(kadmin, retval, 1, kadm5_get_policy(kadmin->server_handle, (char *)name, &policy));
     if (retval == KADM5_OK) 
-        kadm5_free_policy_ent(server_handle, &policy);
+        kadm5_free_policy_ent(kadmin->server_handle, &policy);
 
     return (retval == KADM5_OK);
 }
 
-krb5_error_code pykadmin_unpack_xdr_osa_princ_ent_rec(PyKAdminObject *kadmin, krb5_db_entry *kdb, osa_princ_ent_rec *adb) {
+krb5_error_code pykadmin_unpack_xdr_osa_princ_ent_rec(krb5_context context, krb5_db_entry *kdb, osa_princ_ent_rec *adb) {
 
     krb5_error_code retval = 0; 
 
@@ -184,7 +215,7 @@ krb5_error_code pykadmin_unpack_xdr_osa_princ_ent_rec(PyKAdminObject *kadmin, kr
 
     tl_data.tl_data_type = KRB5_TL_KADM_DATA;
 
-    if ((retval = krb5_dbe_lookup_tl_data(kadmin->context, kdb, &tl_data)) || (tl_data.tl_data_length == 0)) {
+    if ((retval = krb5_dbe_lookup_tl_data(context, kdb, &tl_data)) || (tl_data.tl_data_length == 0)) {
         adb->admin_history_kvno = 0;
     }
 
@@ -265,6 +296,14 @@ static krb5_tl_data *dup_tl_data(krb5_tl_data *tl)
 }
 
 krb5_error_code pykadmin_kadm_from_kdb(PyKAdminObject *kadmin, krb5_db_entry *kdb, kadm5_principal_ent_rec *entry, long mask) {
+    return pykadmin_kadm_from_kdb_context(kadmin->context, kdb, entry, mask);
+}
+
+/* 
+    context-only form of pykadmin_kadm_from_kdb; safe to call without the GIL 
+    provided each thread brings its own krb5_context.
+*/
+krb5_error_code pykadmin_kadm_from_kdb_context(krb5_context context, krb5_db_entry *kdb, kadm5_principal_ent_rec *entry, long mask) {
 
     krb5_error_code retval = 0; 
     int i;
@@ -279,7 +318,7 @@ krb5_error_code pykadmin_kadm_from_kdb(PyKAdminObject *kadmin, krb5_db_entry *kd
     /* principal */
 
     if (mask & KADM5_PRINCIPAL) {
-        if ((retval = krb5_copy_principal(kadmin->context, kdb->princ, &entry->principal)))
+        if ((retval = krb5_copy_principal(context, kdb->princ, &entry->principal)))
             goto done;
     }
 
@@ -312,19 +351,19 @@ krb5_error_code pykadmin_kadm_from_kdb(PyKAdminObject *kadmin, krb5_db_entry *kd
     /* members with computed values */
 
     if (mask & KADM5_LAST_PWD_CHANGE) {
-        if ((retval = krb5_dbe_lookup_last_pwd_change(kadmin->context, kdb, &entry->last_pwd_change)))
+        if ((retval = krb5_dbe_lookup_last_pwd_change(context, kdb, &entry->last_pwd_change)))
             goto done; 
     }
 
     if ((mask & KADM5_MOD_NAME) || (mask & KADM5_MOD_TIME)) {
-        if ((retval = krb5_dbe_lookup_mod_princ_data(kadmin->context, kdb, &(entry->mod_date), &(entry->mod_name))))
+        if ((retval = krb5_dbe_lookup_mod_princ_data(context, kdb, &(entry->mod_date), &(entry->mod_name))))
             goto done;
 
         if (! (mask & KADM5_MOD_TIME))
             entry->mod_date = 0;
 
         if (! (mask & KADM5_MOD_NAME)) {
-            krb5_free_principal(kadmin->context, entry->mod_name);
+            krb5_free_principal(context, entry->mod_name);
             entry->mod_name = NULL;
         }
     }  
@@ -339,7 +378,7 @@ krb5_error_code pykadmin_kadm_from_kdb(PyKAdminObject *kadmin, krb5_db_entry *kd
     }
 
     if (mask & KADM5_MKVNO) {
-        if ((retval = krb5_dbe_lookup_mkvno(kadmin->context, kdb, &entry->mkvno)))
+        if ((retval = krb5_dbe_lookup_mkvno(context, kdb, &entry->mkvno)))
             goto done;
     }
     
@@ -380,7 +419,7 @@ krb5_error_code pykadmin_kadm_from_kdb(PyKAdminObject *kadmin, krb5_db_entry *kd
             entry->key_data = NULL;
 
             for (i = 0; i < entry->n_key_data; i++)
-                retval = krb5_copy_key_data_contents(kadmin->context, &kdb->key_data[i], &entry->key_data[i]);
+                retval = krb5_copy_key_data_contents(context, &kdb->key_data[i], &entry->key_data[i]);
         if (retval)
             goto done;
     }
@@ -397,7 +436,7 @@ krb5_error_code pykadmin_kadm_from_kdb(PyKAdminObject *kadmin, krb5_db_entry *kd
 
     */
 
-    if ((retval = pykadmin_unpack_xdr_osa_princ_ent_rec(kadmin, kdb, adb))) {
+    if ((retval = pykadmin_unpack_xdr_osa_princ_ent_rec(context, kdb, adb))) {
         goto done;
     }
 
@@ -418,7 +457,7 @@ krb5_error_code pykadmin_kadm_from_kdb(PyKAdminObject *kadmin, krb5_db_entry *kd
 
 done: 
     if (retval && entry->principal) {
-        krb5_free_principal(kadmin->context, entry->principal);
+        krb5_free_principal(context, entry->principal);
         entry->principal = NULL;
     }
     
@@ -427,6 +466,102 @@ done:
 }
 
 
+/* releases everything kadm5_principal_ent_rec points at without needing a server handle */
+void pykadmin_free_kadm_ent_rec(krb5_context context, kadm5_principal_ent_rec *entry) {
+
+    krb5_tl_data *tl   = NULL;
+    krb5_tl_data *next = NULL;
+    int i, j;
+
+    krb5_free_principal(context, entry->principal);
+    krb5_free_principal(context, entry->mod_name);
+    free(entry->policy);
+
+    for (i = 0; entry->key_data && (i < entry->n_key_data); i++) {
+        for (j = 0; j < 2; j++) {
+            if (entry->key_data[i].key_data_contents[j]) {
+                memset(entry->key_data[i].key_data_contents[j], 0, entry->key_data[i].key_data_length[j]);
+                free(entry->key_data[i].key_data_contents[j]);
+            }
+        }
+    }
+
+    free(entry->key_data);
+
+    for (tl = entry->tl_data; tl; tl = next) {
+        next = tl->tl_data_next;
+        free(tl->tl_data_contents);
+        free(tl);
+    }
+
+    memset(entry, 0, sizeof(kadm5_principal_ent_rec));
+}
+
+/* deep copy of src into dst; on failure dst is left empty */
+krb5_error_code pykadmin_copy_kadm_ent_rec(krb5_context context, kadm5_principal_ent_rec *src, kadm5_principal_ent_rec *dst) {
+
+    krb5_error_code retval = 0;
+    krb5_tl_data *tl       = NULL;
+    krb5_tl_data **tail    = NULL;
+    int i;
+
+    memcpy(dst, src, sizeof(kadm5_principal_ent_rec));
+
+    dst->principal = NULL;
+    dst->mod_name  = NULL;
+    dst->policy    = NULL;
+    dst->key_data  = NULL;
+    dst->tl_data   = NULL;
+    dst->n_key_data = 0;
+    dst->n_tl_data  = 0;
+
+    if (src->principal && (retval = krb5_copy_principal(context, src->principal, &dst->principal)))
+        goto done;
+
+    if (src->mod_name && (retval = krb5_copy_principal(context, src->mod_name, &dst->mod_name)))
+        goto done;
+
+    if (src->policy && !(dst->policy = strdup(src->policy))) {
+        retval = ENOMEM;
+        goto done;
+    }
+
+    if (src->n_key_data && src->key_data) {
+
+        dst->key_data = calloc(src->n_key_data, sizeof(krb5_key_data));
+        if (!dst->key_data) {
+            retval = ENOMEM;
+            goto done;
+        }
+
+        for (i = 0; i < src->n_key_data; i++) {
+            if ((retval = krb5_copy_key_data_contents(context, &src->key_data[i], &dst->key_data[i])))
+                goto done;
+            dst->n_key_data++;
+        }
+    }
+
+    tail = &dst->tl_data;
+
+    for (tl = src->tl_data; tl; tl = tl->tl_data_next) {
+
+        if (!(*tail = dup_tl_data(tl))) {
+            retval = ENOMEM;
+            goto done;
+        }
+
+        tail = &(*tail)->tl_data_next;
+        dst->n_tl_data++;
+    }
+
+done:
+    if (retval)
+        pykadmin_free_kadm_ent_rec(context, dst);
+
+    return retval;
+}
+
+
 
 /*
 typedef struct _kadm5_policy_ent_t {
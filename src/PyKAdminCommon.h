@@ -24,18 +24,23 @@
 
 char *PyUnicode_or_PyBytes_asCString(PyObject *in_str);
 
-int pykadmin_policy_exists(void *server_handle, const char *name);
+size_t pykadmin_string_hash(const char *string);
+
+int pykadmin_policy_exists(PyKAdminObject *kadmin, const char *name);
 
 PyObject *pykadmin_pydatetime_from_timestamp(time_t timestamp);
 int pykadmin_timestamp_from_pydatetime(PyObject *datetime);
 
 int pykadmin_seconds_from_pydatetime(PyObject *delta);
 
+double pykadmin_monotonic(void);
+
 
 char *pykadmin_timestamp_as_isodate(time_t timestamp, const char *zero);
 char *pykadmin_timestamp_as_deltastr(int seconds, const char *zero);
 
 krb5_error_code pykadmin_kadm_from_kdb(PyKAdminObject *kadmin, krb5_db_entry *kdb, kadm5_principal_ent_rec *entry, long mask); 
+krb5_error_code pykadmin_kadm_from_kdb_context(krb5_context context, krb5_db_entry *kdb, kadm5_principal_ent_rec *entry, long mask);
 
 krb5_error_code pykadmin_policy_kadm_from_osa(krb5_context ctx, osa_policy_ent_rec *osa, kadm5_policy_ent_rec *entry, long mask); 
 
@@ -60,8 +65,8 @@ void pykadmin_free_db_args(char **db_args);
 
 
 
-// TODO
-//krb5_error_code pykadmin_copy_kadm_ent_rec(PyKAdminObject *kadmin, kadm5_principal_ent_rec *src, kadm5_principal_ent_rec *dst);
+krb5_error_code pykadmin_copy_kadm_ent_rec(krb5_context context, kadm5_principal_ent_rec *src, kadm5_principal_ent_rec *dst);
+void pykadmin_free_kadm_ent_rec(krb5_context context, kadm5_principal_ent_rec *entry);
 
 
 #endif
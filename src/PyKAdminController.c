@@ -0,0 +1,351 @@
+
+#include "PyKAdminController.h"
+#include "PyKAdminCommon.h"
+
+#include <kadm5/kadm_err.h>
+#include <math.h>
+#include <time.h>
+
+#define kCONTROLLER_LATENCY_WEIGHT 0.2
+#define kCONTROLLER_ERROR_WEIGHT   0.1
+
+static int _pykadmin_controller_transient(kadm5_ret_t retval) {
+    return (retval == KADM5_RPC_ERROR) || (retval == KADM5_GSS_ERROR);
+}
+
+/* seconds until a token is available, taking it when there is one now */
+static double _pykadmin_controller_take_token(PyKAdminController *self, double now) {
+
+    if (self->rate <= 0)
+        return 0;
+
+    // a burst of at most one second's worth
+    self->tokens += (now - self->refilled) * self->rate;
+    if (self->tokens > self->rate)
+        self->tokens = self->rate;
+    self->refilled = now;
+
+    if (self->tokens >= 1) {
+        self->tokens -= 1;
+        return 0;
+    }
+
+    return (1 - self->tokens) / self->rate;
+}
+
+/* the condition waits on the monotonic clock, so a change of wall-clock time does not move deadlines */
+static void _pykadmin_controller_cond_init(PyKAdminController *self) {
+
+    pthread_condattr_t attributes;
+
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&self->changed, &attributes);
+    pthread_condattr_destroy(&attributes);
+}
+
+static void _pykadmin_controller_timedwait(PyKAdminController *self, double seconds) {
+
+    struct timespec until;
+    double whole = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &until);
+
+    seconds += (double)until.tv_nsec / 1e9;
+    seconds  = modf(seconds, &whole);
+
+    until.tv_sec  += (time_t)whole;
+    until.tv_nsec  = (long)(seconds * 1e9);
+
+    pthread_cond_timedwait(&self->changed, &self->mutex, &until);
+}
+
+/*
+    in a forked child only the forking thread is left: a mutex another thread held stays
+    held, and calls it had in flight never finish. called with the GIL held.
+*/
+static void _pykadmin_controller_after_fork(PyKAdminController *self) {
+
+    if (self->generation == pykadmin_fork_generation)
+        return;
+
+    pthread_mutex_init(&self->mutex, NULL);
+    _pykadmin_controller_cond_init(self);
+
+    self->in_flight  = 0;
+    self->generation = pykadmin_fork_generation;
+}
+
+double pykadmin_controller_enter(PyKAdminController *self) {
+
+    double wait = 0;
+    int throttled = 0;
+
+    _pykadmin_controller_after_fork(self);
+
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&self->mutex);
+
+    for (;;) {
+
+        if (self->in_flight >= (long)self->window) {
+            pthread_cond_wait(&self->changed, &self->mutex);
+            continue;
+        }
+
+        wait = _pykadmin_controller_take_token(self, pykadmin_monotonic());
+        if (wait <= 0)
+            break;
+
+        throttled = 1;
+        _pykadmin_controller_timedwait(self, wait);
+    }
+
+    self->in_flight++;
+    self->throttled += throttled;
+
+    pthread_mutex_unlock(&self->mutex);
+    Py_END_ALLOW_THREADS
+
+    return pykadmin_monotonic();
+}
+
+void pykadmin_controller_exit(PyKAdminController *self, double started, kadm5_ret_t retval) {
+
+    double now     = pykadmin_monotonic();
+    double elapsed = now - started;
+    int failed     = _pykadmin_controller_transient(retval);
+    int congested  = failed;
+
+    pthread_mutex_lock(&self->mutex);
+
+    self->in_flight--;
+    self->calls++;
+    self->errors += failed;
+
+    self->latency    += kCONTROLLER_LATENCY_WEIGHT * (elapsed - self->latency);
+    self->error_rate += kCONTROLLER_ERROR_WEIGHT * ((double)failed - self->error_rate);
+
+    if ((self->latency_target > 0) && (elapsed > self->latency_target))
+        congested = 1;
+
+    if (!congested) {
+        // additive increase: about one more slot per window of successes
+        self->window += 1.0 / self->window;
+        if (self->window > self->max_concurrency)
+            self->window = self->max_concurrency;
+    } else if (started >= self->last_decrease) {
+        // multiplicative decrease, once for all calls that were already in flight
+        self->window /= 2;
+        if (self->window < 1)
+            self->window = 1;
+        self->last_decrease = now;
+    }
+
+    pthread_cond_broadcast(&self->changed);
+    pthread_mutex_unlock(&self->mutex);
+}
+
+int pykadmin_controller_retry(PyKAdminController *self, kadm5_ret_t retval, int attempt) {
+
+    struct timespec pause;
+    double delay = 0;
+
+    if (!_pykadmin_controller_transient(retval) || (attempt >= self->retries))
+        return 0;
+
+    pthread_mutex_lock(&self->mutex);
+
+    // "full jitter": uniform in [0, min(max_backoff, backoff * 2^attempt))
+    delay = self->backoff * (double)(1u << (attempt < 16 ? attempt : 16));
+    if (delay > self->max_backoff)
+        delay = self->max_backoff;
+    delay *= (double)rand_r(&self->seed) / ((double)RAND_MAX + 1);
+
+    self->retried++;
+
+    pthread_mutex_unlock(&self->mutex);
+
+    pause.tv_sec  = (time_t)delay;
+    pause.tv_nsec = (long)((delay - (double)pause.tv_sec) * 1e9);
+
+    Py_BEGIN_ALLOW_THREADS
+    nanosleep(&pause, NULL);
+    Py_END_ALLOW_THREADS
+
+    return 1;
+}
+
+
+static void PyKAdminController_dealloc(PyKAdminController *self) {
+
+    pthread_cond_destroy(&self->changed);
+    pthread_mutex_destroy(&self->mutex);
+
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *PyKAdminController_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+
+    PyKAdminController *self = (PyKAdminController *)type->tp_alloc(type, 0);
+
+    if (self) {
+        pthread_mutex_init(&self->mutex, NULL);
+        _pykadmin_controller_cond_init(self);
+
+        self->generation = pykadmin_fork_generation;
+
+        // usable (if cautious) even when __init__ is skipped
+        self->window = self->max_concurrency = 1;
+    }
+
+    return (PyObject *)self;
+}
+
+static int PyKAdminController_init(PyKAdminController *self, PyObject *args, PyObject *kwds) {
+
+    static char *kwlist[] = {"max_concurrency", "rate", "retries", "backoff", "max_backoff", "latency_target", NULL};
+
+    int max_concurrency   = 16;
+    double rate           = 0;
+    int retries           = 3;
+    double backoff        = 0.05;
+    double max_backoff    = 2.0;
+    double latency_target = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|ididdd", kwlist, 
+            &max_concurrency, &rate, &retries, &backoff, &max_backoff, &latency_target))
+        return -1;
+
+    if ((max_concurrency < 1) || (rate < 0) || (retries < 0) || (backoff < 0) || (max_backoff < 0) || (latency_target < 0)) {
+        PyErr_SetString(PyExc_ValueError, "max_concurrency must be at least 1 and the other arguments not negative");
+        return -1;
+    }
+
+    _pykadmin_controller_after_fork(self);
+
+    pthread_mutex_lock(&self->mutex);
+
+    self->max_concurrency = max_concurrency;
+    self->window          = (max_concurrency < 4) ? max_concurrency : 4;
+    self->rate            = rate;
+    self->tokens          = (rate > 0) ? 1 : 0;
+    self->refilled        = pykadmin_monotonic();
+    self->retries         = retries;
+    self->backoff         = backoff;
+    self->max_backoff     = max_backoff;
+    self->latency_target  = latency_target;
+    self->seed            = (unsigned int)time(NULL) ^ (unsigned int)(uintptr_t)self;
+
+    pthread_mutex_unlock(&self->mutex);
+
+    return 0;
+}
+
+static PyObject *PyKAdminController_stats(PyKAdminController *self) {
+
+    PyObject *stats = NULL;
+
+    _pykadmin_controller_after_fork(self);
+
+    pthread_mutex_lock(&self->mutex);
+
+    stats = Py_BuildValue("{s:d,s:l,s:d,s:d,s:K,s:K,s:K,s:K}",
+                "window",     self->window,
+                "in_flight",  self->in_flight,
+                "latency",    self->latency,
+                "error_rate", self->error_rate,
+                "calls",      self->calls,
+                "errors",     self->errors,
+                "retried",    self->retried,
+                "throttled",  self->throttled);
+
+    pthread_mutex_unlock(&self->mutex);
+
+    return stats;
+}
+
+static PyObject *PyKAdminController_get_rate(PyKAdminController *self, void *closure) {
+    return PyFloat_FromDouble(self->rate);
+}
+
+static int PyKAdminController_set_rate(PyKAdminController *self, PyObject *value, void *closure) {
+
+    double rate = value ? PyFloat_AsDouble(value) : -1;
+
+    if (PyErr_Occurred())
+        return -1;
+
+    if (rate < 0) {
+        PyErr_SetString(PyExc_ValueError, "rate must be a number of calls per second >= 0");
+        return -1;
+    }
+
+    _pykadmin_controller_after_fork(self);
+
+    pthread_mutex_lock(&self->mutex);
+    self->rate = rate;
+    pthread_cond_broadcast(&self->changed);
+    pthread_mutex_unlock(&self->mutex);
+
+    return 0;
+}
+
+static PyMethodDef PyKAdminController_methods[] = {
+    {"stats", (PyCFunction)PyKAdminController_stats, METH_NOARGS, "stats()\n\tCurrent window, in-flight calls, averages and counters."},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyMemberDef PyKAdminController_members[] = {
+    {"window",          T_DOUBLE, offsetof(PyKAdminController, window),          READONLY, "in-flight calls currently allowed"},
+    {"max_concurrency", T_DOUBLE, offsetof(PyKAdminController, max_concurrency), READONLY, "upper bound of the window"},
+    {"latency",         T_DOUBLE, offsetof(PyKAdminController, latency),         READONLY, "moving average of call latency, seconds"},
+    {"error_rate",      T_DOUBLE, offsetof(PyKAdminController, error_rate),      READONLY, "moving average of transient failures"},
+    {NULL}
+};
+
+static PyGetSetDef PyKAdminController_getters_setters[] = {
+    {"rate", (getter)PyKAdminController_get_rate, (setter)PyKAdminController_set_rate, "calls per second, 0 for no cap", NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+PyTypeObject PyKAdminController_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "kadmin.Controller",             /*tp_name*/
+    sizeof(PyKAdminController),             /*tp_basicsize*/
+    0,                         /*tp_itemsize*/
+    (destructor)PyKAdminController_dealloc, /*tp_dealloc*/
+    0,                         /*tp_print*/
+    0,                         /*tp_getattr*/
+    0,                         /*tp_setattr*/
+    0,                         /*tp_compare*/
+    0,                         /*tp_repr*/
+    0,                         /*tp_as_number*/
+    0,                         /*tp_as_sequence*/
+    0,                         /*tp_as_mapping*/
+    0,                         /*tp_hash */
+    0,                         /*tp_call*/
+    0,                         /*tp_str*/
+    0,                         /*tp_getattro*/
+    0,                         /*tp_setattro*/
+    0,                         /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT,        /*tp_flags*/
+    "Adaptive concurrency, rate and retry control for kadm5 calls",           /* tp_doc */
+    0,                     /* tp_traverse */
+    0,                     /* tp_clear */
+    0,                     /* tp_richcompare */
+    0,                     /* tp_weaklistoffset */
+    0,                     /* tp_iter */
+    0,                     /* tp_iternext */
+    PyKAdminController_methods,             /* tp_methods */
+    PyKAdminController_members,             /* tp_members */
+    PyKAdminController_getters_setters,     /* tp_getset */
+    0,                         /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc)PyKAdminController_init,      /* tp_init */
+    0,                         /* tp_alloc */
+    PyKAdminController_new,                 /* tp_new */
+};
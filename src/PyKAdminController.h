@@ -0,0 +1,70 @@
+
+#ifndef PYKADMINCONTROLLER_H
+#define PYKADMINCONTROLLER_H
+
+#include <Python.h>
+#include <kadm5/admin.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <structmember.h>
+
+#include "pykadmin.h"
+
+/*
+    adaptive admission control for kadm5 calls, shared by every handle it is attached
+    to (kadm.controller = kadmin.Controller(...)).
+
+    in-flight calls are limited to a window that grows by one per window of successful
+    calls and halves when kadmind signals overload (RPC/GSS errors, or completions slower
+    than latency_target), at most once per round trip. an optional token bucket caps calls
+    per second, and reads that fail transiently are retried after a jittered exponential
+    backoff. the state is guarded by a pthread mutex so waiting never holds the GIL.
+*/
+
+typedef struct {
+    PyObject_HEAD
+
+    pthread_mutex_t mutex;
+    pthread_cond_t changed;
+
+    double window;          // in-flight calls allowed, [1, max_concurrency]
+    double max_concurrency;
+    long in_flight;
+    double last_decrease;   // calls started before this don't shrink the window again
+
+    double latency_target;  // seconds, 0 to only react to errors
+    double latency;         // moving averages of completed calls
+    double error_rate;
+
+    double rate;            // calls per second, 0 for no cap
+    double tokens;
+    double refilled;
+
+    int retries;
+    double backoff;
+    double max_backoff;
+    unsigned int seed;
+
+    unsigned long long calls;
+    unsigned long long errors;
+    unsigned long long retried;
+    unsigned long long throttled;
+
+    // pykadmin_fork_generation the mutex and in_flight belong to
+    unsigned long generation;
+
+} PyKAdminController;
+
+PyTypeObject PyKAdminController_Type;
+
+#define PyKAdminController_Check(obj) PyObject_TypeCheck(obj, &PyKAdminController_Type)
+
+// call with the GIL held; waits for a slot (and token) with it released. returns the start time.
+double pykadmin_controller_enter(PyKAdminController *self);
+void pykadmin_controller_exit(PyKAdminController *self, double started, kadm5_ret_t retval);
+
+// whether to run a failed call again; sleeps the backoff (GIL released) first when so
+int pykadmin_controller_retry(PyKAdminController *self, kadm5_ret_t retval, int attempt);
+
+#endif
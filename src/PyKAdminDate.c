@@ -0,0 +1,367 @@
+
+#include "PyKAdminDate.h"
+#include "PyKAdminCommon.h"
+
+#include <ctype.h>
+#include <limits.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+
+#define kSECONDS_PER_DAY 86400L
+
+typedef struct {
+    const char *name;
+    long seconds;
+} pykadmin_date_unit_t;
+
+static const pykadmin_date_unit_t kDATE_UNITS[] = {
+    {"second",    1},
+    {"sec",       1},
+    {"minute",    60},
+    {"min",       60},
+    {"hour",      3600},
+    {"day",       kSECONDS_PER_DAY},
+    {"week",      7 * kSECONDS_PER_DAY},
+    {"fortnight", 14 * kSECONDS_PER_DAY},
+    {NULL,        0}
+};
+
+/*
+    relative strings repeat ("8 Days" for every principal of a bulk modify), so their
+    parsed length is kept in a small direct-mapped table keyed by the input string.
+*/
+
+#define kDURATION_CACHE_SIZE 64
+#define kDURATION_CACHE_KEY  24
+
+typedef struct {
+    char key[kDURATION_CACHE_KEY];
+    long seconds;
+} pykadmin_duration_cache_entry_t;
+
+static pykadmin_duration_cache_entry_t pykadmin_duration_cache[kDURATION_CACHE_SIZE];
+
+// parsing may run without the GIL, like the reentrant getdate grammar, so the table has its own lock
+static pthread_mutex_t pykadmin_duration_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+
+static const char *_pykadmin_skip_space(const char *p) {
+    while (isspace((unsigned char)*p))
+        p++;
+    return p;
+}
+
+/* up to max_digits decimal digits; returns how many were read */
+static int _pykadmin_parse_digits(const char **p, long *value, int max_digits) {
+
+    int digits = 0;
+
+    *value = 0;
+
+    while ((digits < max_digits) && isdigit((unsigned char)**p)) {
+        *value = (*value * 10) + (**p - '0');
+        (*p)++;
+        digits++;
+    }
+
+    return digits;
+}
+
+/* case-insensitive match of a whole word, leaving *p after it */
+static int _pykadmin_match_word(const char **p, const char *word) {
+
+    const char *q = *p;
+
+    for (; *word; word++, q++) {
+        if (tolower((unsigned char)*q) != *word)
+            return 0;
+    }
+
+    if (isalpha((unsigned char)*q))
+        return 0;
+
+    *p = q;
+    return 1;
+}
+
+static int _pykadmin_is_keyword(const char *input, const char *keyword) {
+
+    const char *p = _pykadmin_skip_space(input);
+
+    return _pykadmin_match_word(&p, keyword) && !*_pykadmin_skip_space(p);
+}
+
+static long _pykadmin_parse_unit(const char **p) {
+
+    const pykadmin_date_unit_t *unit = kDATE_UNITS;
+    const char *q = NULL;
+
+    for (; unit->name; unit++) {
+
+        q = *p;
+
+        if (strncasecmp(q, unit->name, strlen(unit->name)))
+            continue;
+
+        q += strlen(unit->name);
+
+        if ((*q == 's') || (*q == 'S'))
+            q++;
+
+        if (isalpha((unsigned char)*q))
+            continue;
+
+        *p = q;
+        return unit->seconds;
+    }
+
+    return 0;
+}
+
+/* "N unit [N unit ...]" */
+static int _pykadmin_parse_relative(const char *input, long *seconds) {
+
+    const char *p = _pykadmin_skip_space(input);
+    long long total = 0;
+    long count      = 0;
+    long unit       = 0;
+
+    if (!*p)
+        return 0;
+
+    while (*p) {
+
+        if (!_pykadmin_parse_digits(&p, &count, 6))
+            return 0;
+
+        p = _pykadmin_skip_space(p);
+
+        unit = _pykadmin_parse_unit(&p);
+        if (!unit)
+            return 0;
+
+        total += (long long)count * unit;
+        if (total > INT_MAX)
+            return 0;
+
+        p = _pykadmin_skip_space(p);
+    }
+
+    *seconds = (long)total;
+    return 1;
+}
+
+/*
+    "HH:MM[:SS]" as a length of time, the way kadmin's krb5_string_to_deltat reads it.
+    getdate (used before this parser existed) took it as the time left until then today.
+*/
+static int _pykadmin_parse_clock(const char *input, long *seconds) {
+
+    const char *p = _pykadmin_skip_space(input);
+    long hours   = 0;
+    long minutes = 0;
+    long secs    = 0;
+
+    if (!_pykadmin_parse_digits(&p, &hours, 5) || (*p++ != ':'))
+        return 0;
+
+    if ((_pykadmin_parse_digits(&p, &minutes, 2) != 2) || (minutes > 59))
+        return 0;
+
+    if (*p == ':') {
+        p++;
+        if ((_pykadmin_parse_digits(&p, &secs, 2) != 2) || (secs > 59))
+            return 0;
+    }
+
+    if (*_pykadmin_skip_space(p))
+        return 0;
+
+    *seconds = (hours * 3600) + (minutes * 60) + secs;
+    return 1;
+}
+
+/* days since 1970-01-01 of a proleptic gregorian date */
+static long _pykadmin_days_from_civil(long year, long month, long day) {
+
+    long era = 0;
+    long yoe = 0;
+    long doy = 0;
+    long doe = 0;
+
+    year -= (month <= 2);
+    era = year / 400;
+    yoe = year - (era * 400);
+    doy = ((153 * (month + ((month > 2) ? -3 : 9))) + 2) / 5 + day - 1;
+    doe = (yoe * 365) + (yoe / 4) - (yoe / 100) + doy;
+
+    return (era * 146097) + doe - 719468;
+}
+
+/* "YYYY-MM-DD[( |T)HH:MM[:SS]][Z]" */
+static int _pykadmin_parse_iso8601(const char *input, long long *timestamp) {
+
+    static const int kDAYS_IN_MONTH[12] = {31, 29, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+
+    const char *p = _pykadmin_skip_space(input);
+    long year    = 0;
+    long month   = 0;
+    long day     = 0;
+    long hour    = 0;
+    long minute  = 0;
+    long second  = 0;
+    int leap     = 0;
+    struct tm tm;
+
+    if ((_pykadmin_parse_digits(&p, &year, 4) != 4) || (*p++ != '-'))
+        return 0;
+    if ((_pykadmin_parse_digits(&p, &month, 2) != 2) || (*p++ != '-'))
+        return 0;
+    if (_pykadmin_parse_digits(&p, &day, 2) != 2)
+        return 0;
+
+    leap = ((year % 4) == 0) && (((year % 100) != 0) || ((year % 400) == 0));
+
+    if ((year < 1970) || (month < 1) || (month > 12) || (day < 1) || (day > kDAYS_IN_MONTH[month - 1]))
+        return 0;
+    if ((month == 2) && (day == 29) && !leap)
+        return 0;
+
+    if (((*p == 'T') || (*p == ' ')) && isdigit((unsigned char)p[1])) {
+
+        p++;
+
+        if ((_pykadmin_parse_digits(&p, &hour, 2) != 2) || (hour > 23) || (*p++ != ':'))
+            return 0;
+        if ((_pykadmin_parse_digits(&p, &minute, 2) != 2) || (minute > 59))
+            return 0;
+
+        if (*p == ':') {
+            p++;
+            if ((_pykadmin_parse_digits(&p, &second, 2) != 2) || (second > 59))
+                return 0;
+        }
+    }
+
+    if ((*p == 'Z') || (*p == 'z')) {
+
+        if (*_pykadmin_skip_space(p + 1))
+            return 0;
+
+        *timestamp = ((long long)_pykadmin_days_from_civil(year, month, day) * kSECONDS_PER_DAY)
+                   + (hour * 3600) + (minute * 60) + second;
+        return 1;
+    }
+
+    if (*_pykadmin_skip_space(p))
+        return 0;
+
+    memset(&tm, 0, sizeof(tm));
+
+    tm.tm_year  = year - 1900;
+    tm.tm_mon   = month - 1;
+    tm.tm_mday  = day;
+    tm.tm_hour  = hour;
+    tm.tm_min   = minute;
+    tm.tm_sec   = second;
+    tm.tm_isdst = -1;
+
+    *timestamp = mktime(&tm);
+
+    return (*timestamp != -1);
+}
+
+static int _pykadmin_parse_relative_cached(const char *input, long *seconds) {
+
+    pykadmin_duration_cache_entry_t *entry = NULL;
+    size_t length = strlen(input);
+    int hit = 0;
+
+    if ((length > 0) && (length < kDURATION_CACHE_KEY)) {
+
+        entry = &pykadmin_duration_cache[pykadmin_string_hash(input) % kDURATION_CACHE_SIZE];
+
+        pthread_mutex_lock(&pykadmin_duration_cache_mutex);
+        hit = !strcmp(entry->key, input);
+        if (hit)
+            *seconds = entry->seconds;
+        pthread_mutex_unlock(&pykadmin_duration_cache_mutex);
+
+        if (hit)
+            return 1;
+    }
+
+    if (!_pykadmin_parse_relative(input, seconds))
+        return 0;
+
+    if (entry) {
+        pthread_mutex_lock(&pykadmin_duration_cache_mutex);
+        memcpy(entry->key, input, length + 1);
+        entry->seconds = *seconds;
+        pthread_mutex_unlock(&pykadmin_duration_cache_mutex);
+    }
+
+    return 1;
+}
+
+int pykadmin_parse_timestamp(const char *input, krb5_timestamp *timestamp) {
+
+    long long absolute = 0;
+    long relative      = 0;
+
+    if (_pykadmin_is_keyword(input, "never")) {
+        *timestamp = 0;
+        return 1;
+    }
+
+    if (_pykadmin_is_keyword(input, "now")) {
+        *timestamp = time(NULL);
+        return 1;
+    }
+
+    if (_pykadmin_parse_iso8601(input, &absolute)) {
+        if ((absolute <= 0) || (absolute > INT_MAX))
+            return 0;
+        *timestamp = (krb5_timestamp)absolute;
+        return 1;
+    }
+
+    // "8 days" from now
+    if (_pykadmin_parse_relative_cached(input, &relative)) {
+        absolute = (long long)time(NULL) + relative;
+        if (absolute > INT_MAX)
+            return 0;
+        *timestamp = (krb5_timestamp)absolute;
+        return 1;
+    }
+
+    return 0;
+}
+
+int pykadmin_parse_duration(const char *input, krb5_deltat *seconds) {
+
+    long long until = 0;
+    long value      = 0;
+
+    if (_pykadmin_is_keyword(input, "never") || _pykadmin_is_keyword(input, "now")) {
+        *seconds = 0;
+        return 1;
+    }
+
+    if (_pykadmin_parse_relative_cached(input, &value) || _pykadmin_parse_clock(input, &value)) {
+        *seconds = (krb5_deltat)value;
+        return 1;
+    }
+
+    // an absolute date, as the length of time until it
+    if (_pykadmin_parse_iso8601(input, &until)) {
+        until -= time(NULL);
+        if ((until < INT_MIN) || (until > INT_MAX))
+            return 0;
+        *seconds = (krb5_deltat)until;
+        return 1;
+    }
+
+    return 0;
+}
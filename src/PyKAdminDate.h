@@ -0,0 +1,26 @@
+
+#ifndef PYKADMINDATE_H
+#define PYKADMINDATE_H
+
+#include <krb5/krb5.h>
+#include <time.h>
+
+/*
+    hand-written parser for the date and duration strings setters see most often,
+    tried before the getdate.y grammar:
+
+        never, now
+        YYYY-MM-DD[( |T)HH:MM[:SS]][Z]      local time unless suffixed with Z
+        N unit [N unit ...]                 second(s), sec(s), minute(s), min(s), hour(s),
+                                            day(s), week(s), fortnight(s)
+        HH:MM[:SS]                          durations only
+
+    both return 1 with the result set, or 0 when the input should go to get_date
+    (calendar-relative units like "3 months", weekdays, time zones, ...). neither
+    allocates, and both are safe to call without the GIL.
+*/
+
+int pykadmin_parse_timestamp(const char *input, krb5_timestamp *timestamp);
+int pykadmin_parse_duration(const char *input, krb5_deltat *seconds);
+
+#endif
@@ -16,6 +16,12 @@ PyObject *PyKAdminError_init(PyObject *module);
 
 void PyKAdminError_raise_error(long code, char *caller);
 
+#if PY_VERSION_HEX >= 0x03070000
+/* module __getattr__ / __dir__ exposing the per-code classes, built on first use */
+PyObject *PyKAdminError_getattr(PyObject *module, PyObject *name);
+PyObject *PyKAdminError_dir(PyObject *module, PyObject *unused);
+#endif
+
 /*
 void PyKAdminError_raise_kadm_error(kadm5_ret_t retval, char *caller);
 void PyKAdminError_raise_krb5_error(krb5_error_code code, char *caller);
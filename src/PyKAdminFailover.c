@@ -0,0 +1,327 @@
+
+#include "PyKAdminFailover.h"
+#include "PyKAdminCommon.h"
+
+#include <kadm5/kadm_err.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define kFAILOVER_LATENCY_WEIGHT 0.2
+
+static int _pykadmin_failover_transient(kadm5_ret_t retval) {
+    return (retval == KADM5_RPC_ERROR) || (retval == KADM5_GSS_ERROR) || (retval == KADM5_BAD_SERVER_HANDLE);
+}
+
+static void _pykadmin_failover_measure(pykadmin_failover_member_t *member, double elapsed) {
+
+    if (member->latency <= 0)
+        member->latency = elapsed;
+    else
+        member->latency += kFAILOVER_LATENCY_WEIGHT * (elapsed - member->latency);
+}
+
+static void _pykadmin_failover_logout(pykadmin_failover_member_t *member) {
+
+    if (member->server_handle)
+        kadm5_destroy(member->server_handle);
+
+    if (member->context)
+        krb5_free_context(member->context);
+
+    member->server_handle = NULL;
+    member->context       = NULL;
+}
+
+/* a working handle for member: probe the one it has, else log in again. times the probe. */
+static kadm5_ret_t _pykadmin_failover_revive(pykadmin_failover_member_t *member, pykadmin_session_t *session, const pykadmin_options_t *options) {
+
+    pykadmin_options_t server_options = *options;
+    kadm5_ret_t retval = KADM5_OK;
+    double started     = pykadmin_monotonic();
+
+    if (member->server_handle) {
+
+        retval = pykadmin_session_check(member->server_handle);
+
+        if (retval == KADM5_OK) {
+            _pykadmin_failover_measure(member, pykadmin_monotonic() - started);
+            member->healthy = 1;
+            return KADM5_OK;
+        }
+    }
+
+    _pykadmin_failover_logout(member);
+
+    retval = kadm5_init_krb5_context(&member->context);
+    if (retval != KADM5_OK) {
+        member->context = NULL;
+        member->healthy = 0;
+        return retval;
+    }
+
+    // same credentials and tuning, this member's server
+    server_options.admin_server = member->admin_server;
+    server_options.kadmind_port = 0;
+
+    retval = pykadmin_session_login(member->context, session, &server_options, &member->server_handle);
+
+    if (retval == KADM5_OK) {
+        started = pykadmin_monotonic();
+        retval  = pykadmin_session_check(member->server_handle);
+        _pykadmin_failover_measure(member, pykadmin_monotonic() - started);
+    }
+
+    member->healthy = (retval == KADM5_OK);
+
+    if (!member->healthy) {
+        member->failures++;
+        _pykadmin_failover_logout(member);
+    }
+
+    return retval;
+}
+
+pykadmin_failover_t *pykadmin_failover_create(char **admin_servers, size_t count) {
+
+    pykadmin_failover_t *failover = calloc(1, sizeof(pykadmin_failover_t));
+    size_t index = 0;
+
+    if (!failover)
+        return NULL;
+
+    failover->members = calloc(count, sizeof(pykadmin_failover_member_t));
+    if (!failover->members)
+        goto error;
+
+    failover->count = count;
+
+    for (; index < count; index++) {
+        failover->members[index].admin_server = strdup(admin_servers[index]);
+        if (!failover->members[index].admin_server)
+            goto error;
+    }
+
+    return failover;
+
+error:
+    pykadmin_failover_destroy(failover);
+    return NULL;
+}
+
+void pykadmin_failover_destroy(pykadmin_failover_t *failover) {
+
+    size_t index = 0;
+
+    if (!failover)
+        return;
+
+    if (failover->members) {
+
+        for (; index < failover->count; index++) {
+            _pykadmin_failover_logout(&failover->members[index]);
+            free(failover->members[index].admin_server);
+        }
+
+        free(failover->members);
+    }
+
+    free(failover);
+}
+
+kadm5_ret_t pykadmin_failover_start(pykadmin_failover_t *failover, pykadmin_session_t *session, const pykadmin_options_t *options) {
+
+    kadm5_ret_t retval = KADM5_OK;
+    kadm5_ret_t first  = KADM5_RPC_ERROR;
+    size_t index       = failover->count;
+
+    while (index-- > 0) {
+
+        retval = _pykadmin_failover_revive(&failover->members[index], session, options);
+
+        // walking backwards leaves the first server that answered active
+        if (retval == KADM5_OK) {
+            failover->active = index;
+            first = KADM5_OK;
+        } else if (first != KADM5_OK) {
+            first = retval;
+        }
+    }
+
+    // writes stay with the first server listed even when it did not answer; its outage starts now
+    failover->primary = 0;
+
+    if (!failover->members[0].healthy)
+        failover->primary_down = pykadmin_monotonic();
+
+    return first;
+}
+
+int pykadmin_failover_record(pykadmin_failover_t *failover, double elapsed, kadm5_ret_t retval, int write) {
+
+    size_t index = write ? failover->primary : failover->active;
+    pykadmin_failover_member_t *member = &failover->members[index];
+
+    member->calls++;
+
+    if (!_pykadmin_failover_transient(retval)) {
+        _pykadmin_failover_measure(member, elapsed);
+        if (index == failover->primary)
+            failover->primary_down = 0;
+        return 0;
+    }
+
+    member->failures++;
+    member->healthy = 0;
+
+    if ((index == failover->primary) && !failover->primary_down)
+        failover->primary_down = pykadmin_monotonic();
+
+    // reads move off a failed server; a failed write only moves them when it was the same one
+    return (index == failover->active) && (failover->count > 1);
+}
+
+/*
+    the named server, or the best one to move to from avoid, which is tried last; logged
+    in again if need be, all within options->failover_deadline. its index goes to chosen.
+*/
+static kadm5_ret_t _pykadmin_failover_choose(pykadmin_failover_t *failover, pykadmin_session_t *session, const pykadmin_options_t *options, const char *admin_server, size_t avoid, size_t *chosen) {
+
+    pykadmin_failover_member_t *member = NULL;
+    kadm5_ret_t retval   = KADM5_RPC_ERROR;
+    double deadline      = pykadmin_monotonic() + options->failover_deadline;
+    unsigned char *tried = NULL;
+    size_t attempt       = 0;
+    size_t index         = 0;
+    size_t best          = 0;
+
+    tried = calloc(failover->count, 1);
+    if (!tried)
+        return ENOMEM;
+
+    for (attempt = 0; attempt < failover->count; attempt++) {
+
+        if ((attempt > 0) && (options->failover_deadline > 0) && (pykadmin_monotonic() > deadline))
+            break;
+
+        best = failover->count;
+
+        for (index = 0; index < failover->count; index++) {
+
+            member = &failover->members[index];
+
+            if (tried[index])
+                continue;
+
+            if (admin_server) {
+                if (!strcmp(member->admin_server, admin_server))
+                    best = index;
+                continue;
+            }
+
+            // the server being moved away from is the last resort
+            if ((index == avoid) && (attempt < failover->count - 1))
+                continue;
+
+            // healthy first, then fastest; unmeasured servers count as slow
+            if ((best == failover->count)
+                || (member->healthy > failover->members[best].healthy)
+                || ((member->healthy == failover->members[best].healthy)
+                    && (member->latency > 0)
+                    && ((failover->members[best].latency <= 0) || (member->latency < failover->members[best].latency))))
+                best = index;
+        }
+
+        if (best == failover->count)
+            break;
+
+        tried[best] = 1;
+
+        retval = _pykadmin_failover_revive(&failover->members[best], session, options);
+
+        if (retval == KADM5_OK) {
+            *chosen = best;
+            break;
+        }
+    }
+
+    free(tried);
+
+    return retval;
+}
+
+kadm5_ret_t pykadmin_failover_select(pykadmin_failover_t *failover, pykadmin_session_t *session, const pykadmin_options_t *options, const char *admin_server) {
+
+    size_t chosen      = failover->active;
+    kadm5_ret_t retval = _pykadmin_failover_choose(failover, session, options, admin_server, failover->active, &chosen);
+
+    if (retval == KADM5_OK) {
+        if (chosen != failover->active)
+            failover->failovers++;
+        failover->active = chosen;
+    }
+
+    return retval;
+}
+
+kadm5_ret_t pykadmin_failover_promote(pykadmin_failover_t *failover, pykadmin_session_t *session, const pykadmin_options_t *options, const char *admin_server) {
+
+    size_t chosen      = failover->primary;
+    kadm5_ret_t retval = _pykadmin_failover_choose(failover, session, options, admin_server, failover->primary, &chosen);
+
+    if (retval == KADM5_OK) {
+        if (chosen != failover->primary)
+            failover->promotions++;
+        failover->primary      = chosen;
+        failover->primary_down = 0;
+    }
+
+    return retval;
+}
+
+kadm5_ret_t pykadmin_failover_writer(pykadmin_failover_t *failover, pykadmin_session_t *session, const pykadmin_options_t *options) {
+
+    pykadmin_failover_member_t *primary = pykadmin_failover_primary(failover);
+    kadm5_ret_t retval = KADM5_OK;
+    double now         = 0;
+
+    if (primary->healthy && primary->server_handle)
+        return KADM5_OK;
+
+    retval = _pykadmin_failover_revive(primary, session, options);
+    now    = pykadmin_monotonic();
+
+    if (retval == KADM5_OK) {
+        failover->primary_down = 0;
+        return KADM5_OK;
+    }
+
+    if (!failover->primary_down)
+        failover->primary_down = now;
+
+    // writes wait for the primary until it has been down past its deadline
+    if ((options->primary_deadline <= 0) || (failover->count < 2) || ((now - failover->primary_down) < options->primary_deadline))
+        return retval;
+
+    return pykadmin_failover_promote(failover, session, options, NULL);
+}
+
+void pykadmin_failover_abandon(pykadmin_failover_t *failover) {
+
+    size_t index = 0;
+
+    for (; index < failover->count; index++) {
+        failover->members[index].server_handle = NULL;
+        failover->members[index].healthy       = 0;
+    }
+}
+
+void pykadmin_failover_replace_active(pykadmin_failover_t *failover, krb5_context context, void *server_handle) {
+
+    pykadmin_failover_member_t *member = pykadmin_failover_active(failover);
+
+    _pykadmin_failover_logout(member);
+
+    member->context       = context;
+    member->server_handle = server_handle;
+    member->healthy       = 1;
+}
@@ -0,0 +1,84 @@
+
+#ifndef PYKADMINFAILOVER_H
+#define PYKADMINFAILOVER_H
+
+#include <kadm5/admin.h>
+#include <krb5/krb5.h>
+#include <stddef.h>
+
+#include "PyKAdminSession.h"
+#include "PyKAdminOptions.h"
+
+/*
+    a handle's set of admin servers (kadmin.connect(admin_servers=[...])).
+
+    every server gets its own logged-in kadm5 handle (and krb5 context) up front so a
+    standby is warm when needed. reads go to the active server, the first in the list
+    that answered to begin with. when it fails with an RPC/GSS error the healthy standby
+    with the lowest measured latency is checked (logging it in again if its connection
+    went away) and made active, all within options->failover_deadline.
+
+    writes go to the primary, the first server in the list, wherever reads have gone: a
+    standby may be a read-only replica. a primary that stops answering is logged in again
+    before each write. only once it has failed for options->primary_deadline (or on an
+    explicit promote) does another server become primary, and it stays so until the next
+    promote.
+*/
+
+typedef struct {
+    char *admin_server;
+    krb5_context context;
+    void *server_handle;
+    double latency;         // moving average of calls and probes, seconds; 0 until measured
+    int healthy;
+    unsigned long calls;
+    unsigned long failures;
+} pykadmin_failover_member_t;
+
+typedef struct {
+    size_t count;
+    size_t active;
+    size_t primary;
+    double primary_down;    // monotonic time the primary first failed in its current outage, 0 while it answers
+    unsigned long failovers;
+    unsigned long promotions;
+    pykadmin_failover_member_t *members;
+} pykadmin_failover_t;
+
+// copies the names. NULL when out of memory.
+pykadmin_failover_t *pykadmin_failover_create(char **admin_servers, size_t count);
+void pykadmin_failover_destroy(pykadmin_failover_t *failover);
+
+// log every server in; the first that succeeds becomes active. returns the last error when none do.
+kadm5_ret_t pykadmin_failover_start(pykadmin_failover_t *failover, pykadmin_session_t *session, const pykadmin_options_t *options);
+
+// feedback from a call on the active server (the primary, for a write); returns whether it calls for a failover
+int pykadmin_failover_record(pykadmin_failover_t *failover, double elapsed, kadm5_ret_t retval, int write);
+
+/*
+    make another server active: the best healthy one other than the current (or the one
+    named by admin_server, when given). returns KADM5_OK, or the last error when no
+    server answered before the deadline.
+*/
+kadm5_ret_t pykadmin_failover_select(pykadmin_failover_t *failover, pykadmin_session_t *session, const pykadmin_options_t *options, const char *admin_server);
+
+/*
+    make sure the primary can take a write: log it in again if it failed, and promote the
+    best other server once it has been failing for longer than options->primary_deadline
+    (never, when that is 0). returns KADM5_OK, or why there is no server to write to.
+*/
+kadm5_ret_t pykadmin_failover_writer(pykadmin_failover_t *failover, pykadmin_session_t *session, const pykadmin_options_t *options);
+
+/* make another server primary: the one named by admin_server, or the best healthy one other than the current */
+kadm5_ret_t pykadmin_failover_promote(pykadmin_failover_t *failover, pykadmin_session_t *session, const pykadmin_options_t *options, const char *admin_server);
+
+// after a fork: drop every server's handle without kadm5_destroy, which would end the parent's sessions
+void pykadmin_failover_abandon(pykadmin_failover_t *failover);
+
+// take over a freshly logged in handle (and its context) for the active server
+void pykadmin_failover_replace_active(pykadmin_failover_t *failover, krb5_context context, void *server_handle);
+
+#define pykadmin_failover_active(failover) (&(failover)->members[(failover)->active])
+#define pykadmin_failover_primary(failover) (&(failover)->members[(failover)->primary])
+
+#endif
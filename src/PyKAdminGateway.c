@@ -0,0 +1,1339 @@
+
+#include "PyKAdminGateway.h"
+#include "PyKAdminErrors.h"
+#include "PyKAdminCommon.h"
+
+#ifndef KADMIN_LOCAL
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define kGATEWAY_MAX_FRAME  (1 << 24)   // long principal listings
+#define kGATEWAY_NO_FIELD   0xffff
+#define kGATEWAY_IDLE       30          // seconds a connection may hold a worker without a request
+#define kGATEWAY_POLL_MS    250         // how often the accept loop checks for signals
+#define kGATEWAY_BACKLOG    128
+
+// integers of a GET response, in order
+#define kGATEWAY_GET_INTS   12
+
+
+/* framing */
+
+typedef struct {
+    unsigned char *data;
+    size_t length;
+    size_t size;
+    int failed;
+} pykadmin_gateway_buffer_t;
+
+typedef struct {
+    const unsigned char *data;
+    size_t length;
+    size_t offset;
+    int failed;
+} pykadmin_gateway_reader_t;
+
+static void _pykadmin_gateway_put(pykadmin_gateway_buffer_t *buffer, const void *bytes, size_t length) {
+
+    unsigned char *data = NULL;
+    size_t size = 0;
+
+    if (buffer->failed)
+        return;
+
+    if (buffer->length + length > buffer->size) {
+
+        size = buffer->size ? buffer->size * 2 : 256;
+        while (size < buffer->length + length)
+            size *= 2;
+
+        data = realloc(buffer->data, size);
+        if (!data) {
+            buffer->failed = 1;
+            return;
+        }
+
+        buffer->data = data;
+        buffer->size = size;
+    }
+
+    memcpy(buffer->data + buffer->length, bytes, length);
+    buffer->length += length;
+}
+
+static void _pykadmin_gateway_put_u8(pykadmin_gateway_buffer_t *buffer, uint8_t value) {
+    _pykadmin_gateway_put(buffer, &value, 1);
+}
+
+static void _pykadmin_gateway_put_u16(pykadmin_gateway_buffer_t *buffer, uint16_t value) {
+    value = htons(value);
+    _pykadmin_gateway_put(buffer, &value, 2);
+}
+
+static void _pykadmin_gateway_put_u32(pykadmin_gateway_buffer_t *buffer, uint32_t value) {
+    value = htonl(value);
+    _pykadmin_gateway_put(buffer, &value, 4);
+}
+
+static void _pykadmin_gateway_put_field(pykadmin_gateway_buffer_t *buffer, const char *string) {
+
+    size_t length = 0;
+
+    if (!string) {
+        _pykadmin_gateway_put_u16(buffer, kGATEWAY_NO_FIELD);
+        return;
+    }
+
+    length = strlen(string);
+
+    if (length >= kGATEWAY_NO_FIELD) {
+        buffer->failed = 1;
+        return;
+    }
+
+    _pykadmin_gateway_put_u16(buffer, (uint16_t)length);
+    _pykadmin_gateway_put(buffer, string, length);
+}
+
+/* frames begin with their length, filled in by _pykadmin_gateway_send */
+static void _pykadmin_gateway_buffer_init(pykadmin_gateway_buffer_t *buffer) {
+    memset(buffer, 0, sizeof(pykadmin_gateway_buffer_t));
+    _pykadmin_gateway_put_u32(buffer, 0);
+}
+
+/* requests may carry passwords */
+static void _pykadmin_gateway_buffer_free(pykadmin_gateway_buffer_t *buffer) {
+
+    if (buffer->data) {
+        memset(buffer->data, 0, buffer->size);
+        free(buffer->data);
+    }
+
+    memset(buffer, 0, sizeof(pykadmin_gateway_buffer_t));
+}
+
+static int _pykadmin_gateway_take(pykadmin_gateway_reader_t *reader, void *bytes, size_t length) {
+
+    if (reader->failed || (reader->offset + length > reader->length)) {
+        reader->failed = 1;
+        return -1;
+    }
+
+    memcpy(bytes, reader->data + reader->offset, length);
+    reader->offset += length;
+
+    return 0;
+}
+
+static uint8_t _pykadmin_gateway_get_u8(pykadmin_gateway_reader_t *reader) {
+
+    uint8_t value = 0;
+
+    _pykadmin_gateway_take(reader, &value, 1);
+
+    return value;
+}
+
+static uint32_t _pykadmin_gateway_get_u32(pykadmin_gateway_reader_t *reader) {
+
+    uint32_t value = 0;
+
+    if (_pykadmin_gateway_take(reader, &value, 4))
+        return 0;
+
+    return ntohl(value);
+}
+
+/* malloc'd copy of the next field; NULL for none (check reader->failed) */
+static char *_pykadmin_gateway_get_field(pykadmin_gateway_reader_t *reader) {
+
+    uint16_t length = 0;
+    char *string    = NULL;
+
+    if (_pykadmin_gateway_take(reader, &length, 2))
+        return NULL;
+
+    length = ntohs(length);
+
+    if (length == kGATEWAY_NO_FIELD)
+        return NULL;
+
+    if (reader->offset + length > reader->length) {
+        reader->failed = 1;
+        return NULL;
+    }
+
+    string = malloc(length + 1);
+    if (!string) {
+        reader->failed = 1;
+        return NULL;
+    }
+
+    memcpy(string, reader->data + reader->offset, length);
+    string[length] = '\0';
+
+    reader->offset += length;
+
+    return string;
+}
+
+static void _pykadmin_gateway_free_secret(char *string) {
+
+    if (string) {
+        memset(string, 0, strlen(string));
+        free(string);
+    }
+}
+
+static int _pykadmin_gateway_write_all(int fd, const unsigned char *data, size_t length) {
+
+    ssize_t written = 0;
+
+    while (length) {
+
+        written = send(fd, data, length, MSG_NOSIGNAL);
+
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+
+        data   += written;
+        length -= written;
+    }
+
+    return 0;
+}
+
+static int _pykadmin_gateway_read_all(int fd, unsigned char *data, size_t length) {
+
+    ssize_t received = 0;
+
+    while (length) {
+
+        received = recv(fd, data, length, 0);
+
+        if (received < 0) {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+
+        if (received == 0) {
+            errno = ECONNRESET;
+            return -1;
+        }
+
+        data   += received;
+        length -= received;
+    }
+
+    return 0;
+}
+
+static int _pykadmin_gateway_send(int fd, pykadmin_gateway_buffer_t *buffer) {
+
+    uint32_t length = 0;
+
+    if (buffer->failed) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    length = htonl((uint32_t)(buffer->length - 4));
+    memcpy(buffer->data, &length, 4);
+
+    return _pykadmin_gateway_write_all(fd, buffer->data, buffer->length);
+}
+
+/* next frame into a malloc'd *data */
+static int _pykadmin_gateway_receive(int fd, unsigned char **data, size_t *length) {
+
+    uint32_t header = 0;
+
+    *data   = NULL;
+    *length = 0;
+
+    if (_pykadmin_gateway_read_all(fd, (unsigned char *)&header, 4))
+        return -1;
+
+    header = ntohl(header);
+
+    if (header > kGATEWAY_MAX_FRAME) {
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    *data = malloc(header ? header : 1);
+    if (!*data) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    if (_pykadmin_gateway_read_all(fd, *data, header)) {
+        free(*data);
+        *data = NULL;
+        return -1;
+    }
+
+    *length = header;
+
+    return 0;
+}
+
+static int _pykadmin_gateway_is_read(int op) {
+    return (op == kGATEWAY_EXISTS) || (op == kGATEWAY_GET) || (op == kGATEWAY_LIST);
+}
+
+
+/* server */
+
+typedef struct _pykadmin_gateway pykadmin_gateway_t;
+
+typedef struct {
+    pykadmin_gateway_t *gateway;
+    krb5_context context;
+    void *server_handle;
+    pthread_t thread;
+    int started;
+    int fd;                     // connection being served, -1 when idle
+} pykadmin_gateway_worker_t;
+
+struct _pykadmin_gateway {
+    pykadmin_session_t *session;
+    pykadmin_options_t options;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+
+    // accepted connections waiting for a worker
+    int *queue;
+    size_t capacity;
+    size_t head;
+    size_t count;
+
+    int stopping;
+
+    size_t size;
+    pykadmin_gateway_worker_t *workers;
+};
+
+static int _pykadmin_gateway_transient(kadm5_ret_t retval) {
+    return (retval == KADM5_RPC_ERROR) || (retval == KADM5_GSS_ERROR) || (retval == KADM5_BAD_SERVER_HANDLE);
+}
+
+static void _pykadmin_gateway_relogin(pykadmin_gateway_worker_t *worker) {
+
+    if (worker->server_handle)
+        kadm5_destroy(worker->server_handle);
+
+    worker->server_handle = NULL;
+
+    // on failure the next request finds no handle and tries again
+    if (pykadmin_session_login(worker->context, worker->gateway->session, &worker->gateway->options, &worker->server_handle) != KADM5_OK)
+        worker->server_handle = NULL;
+}
+
+static void _pykadmin_gateway_put_entry(krb5_context context, pykadmin_gateway_buffer_t *reply, kadm5_principal_ent_rec *entry) {
+
+    char *name     = NULL;
+    char *mod_name = NULL;
+
+    if (entry->principal && krb5_unparse_name(context, entry->principal, &name))
+        name = NULL;
+    if (entry->mod_name && krb5_unparse_name(context, entry->mod_name, &mod_name))
+        mod_name = NULL;
+
+    _pykadmin_gateway_put_field(reply, name);
+    _pykadmin_gateway_put_field(reply, mod_name);
+    _pykadmin_gateway_put_field(reply, entry->policy);
+
+    _pykadmin_gateway_put_u32(reply, (uint32_t)entry->princ_expire_time);
+    _pykadmin_gateway_put_u32(reply, (uint32_t)entry->last_pwd_change);
+    _pykadmin_gateway_put_u32(reply, (uint32_t)entry->pw_expiration);
+    _pykadmin_gateway_put_u32(reply, (uint32_t)entry->max_life);
+    _pykadmin_gateway_put_u32(reply, (uint32_t)entry->max_renewable_life);
+    _pykadmin_gateway_put_u32(reply, (uint32_t)entry->mod_date);
+    _pykadmin_gateway_put_u32(reply, (uint32_t)entry->attributes);
+    _pykadmin_gateway_put_u32(reply, (uint32_t)entry->kvno);
+    _pykadmin_gateway_put_u32(reply, (uint32_t)entry->mkvno);
+    _pykadmin_gateway_put_u32(reply, (uint32_t)entry->last_success);
+    _pykadmin_gateway_put_u32(reply, (uint32_t)entry->last_failed);
+    _pykadmin_gateway_put_u32(reply, (uint32_t)entry->fail_auth_count);
+
+    if (name)
+        krb5_free_unparsed_name(context, name);
+    if (mod_name)
+        krb5_free_unparsed_name(context, mod_name);
+}
+
+/* one kadm5 call; response fields are appended to reply */
+static kadm5_ret_t _pykadmin_gateway_execute(pykadmin_gateway_worker_t *worker, int op, const char *name, char *argument, pykadmin_gateway_buffer_t *reply) {
+
+    kadm5_principal_ent_rec entry;
+    kadm5_ret_t retval   = KADM5_OK;
+    krb5_principal princ = NULL;
+    char **names         = NULL;
+    int count            = 0;
+    int index            = 0;
+
+    memset(&entry, 0, sizeof(entry));
+
+    if (op == kGATEWAY_LIST) {
+
+        retval = kadm5_get_principals(worker->server_handle, (char *)name, &names, &count);
+
+        if (retval == KADM5_OK) {
+            _pykadmin_gateway_put_u32(reply, (uint32_t)count);
+            for (index = 0; index < count; index++)
+                _pykadmin_gateway_put_field(reply, names[index]);
+            kadm5_free_name_list(worker->server_handle, names, count);
+        }
+
+        return retval;
+    }
+
+    if (!name)
+        return EINVAL;
+
+    if ((retval = krb5_parse_name(worker->context, name, &princ)))
+        return retval;
+
+    switch (op) {
+
+        case kGATEWAY_EXISTS:
+            retval = kadm5_get_principal(worker->server_handle, princ, &entry, KADM5_PRINCIPAL);
+            if (retval == KADM5_OK)
+                kadm5_free_principal_ent(worker->server_handle, &entry);
+            break;
+
+        case kGATEWAY_GET:
+            retval = kadm5_get_principal(worker->server_handle, princ, &entry, KADM5_PRINCIPAL_NORMAL_MASK);
+            if (retval == KADM5_OK) {
+                _pykadmin_gateway_put_entry(worker->context, reply, &entry);
+                kadm5_free_principal_ent(worker->server_handle, &entry);
+            }
+            break;
+
+        case kGATEWAY_CREATE:
+            entry.principal = princ;
+            retval = kadm5_create_principal(worker->server_handle, &entry, KADM5_PRINCIPAL, argument);
+            break;
+
+        case kGATEWAY_DELETE:
+            retval = kadm5_delete_principal(worker->server_handle, princ);
+            break;
+
+        case kGATEWAY_CHPASS:
+            retval = argument ? kadm5_chpass_principal(worker->server_handle, princ, argument) : EINVAL;
+            break;
+
+        case kGATEWAY_RANDKEY:
+            retval = kadm5_randkey_principal(worker->server_handle, princ, NULL, NULL);
+            break;
+
+        default:
+            retval = EINVAL;
+            break;
+    }
+
+    krb5_free_principal(worker->context, princ);
+
+    return retval;
+}
+
+static void _pykadmin_gateway_answer(pykadmin_gateway_worker_t *worker, const unsigned char *data, size_t length, pykadmin_gateway_buffer_t *reply) {
+
+    pykadmin_gateway_reader_t reader = {data, length, 0, 0};
+    kadm5_ret_t retval = KADM5_OK;
+    uint32_t code      = 0;
+    char *name         = NULL;
+    char *argument     = NULL;
+    int op             = 0;
+
+    op   = _pykadmin_gateway_get_u8(&reader);
+    name = _pykadmin_gateway_get_field(&reader);
+
+    if ((op == kGATEWAY_CREATE) || (op == kGATEWAY_CHPASS))
+        argument = _pykadmin_gateway_get_field(&reader);
+
+    // code, filled in below
+    _pykadmin_gateway_put_u32(reply, 0);
+
+    if (reader.failed) {
+        retval = EINVAL;
+    } else {
+
+        retval = _pykadmin_gateway_execute(worker, op, name, argument, reply);
+
+        // kadmind went away: log in again, and repeat reads (a write may have been applied)
+        if (_pykadmin_gateway_transient(retval)) {
+
+            _pykadmin_gateway_relogin(worker);
+
+            if (_pykadmin_gateway_is_read(op)) {
+                reply->length = 8;
+                retval = _pykadmin_gateway_execute(worker, op, name, argument, reply);
+            }
+        }
+    }
+
+    if (retval != KADM5_OK)
+        reply->length = 8;
+
+    code = htonl((uint32_t)retval);
+    if (!reply->failed)
+        memcpy(reply->data + 4, &code, 4);
+
+    free(name);
+    _pykadmin_gateway_free_secret(argument);
+}
+
+static void _pykadmin_gateway_serve_connection(pykadmin_gateway_worker_t *worker, int fd) {
+
+    pykadmin_gateway_buffer_t reply;
+    unsigned char *data = NULL;
+    size_t length       = 0;
+    int status          = 0;
+
+    while (!_pykadmin_gateway_receive(fd, &data, &length)) {
+
+        _pykadmin_gateway_buffer_init(&reply);
+        _pykadmin_gateway_answer(worker, data, length, &reply);
+
+        memset(data, 0, length);
+        free(data);
+
+        status = _pykadmin_gateway_send(fd, &reply);
+        _pykadmin_gateway_buffer_free(&reply);
+
+        if (status)
+            break;
+    }
+}
+
+static void *_pykadmin_gateway_worker_main(void *data) {
+
+    pykadmin_gateway_worker_t *worker = (pykadmin_gateway_worker_t *)data;
+    pykadmin_gateway_t *gateway = worker->gateway;
+    int fd = -1;
+
+    for (;;) {
+
+        pthread_mutex_lock(&gateway->mutex);
+
+        while (!gateway->count && !gateway->stopping)
+            pthread_cond_wait(&gateway->cond, &gateway->mutex);
+
+        if (gateway->stopping) {
+            pthread_mutex_unlock(&gateway->mutex);
+            break;
+        }
+
+        fd = gateway->queue[gateway->head];
+        gateway->head = (gateway->head + 1) % gateway->capacity;
+        gateway->count--;
+
+        worker->fd = fd;
+
+        pthread_mutex_unlock(&gateway->mutex);
+
+        _pykadmin_gateway_serve_connection(worker, fd);
+
+        pthread_mutex_lock(&gateway->mutex);
+        worker->fd = -1;
+        pthread_mutex_unlock(&gateway->mutex);
+
+        close(fd);
+    }
+
+    return NULL;
+}
+
+static int _pykadmin_gateway_peer_allowed(int fd) {
+
+#ifdef SO_PEERCRED
+    struct ucred credentials;
+    socklen_t length = sizeof(credentials);
+
+    if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &length))
+        return 0;
+
+    return (credentials.uid == 0) || (credentials.uid == geteuid());
+#else
+    // the socket's mode is the only guard
+    return 1;
+#endif
+}
+
+/* hand an accepted connection to the workers, or drop it */
+static void _pykadmin_gateway_admit(pykadmin_gateway_t *gateway, int fd) {
+
+    struct timeval idle = {kGATEWAY_IDLE, 0};
+
+    if (!_pykadmin_gateway_peer_allowed(fd)) {
+        close(fd);
+        return;
+    }
+
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &idle, sizeof(idle));
+
+    pthread_mutex_lock(&gateway->mutex);
+
+    if (gateway->count == gateway->capacity) {
+        pthread_mutex_unlock(&gateway->mutex);
+        close(fd);
+        return;
+    }
+
+    gateway->queue[(gateway->head + gateway->count) % gateway->capacity] = fd;
+    gateway->count++;
+
+    pthread_cond_signal(&gateway->cond);
+    pthread_mutex_unlock(&gateway->mutex);
+}
+
+static void _pykadmin_gateway_stop(pykadmin_gateway_t *gateway) {
+
+    size_t index = 0;
+
+    // nothing was started
+    if (!gateway->workers)
+        return;
+
+    pthread_mutex_lock(&gateway->mutex);
+
+    gateway->stopping = 1;
+
+    // wake workers blocked reading a connection
+    for (index = 0; index < gateway->size; index++) {
+        if (gateway->workers[index].fd >= 0)
+            shutdown(gateway->workers[index].fd, SHUT_RDWR);
+    }
+
+    pthread_cond_broadcast(&gateway->cond);
+    pthread_mutex_unlock(&gateway->mutex);
+
+    for (index = 0; index < gateway->size; index++) {
+        if (gateway->workers[index].started)
+            pthread_join(gateway->workers[index].thread, NULL);
+    }
+
+    for (; gateway->count; gateway->count--) {
+        close(gateway->queue[gateway->head]);
+        gateway->head = (gateway->head + 1) % gateway->capacity;
+    }
+}
+
+static void _pykadmin_gateway_destroy(pykadmin_gateway_t *gateway) {
+
+    pykadmin_gateway_worker_t *worker = NULL;
+    size_t index = 0;
+
+    if (!gateway)
+        return;
+
+    for (index = 0; gateway->workers && (index < gateway->size); index++) {
+
+        worker = &gateway->workers[index];
+
+        if (worker->server_handle)
+            kadm5_destroy(worker->server_handle);
+        if (worker->context)
+            krb5_free_context(worker->context);
+    }
+
+    pthread_cond_destroy(&gateway->cond);
+    pthread_mutex_destroy(&gateway->mutex);
+
+    pykadmin_session_destroy(gateway->session);
+    pykadmin_options_clear(&gateway->options);
+
+    free(gateway->workers);
+    free(gateway->queue);
+    free(gateway);
+}
+
+/* whether nothing listens on the socket at address any more */
+static int _pykadmin_gateway_abandoned(struct sockaddr_un *address) {
+
+    int abandoned = 0;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0)
+        return 0;
+
+    if (connect(fd, (struct sockaddr *)address, sizeof(*address)))
+        abandoned = (errno == ECONNREFUSED);
+
+    close(fd);
+
+    return abandoned;
+}
+
+PyObject *pykadmin_gateway_serve(const char *path, PyKAdminObject *kadm, int pool, int mode) {
+
+    pykadmin_gateway_t *gateway       = NULL;
+    pykadmin_gateway_worker_t *worker = NULL;
+    struct sockaddr_un address;
+    struct pollfd ready;
+    struct stat status;
+    kadm5_ret_t retval = KADM5_OK;
+    size_t index       = 0;
+    int listener       = -1;
+    int bound          = 0;
+    int fd             = -1;
+
+    if (!kadm->session) {
+        PyErr_SetString(PyExc_ValueError, "the handle has no credentials to share");
+        return NULL;
+    }
+
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        PyErr_SetString(PyExc_ValueError, "socket path is too long");
+        return NULL;
+    }
+
+    gateway = calloc(1, sizeof(pykadmin_gateway_t));
+    if (!gateway)
+        return PyErr_NoMemory();
+
+    pthread_mutex_init(&gateway->mutex, NULL);
+    pthread_cond_init(&gateway->cond, NULL);
+
+    gateway->size     = (size_t)pool;
+    gateway->capacity = (size_t)pool * 4 + kGATEWAY_BACKLOG;
+    gateway->session  = pykadmin_session_copy(kadm->session);
+    gateway->workers  = calloc(gateway->size, sizeof(pykadmin_gateway_worker_t));
+    gateway->queue    = calloc(gateway->capacity, sizeof(int));
+
+    // no worker holds a connection yet (0 would be stdin)
+    for (index = 0; gateway->workers && (index < gateway->size); index++) {
+        gateway->workers[index].gateway = gateway;
+        gateway->workers[index].fd      = -1;
+    }
+
+    if (!gateway->session || !gateway->workers || !gateway->queue || pykadmin_options_copy(&gateway->options, &kadm->options)) {
+        PyErr_NoMemory();
+        goto cleanup;
+    }
+
+    // log the whole pool in before taking connections
+    Py_BEGIN_ALLOW_THREADS
+
+    for (index = 0; index < gateway->size; index++) {
+
+        worker = &gateway->workers[index];
+
+        retval = kadm5_init_krb5_context(&worker->context);
+        if (retval) {
+            worker->context = NULL;
+            break;
+        }
+
+        retval = pykadmin_session_login(worker->context, gateway->session, &gateway->options, &worker->server_handle);
+        if (retval) {
+            worker->server_handle = NULL;
+            break;
+        }
+    }
+
+    Py_END_ALLOW_THREADS
+
+    if (retval != KADM5_OK) {
+        PyKAdminError_raise_error(retval, (char *)pykadmin_session_caller(gateway->session));
+        goto cleanup;
+    }
+
+    listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        PyErr_SetFromErrno(PyExc_OSError);
+        goto cleanup;
+    }
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    // left behind by a gateway that was killed; one that still answers keeps its socket
+    if (!lstat(path, &status) && S_ISSOCK(status.st_mode)) {
+
+        if (!_pykadmin_gateway_abandoned(&address)) {
+            errno = EADDRINUSE;
+            PyErr_SetFromErrnoWithFilename(PyExc_OSError, (char *)path);
+            goto cleanup;
+        }
+
+        unlink(path);
+    }
+
+    if (bind(listener, (struct sockaddr *)&address, sizeof(address))) {
+        PyErr_SetFromErrnoWithFilename(PyExc_OSError, (char *)path);
+        goto cleanup;
+    }
+
+    bound = 1;
+
+    if (chmod(path, (mode_t)mode) || listen(listener, kGATEWAY_BACKLOG)) {
+        PyErr_SetFromErrnoWithFilename(PyExc_OSError, (char *)path);
+        goto cleanup;
+    }
+
+    for (index = 0; index < gateway->size; index++) {
+
+        worker = &gateway->workers[index];
+
+        errno = pthread_create(&worker->thread, NULL, _pykadmin_gateway_worker_main, worker);
+        if (errno) {
+            PyErr_SetFromErrno(PyExc_OSError);
+            goto cleanup;
+        }
+
+        worker->started = 1;
+    }
+
+    // serve until a signal handler raises (KeyboardInterrupt, or one installed for SIGTERM)
+    while (!PyErr_CheckSignals()) {
+
+        ready.fd      = listener;
+        ready.events  = POLLIN;
+        ready.revents = 0;
+
+        Py_BEGIN_ALLOW_THREADS
+
+        fd = -1;
+        if (poll(&ready, 1, kGATEWAY_POLL_MS) > 0)
+            fd = accept(listener, NULL, NULL);
+
+        Py_END_ALLOW_THREADS
+
+        if (fd >= 0)
+            _pykadmin_gateway_admit(gateway, fd);
+    }
+
+cleanup:
+
+    Py_BEGIN_ALLOW_THREADS
+    _pykadmin_gateway_stop(gateway);
+    Py_END_ALLOW_THREADS
+
+    if (listener >= 0)
+        close(listener);
+
+    if (bound)
+        unlink(path);
+
+    _pykadmin_gateway_destroy(gateway);
+
+    return NULL;
+}
+
+
+/* client */
+
+static int _pykadmin_gateway_client_connect(PyKAdminGatewayClient *self) {
+
+    struct sockaddr_un address;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (fd < 0)
+        return -1;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, self->path, sizeof(address.sun_path) - 1);
+
+    if (connect(fd, (struct sockaddr *)&address, sizeof(address))) {
+        close(fd);
+        return -1;
+    }
+
+    self->fd = fd;
+
+    return 0;
+}
+
+static void _pykadmin_gateway_client_disconnect(PyKAdminGatewayClient *self) {
+
+    if (self->fd >= 0)
+        close(self->fd);
+
+    self->fd = -1;
+}
+
+/* the gateway closed the connection (idle, or restarted) since the last request */
+static int _pykadmin_gateway_client_stale(PyKAdminGatewayClient *self) {
+
+    struct pollfd ready = {self->fd, POLLIN, 0};
+    char byte = 0;
+
+    if (poll(&ready, 1, 0) <= 0)
+        return 0;
+
+    return recv(self->fd, &byte, 1, MSG_PEEK | MSG_DONTWAIT) <= 0;
+}
+
+/*
+    send one request and wait for its response. returns a reader over the malloc'd
+    response in *data, positioned after the code, or -1 with an exception set.
+*/
+static int _pykadmin_gateway_client_call(PyKAdminGatewayClient *self, int op, const char *name, const char *argument,
+                                         unsigned char **data, pykadmin_gateway_reader_t *reader, kadm5_ret_t *retval) {
+
+    pykadmin_gateway_buffer_t request;
+    size_t length = 0;
+    int attempt   = 0;
+    int status    = -1;
+    int error     = 0;
+
+    *data = NULL;
+
+    if (!self->lock) {
+        PyErr_SetString(PyExc_ValueError, "GatewayClient is not initialized");
+        return -1;
+    }
+
+    _pykadmin_gateway_buffer_init(&request);
+    _pykadmin_gateway_put_u8(&request, (uint8_t)op);
+    _pykadmin_gateway_put_field(&request, name);
+
+    if ((op == kGATEWAY_CREATE) || (op == kGATEWAY_CHPASS))
+        _pykadmin_gateway_put_field(&request, argument);
+
+    if (request.failed) {
+        _pykadmin_gateway_buffer_free(&request);
+        PyErr_SetString(PyExc_ValueError, "name or password is too long");
+        return -1;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    PyThread_acquire_lock(self->lock, WAIT_LOCK);
+
+    for (attempt = 0; attempt < 2; attempt++) {
+
+        if ((self->fd >= 0) && _pykadmin_gateway_client_stale(self))
+            _pykadmin_gateway_client_disconnect(self);
+
+        if ((self->fd < 0) && _pykadmin_gateway_client_connect(self)) {
+            error = errno;
+            break;
+        }
+
+        status = _pykadmin_gateway_send(self->fd, &request);
+        if (!status)
+            status = _pykadmin_gateway_receive(self->fd, data, &length);
+
+        if (!status)
+            break;
+
+        error = errno;
+        _pykadmin_gateway_client_disconnect(self);
+
+        // only a read is safe to send again; a write may have been applied
+        if (!_pykadmin_gateway_is_read(op))
+            break;
+    }
+
+    PyThread_release_lock(self->lock);
+    Py_END_ALLOW_THREADS
+
+    _pykadmin_gateway_buffer_free(&request);
+
+    if (status) {
+        errno = error;
+        PyErr_SetFromErrnoWithFilename(PyExc_OSError, self->path);
+        return -1;
+    }
+
+    reader->data   = *data;
+    reader->length = length;
+    reader->offset = 0;
+    reader->failed = 0;
+
+    *retval = (kadm5_ret_t)(int32_t)_pykadmin_gateway_get_u32(reader);
+
+    if (reader->failed) {
+        free(*data);
+        *data = NULL;
+        PyErr_SetString(PyExc_RuntimeError, "malformed response from the kadmin gateway");
+        return -1;
+    }
+
+    return 0;
+}
+
+/* for calls whose response is just the code */
+static PyObject *_pykadmin_gateway_client_simple(PyKAdminGatewayClient *self, int op, const char *name, const char *argument, char *caller) {
+
+    pykadmin_gateway_reader_t reader;
+    unsigned char *data = NULL;
+    kadm5_ret_t retval  = KADM5_OK;
+
+    if (_pykadmin_gateway_client_call(self, op, name, argument, &data, &reader, &retval))
+        return NULL;
+
+    free(data);
+
+    if (retval != KADM5_OK) {
+        PyKAdminError_raise_error(retval, caller);
+        return NULL;
+    }
+
+    Py_RETURN_TRUE;
+}
+
+static void PyKAdminGatewayClient_dealloc(PyKAdminGatewayClient *self) {
+
+    _pykadmin_gateway_client_disconnect(self);
+
+    if (self->lock)
+        PyThread_free_lock(self->lock);
+
+    free(self->path);
+
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *PyKAdminGatewayClient_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+
+    PyKAdminGatewayClient *self = (PyKAdminGatewayClient *)type->tp_alloc(type, 0);
+
+    if (self) {
+        self->fd   = -1;
+        self->path = NULL;
+        self->lock = NULL;
+    }
+
+    return (PyObject *)self;
+}
+
+static int PyKAdminGatewayClient_init(PyKAdminGatewayClient *self, PyObject *args, PyObject *kwds) {
+
+    static char *kwlist[] = {"path", NULL};
+
+    char *path = NULL;
+    int status = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s", kwlist, &path))
+        return -1;
+
+    if (self->path) {
+        PyErr_SetString(PyExc_ValueError, "GatewayClient is already initialized");
+        return -1;
+    }
+
+    self->path = strdup(path);
+    self->lock = PyThread_allocate_lock();
+
+    if (!self->path || !self->lock) {
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    // fail now, not on the first call, when no gateway is listening
+    Py_BEGIN_ALLOW_THREADS
+    status = _pykadmin_gateway_client_connect(self);
+    Py_END_ALLOW_THREADS
+
+    if (status) {
+        PyErr_SetFromErrnoWithFilename(PyExc_OSError, self->path);
+        return -1;
+    }
+
+    return 0;
+}
+
+static PyObject *PyKAdminGatewayClient_principal_exists(PyKAdminGatewayClient *self, PyObject *args) {
+
+    pykadmin_gateway_reader_t reader;
+    unsigned char *data = NULL;
+    kadm5_ret_t retval  = KADM5_OK;
+    char *name          = NULL;
+
+    if (!PyArg_ParseTuple(args, "s", &name))
+        return NULL;
+
+    if (_pykadmin_gateway_client_call(self, kGATEWAY_EXISTS, name, NULL, &data, &reader, &retval))
+        return NULL;
+
+    free(data);
+
+    if (retval == KADM5_OK)
+        Py_RETURN_TRUE;
+
+    if (retval == KADM5_UNK_PRINC)
+        Py_RETURN_FALSE;
+
+    PyKAdminError_raise_error(retval, "kadm5_get_principal");
+    return NULL;
+}
+
+static PyObject *PyKAdminGatewayClient_get_principal(PyKAdminGatewayClient *self, PyObject *args) {
+
+    pykadmin_gateway_reader_t reader;
+    unsigned char *data = NULL;
+    kadm5_ret_t retval  = KADM5_OK;
+    PyObject *result    = NULL;
+    char *name          = NULL;
+    char *principal     = NULL;
+    char *mod_name      = NULL;
+    char *policy        = NULL;
+    int32_t values[kGATEWAY_GET_INTS];
+    int index           = 0;
+
+    if (!PyArg_ParseTuple(args, "s", &name))
+        return NULL;
+
+    if (_pykadmin_gateway_client_call(self, kGATEWAY_GET, name, NULL, &data, &reader, &retval))
+        return NULL;
+
+    // as kadm.getprinc: None for a principal that does not exist
+    if (retval == KADM5_UNK_PRINC) {
+        free(data);
+        Py_RETURN_NONE;
+    }
+
+    if (retval != KADM5_OK) {
+        free(data);
+        PyKAdminError_raise_error(retval, "kadm5_get_principal");
+        return NULL;
+    }
+
+    principal = _pykadmin_gateway_get_field(&reader);
+    mod_name  = _pykadmin_gateway_get_field(&reader);
+    policy    = _pykadmin_gateway_get_field(&reader);
+
+    for (index = 0; index < kGATEWAY_GET_INTS; index++)
+        values[index] = (int32_t)_pykadmin_gateway_get_u32(&reader);
+
+    if (reader.failed) {
+        PyErr_SetString(PyExc_RuntimeError, "malformed response from the kadmin gateway");
+        goto cleanup;
+    }
+
+    result = Py_BuildValue("{s:z,s:z,s:z,s:i,s:i,s:i,s:i,s:i,s:i,s:i,s:i,s:i,s:i,s:i,s:i}",
+                "principal",       principal,
+                "mod_name",        mod_name,
+                "policy",          policy,
+                "expire",          values[0],
+                "last_pwd_change", values[1],
+                "pwexpire",        values[2],
+                "maxlife",         values[3],
+                "maxrenewlife",    values[4],
+                "mod_date",        values[5],
+                "attributes",      values[6],
+                "kvno",            values[7],
+                "mkvno",           values[8],
+                "last_success",    values[9],
+                "last_failure",    values[10],
+                "failures",        values[11]);
+
+cleanup:
+
+    free(principal);
+    free(mod_name);
+    free(policy);
+    free(data);
+
+    return result;
+}
+
+static PyObject *PyKAdminGatewayClient_principals(PyKAdminGatewayClient *self, PyObject *args, PyObject *kwds) {
+
+    static char *kwlist[] = {"match", NULL};
+
+    pykadmin_gateway_reader_t reader;
+    unsigned char *data = NULL;
+    kadm5_ret_t retval  = KADM5_OK;
+    PyObject *names     = NULL;
+    PyObject *item      = NULL;
+    char *match         = NULL;
+    char *name          = NULL;
+    uint32_t count      = 0;
+    uint32_t index      = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|z", kwlist, &match))
+        return NULL;
+
+    if (_pykadmin_gateway_client_call(self, kGATEWAY_LIST, match, NULL, &data, &reader, &retval))
+        return NULL;
+
+    if (retval != KADM5_OK) {
+        PyKAdminError_raise_error(retval, "kadm5_get_principals");
+        goto cleanup;
+    }
+
+    count = _pykadmin_gateway_get_u32(&reader);
+
+    names = PyList_New(0);
+    if (!names)
+        goto cleanup;
+
+    for (index = 0; !reader.failed && (index < count); index++) {
+
+        name = _pykadmin_gateway_get_field(&reader);
+        if (!name)
+            break;
+
+        item = PyUnicode_FromString(name);
+        free(name);
+
+        if (!item || PyList_Append(names, item)) {
+            Py_XDECREF(item);
+            Py_CLEAR(names);
+            goto cleanup;
+        }
+
+        Py_DECREF(item);
+    }
+
+    if (index < count) {
+        PyErr_SetString(PyExc_RuntimeError, "malformed response from the kadmin gateway");
+        Py_CLEAR(names);
+    }
+
+cleanup:
+
+    free(data);
+
+    return names;
+}
+
+static PyObject *PyKAdminGatewayClient_create_principal(PyKAdminGatewayClient *self, PyObject *args) {
+
+    char *name     = NULL;
+    char *password = NULL;
+
+    if (!PyArg_ParseTuple(args, "s|z", &name, &password))
+        return NULL;
+
+    return _pykadmin_gateway_client_simple(self, kGATEWAY_CREATE, name, password, "kadm5_create_principal");
+}
+
+static PyObject *PyKAdminGatewayClient_delete_principal(PyKAdminGatewayClient *self, PyObject *args) {
+
+    char *name = NULL;
+
+    if (!PyArg_ParseTuple(args, "s", &name))
+        return NULL;
+
+    return _pykadmin_gateway_client_simple(self, kGATEWAY_DELETE, name, NULL, "kadm5_delete_principal");
+}
+
+static PyObject *PyKAdminGatewayClient_change_password(PyKAdminGatewayClient *self, PyObject *args) {
+
+    char *name     = NULL;
+    char *password = NULL;
+
+    if (!PyArg_ParseTuple(args, "ss", &name, &password))
+        return NULL;
+
+    return _pykadmin_gateway_client_simple(self, kGATEWAY_CHPASS, name, password, "kadm5_chpass_principal");
+}
+
+static PyObject *PyKAdminGatewayClient_randomize_key(PyKAdminGatewayClient *self, PyObject *args) {
+
+    char *name = NULL;
+
+    if (!PyArg_ParseTuple(args, "s", &name))
+        return NULL;
+
+    return _pykadmin_gateway_client_simple(self, kGATEWAY_RANDKEY, name, NULL, "kadm5_randkey_principal");
+}
+
+static PyObject *PyKAdminGatewayClient_close(PyKAdminGatewayClient *self) {
+
+    if (self->lock) {
+        Py_BEGIN_ALLOW_THREADS
+        PyThread_acquire_lock(self->lock, WAIT_LOCK);
+        Py_END_ALLOW_THREADS
+    }
+
+    _pykadmin_gateway_client_disconnect(self);
+
+    if (self->lock)
+        PyThread_release_lock(self->lock);
+
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef PyKAdminGatewayClient_methods[] = {
+
+    {"principal_exists", (PyCFunction)PyKAdminGatewayClient_principal_exists, METH_VARARGS, ""},
+
+    {"getprinc",         (PyCFunction)PyKAdminGatewayClient_get_principal,    METH_VARARGS, ""},
+    {"get_principal",    (PyCFunction)PyKAdminGatewayClient_get_principal,    METH_VARARGS, ""},
+
+    {"principals",       (PyCFunction)PyKAdminGatewayClient_principals,       (METH_VARARGS | METH_KEYWORDS), ""},
+
+    {"ank",              (PyCFunction)PyKAdminGatewayClient_create_principal, METH_VARARGS, ""},
+    {"addprinc",         (PyCFunction)PyKAdminGatewayClient_create_principal, METH_VARARGS, ""},
+    {"add_principal",    (PyCFunction)PyKAdminGatewayClient_create_principal, METH_VARARGS, ""},
+
+    {"delprinc",         (PyCFunction)PyKAdminGatewayClient_delete_principal, METH_VARARGS, ""},
+    {"delete_principal", (PyCFunction)PyKAdminGatewayClient_delete_principal, METH_VARARGS, ""},
+
+    {"cpw",              (PyCFunction)PyKAdminGatewayClient_change_password,  METH_VARARGS, ""},
+    {"change_password",  (PyCFunction)PyKAdminGatewayClient_change_password,  METH_VARARGS, ""},
+
+    {"randkey",          (PyCFunction)PyKAdminGatewayClient_randomize_key,    METH_VARARGS, ""},
+    {"randomize_key",    (PyCFunction)PyKAdminGatewayClient_randomize_key,    METH_VARARGS, ""},
+
+    {"close",            (PyCFunction)PyKAdminGatewayClient_close,            METH_NOARGS, ""},
+
+    {NULL, NULL, 0, NULL}
+};
+
+PyTypeObject PyKAdminGatewayClient_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "kadmin.GatewayClient",             /*tp_name*/
+    sizeof(PyKAdminGatewayClient),             /*tp_basicsize*/
+    0,                         /*tp_itemsize*/
+    (destructor)PyKAdminGatewayClient_dealloc, /*tp_dealloc*/
+    0,                         /*tp_print*/
+    0,                         /*tp_getattr*/
+    0,                         /*tp_setattr*/
+    0,                         /*tp_compare*/
+    0,                         /*tp_repr*/
+    0,                         /*tp_as_number*/
+    0,                         /*tp_as_sequence*/
+    0,                         /*tp_as_mapping*/
+    0,                         /*tp_hash */
+    0,                         /*tp_call*/
+    0,                         /*tp_str*/
+    0,                         /*tp_getattro*/
+    0,                         /*tp_setattro*/
+    0,                         /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT,        /*tp_flags*/
+    "Thin client of a kadmin.gateway",           /* tp_doc */
+    0,                     /* tp_traverse */
+    0,                     /* tp_clear */
+    0,                     /* tp_richcompare */
+    0,                     /* tp_weaklistoffset */
+    0,                     /* tp_iter */
+    0,                     /* tp_iternext */
+    PyKAdminGatewayClient_methods,             /* tp_methods */
+    0,             /* tp_members */
+    0,                         /* tp_getset */
+    0,                         /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc)PyKAdminGatewayClient_init,      /* tp_init */
+    0,                         /* tp_alloc */
+    PyKAdminGatewayClient_new,                 /* tp_new */
+};
+
+#endif
@@ -0,0 +1,68 @@
+
+#ifndef PYKADMINGATEWAY_H
+#define PYKADMINGATEWAY_H
+
+#include <Python.h>
+#include <kadm5/admin.h>
+#include <krb5/krb5.h>
+#include <structmember.h>
+
+#include "pykadmin.h"
+#include "PyKAdminObject.h"
+
+/*
+    local gateway: one process keeps a pool of logged-in kadm5 handles and serves
+    principal operations to other processes on the same host over a unix socket, so
+    a short-lived script pays one local round trip instead of a kerberos handshake.
+
+    kadmin.gateway(path, kadm) serves until interrupted; kadmin.GatewayClient(path)
+    is the thin client. only peers running as the gateway's uid (or root) are served.
+
+    protocol, all integers big-endian:
+
+        frame       u32 length | body
+        request     u8 op | field...
+        response    i32 kadm5 code | field...
+        field       u16 length | bytes     (0xffff: none)
+
+        op          request fields          response fields (when code is 0)
+        EXISTS      name                    -
+        GET         name                    name, mod_name, policy, i32 x 12 (see kGATEWAY_GET_INTS)
+        LIST        match                   u32 count | name...
+        CREATE      name, password          -
+        DELETE      name                    -
+        CHPASS      name, password          -
+        RANDKEY     name                    -
+*/
+
+enum {
+    kGATEWAY_EXISTS = 1,
+    kGATEWAY_GET,
+    kGATEWAY_LIST,
+    kGATEWAY_CREATE,
+    kGATEWAY_DELETE,
+    kGATEWAY_CHPASS,
+    kGATEWAY_RANDKEY,
+    kGATEWAY_OP_COUNT
+};
+
+typedef struct {
+    PyObject_HEAD
+
+    char *path;
+    int fd;
+
+    // one request at a time on the connection; taken without the GIL
+    PyThread_type_lock lock;
+
+} PyKAdminGatewayClient;
+
+PyTypeObject PyKAdminGatewayClient_Type;
+
+/*
+    log pool handles in with kadm's credentials and options, then serve path until a
+    signal handler raises. returns NULL with the exception set.
+*/
+PyObject *pykadmin_gateway_serve(const char *path, PyKAdminObject *kadm, int pool, int mode);
+
+#endif
@@ -4,6 +4,7 @@
 #include "PyKAdminPrincipalObject.h"
 #include "PyKAdminPolicyObject.h"
 #include "PyKAdminErrors.h"
+#include "PyKAdminName.h"
 
 static void PyKAdminIterator_dealloc(PyKAdminIterator *self) {
       
@@ -26,7 +27,11 @@ static PyObject *PyKAdminIterator_next(PyKAdminIterator *self) {
     if (self->index < self->count) {
 
         name = self->names[self->index];
-        next = PyUnicode_FromString(name);
+
+        if (self->yield_names)
+            next = (PyObject *)PyKAdminName_create(self->kadmin, name);
+        else
+            next = PyUnicode_FromString(name);
 
         self->index++;
     }
@@ -87,11 +92,13 @@ PyKAdminIterator *PyKAdminIterator_principal_iterator(PyKAdminObject *kadmin, ch
 
         iter->count = 0x0; 
         iter->index = 0x0;
+        iter->yield_names = 0;
 
         iter->kadmin = kadmin;
         Py_INCREF(kadmin);
 
-        retval = kadm5_get_principals(kadmin->server_handle, match, &iter->names, &iter->count);
+        if (!pykadmin_replica_get_principals(kadmin->replica, match, &iter->names, &iter->count))
+            PyKAdmin_CALL(kadmin, retval, 1, kadm5_get_principals(kadmin->server_handle, match, &iter->names, &iter->count));
         if (retval != KADM5_OK) { 
             PyKAdminError_raise_error(retval, "kadm5_get_principals");
         }
@@ -110,11 +117,12 @@ PyKAdminIterator *PyKAdminIterator_policy_iterator(PyKAdminObject *kadmin, char
 
         iter->count = 0x0; 
         iter->index = 0x0;
+        iter->yield_names = 0;
 
         iter->kadmin = kadmin;
         Py_INCREF(kadmin);
 
-        retval = kadm5_get_policies(kadmin->server_handle, match, &iter->names, &iter->count);
+        PyKAdmin_CALL(kadmin, retval, 1, kadm5_get_policies(kadmin->server_handle, match, &iter->names, &iter->count));
         if (retval != KADM5_OK) { 
             PyKAdminError_raise_error(retval, "kadm5_get_policies"); 
         }
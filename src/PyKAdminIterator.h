@@ -16,6 +16,9 @@ typedef struct {
 
 	int count; 
 	char **names;
+
+	// yield kadmin.Name rather than str
+	int yield_names;
 	
 	PyKAdminObject *kadmin;
 
@@ -0,0 +1,251 @@
+#include "PyKAdminLMDB.h"
+#include "PyKAdminCommon.h"
+
+#ifdef KADMIN_LOCAL
+
+#include <profile.h>
+#include <pthread.h>
+#include <errno.h>
+
+#define kLMDB_BATCH_PER_THREAD   1024
+#define kLMDB_MAX_THREADS        64
+
+typedef struct {
+    krb5_db_entry *kdb;
+    kadm5_principal_ent_rec entry;
+    krb5_error_code code;
+} pykadmin_lmdb_item_t;
+
+typedef struct {
+    krb5_context context;
+    pykadmin_lmdb_item_t *items;
+    size_t count;
+    long mask;
+    pthread_t thread;
+    int started;
+} pykadmin_lmdb_worker_t;
+
+typedef struct {
+    pykadmin_lmdb_worker_t *workers;
+    int threads;
+    pykadmin_lmdb_item_t *items;
+    size_t count;
+    size_t batch;
+    long mask;
+    pykadmin_lmdb_entry_func func;
+    void *data;
+    krb5_error_code code;
+    int stop;
+} pykadmin_lmdb_scan_t;
+
+
+int pykadmin_lmdb_realm(krb5_context context, const char *realm) {
+
+    profile_t profile = NULL;
+    char *module      = NULL;
+    char *library     = NULL;
+    int result        = 0;
+
+    if (!context || !realm || krb5_get_profile(context, &profile))
+        return 0;
+
+    profile_get_string(profile, "realms", realm, "database_module", realm, &module);
+
+    if (module)
+        profile_get_string(profile, "dbmodules", module, "db_library", NULL, &library);
+
+    result = (library && !strcmp(library, "klmdb"));
+
+    profile_release_string(module);
+    profile_release_string(library);
+    profile_release(profile);
+
+    return result;
+}
+
+/* runs without the GIL and touches nothing but its own slice and context */
+static void *_pykadmin_lmdb_convert_slice(void *data) {
+
+    pykadmin_lmdb_worker_t *worker = (pykadmin_lmdb_worker_t *)data;
+    pykadmin_lmdb_item_t *item     = NULL;
+    size_t index = 0;
+
+    for (; index < worker->count; index++) {
+
+        item = &worker->items[index];
+        item->code = pykadmin_kadm_from_kdb_context(worker->context, item->kdb, &item->entry, worker->mask);
+
+        krb5_dbe_free(worker->context, item->kdb);
+        item->kdb = NULL;
+    }
+
+    return NULL;
+}
+
+/* convert items[0, count) as contiguous slices, one per worker; the caller converts the first */
+static void _pykadmin_lmdb_convert_batch(pykadmin_lmdb_scan_t *scan) {
+
+    pykadmin_lmdb_worker_t *workers = scan->workers;
+    size_t per_thread = (scan->count + scan->threads - 1) / scan->threads;
+    size_t start      = 0;
+    int index         = 0;
+
+    for (; index < scan->threads; index++) {
+
+        workers[index].items   = scan->items + start;
+        workers[index].count   = (start < scan->count) ? ((scan->count - start < per_thread) ? scan->count - start : per_thread) : 0;
+        workers[index].mask    = scan->mask;
+        workers[index].started = 0;
+
+        start += workers[index].count;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+
+    for (index = 1; index < scan->threads; index++) {
+
+        if (!workers[index].count)
+            continue;
+
+        workers[index].started = !pthread_create(&workers[index].thread, NULL, _pykadmin_lmdb_convert_slice, &workers[index]);
+
+        // no thread to be had, convert the slice here instead
+        if (!workers[index].started)
+            _pykadmin_lmdb_convert_slice(&workers[index]);
+    }
+
+    _pykadmin_lmdb_convert_slice(&workers[0]);
+
+    for (index = 1; index < scan->threads; index++) {
+        if (workers[index].started)
+            pthread_join(workers[index].thread, NULL);
+    }
+
+    Py_END_ALLOW_THREADS
+}
+
+/* convert and hand back what has been collected; whatever is left after a stop is freed here */
+static void _pykadmin_lmdb_flush(pykadmin_lmdb_scan_t *scan) {
+
+    pykadmin_lmdb_item_t *item = NULL;
+    size_t index = 0;
+
+    if (!scan->count)
+        return;
+
+    _pykadmin_lmdb_convert_batch(scan);
+
+    for (index = 0; index < scan->count; index++) {
+
+        item = &scan->items[index];
+
+        if (!scan->stop && item->code) {
+            scan->code = item->code;
+            scan->stop = 1;
+        }
+
+        if (!scan->stop)
+            scan->stop = scan->func(scan->data, &item->entry);
+
+        pykadmin_free_kadm_ent_rec(scan->workers[0].context, &item->entry);
+    }
+
+    scan->count = 0;
+}
+
+/*
+    krb5_db_iterate callback: takes the entry over. the module frees what it handed us
+    once this returns, so its fields move into an entry of our own and it is left empty.
+*/
+static int _pykadmin_lmdb_collect(void *data, krb5_db_entry *kdb) {
+
+    pykadmin_lmdb_scan_t *scan = (pykadmin_lmdb_scan_t *)data;
+    pykadmin_lmdb_item_t *item = &scan->items[scan->count];
+
+    item->kdb = malloc(sizeof(krb5_db_entry));
+    if (!item->kdb) {
+        scan->code = ENOMEM;
+        scan->stop = 1;
+        return 1;
+    }
+
+    memcpy(item->kdb, kdb, sizeof(krb5_db_entry));
+    memset(kdb, 0, sizeof(krb5_db_entry));
+
+    memset(&item->entry, 0, sizeof(kadm5_principal_ent_rec));
+    item->code = 0;
+
+    if (++scan->count == scan->batch)
+        _pykadmin_lmdb_flush(scan);
+
+    return scan->stop;
+}
+
+krb5_error_code pykadmin_lmdb_iterate(krb5_context context, char *match, int threads, long mask, pykadmin_lmdb_entry_func func, void *data) {
+
+    pykadmin_lmdb_scan_t scan;
+    krb5_error_code code = 0;
+    size_t index = 0;
+    int i        = 0;
+
+    if (threads < 1)
+        threads = 1;
+
+    if (threads > kLMDB_MAX_THREADS)
+        threads = kLMDB_MAX_THREADS;
+
+    memset(&scan, 0, sizeof(scan));
+
+    scan.threads = threads;
+    scan.batch   = (size_t)threads * kLMDB_BATCH_PER_THREAD;
+    scan.mask    = mask;
+    scan.func    = func;
+    scan.data    = data;
+    scan.workers = calloc(threads, sizeof(pykadmin_lmdb_worker_t));
+    scan.items   = calloc(scan.batch, sizeof(pykadmin_lmdb_item_t));
+
+    if (!scan.workers || !scan.items) {
+        code = ENOMEM;
+        goto cleanup;
+    }
+
+    // krb5 contexts are not shared between threads
+    for (i = 0; i < threads; i++) {
+        if ((code = krb5_init_context(&scan.workers[i].context)))
+            goto cleanup;
+    }
+
+    code = krb5_db_iterate(context, match, _pykadmin_lmdb_collect, (void *)&scan
+#if (KRB5_KDB_API_VERSION >= 8)
+        , 0 /* flags */
+#endif
+    );
+
+    // the remainder of the last batch
+    if (!scan.stop && !code)
+        _pykadmin_lmdb_flush(&scan);
+
+    // a stop (ours or the callee's) comes back from krb5_db_iterate as the callback's result
+    if (scan.stop)
+        code = scan.code;
+
+cleanup:
+
+    // collected but never converted, after a failed iteration
+    for (index = 0; scan.items && (index < scan.count); index++)
+        krb5_dbe_free(context, scan.items[index].kdb);
+
+    if (scan.workers) {
+        for (i = 0; i < threads; i++) {
+            if (scan.workers[i].context)
+                krb5_free_context(scan.workers[i].context);
+        }
+    }
+
+    free(scan.workers);
+    free(scan.items);
+
+    return code;
+}
+
+#endif
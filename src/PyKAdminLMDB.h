@@ -0,0 +1,27 @@
+#ifndef PYKADMINLMDB_H
+#define PYKADMINLMDB_H
+
+#include <kdb.h>
+#include <kadm5/admin.h>
+#include <krb5/krb5.h>
+
+/*
+    threaded scans of realms whose KDB uses the klmdb backend.
+
+    the walk itself stays krb5_db_iterate's: the klmdb module reads one snapshot through
+    the environment it already has open, and lmdb does not allow a second environment on
+    the same files in one process (opening one can reset the lock table, closing one drops
+    the process's fcntl locks). entries the module hands over are collected in batches and
+    converted to kadm5 entries on several threads, then handed back in key order.
+*/
+
+/* called with the GIL held; the callee may take the contents of entry, leaving it zeroed. nonzero stops the walk */
+typedef int (*pykadmin_lmdb_entry_func)(void *data, kadm5_principal_ent_rec *entry);
+
+/* 1 when the realm's database_module is klmdb */
+int pykadmin_lmdb_realm(krb5_context context, const char *realm);
+
+/* krb5_db_iterate on context, converting on threads threads. call with the GIL held and kadm5_lock as the caller's lock mode wants it */
+krb5_error_code pykadmin_lmdb_iterate(krb5_context context, char *match, int threads, long mask, pykadmin_lmdb_entry_func func, void *data);
+
+#endif
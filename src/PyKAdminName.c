@@ -0,0 +1,215 @@
+
+#include "PyKAdminName.h"
+#include "PyKAdminErrors.h"
+#include "PyKAdminCommon.h"
+
+
+static void PyKAdminName_dealloc(PyKAdminName *self) {
+
+    if (self->principal)
+        krb5_free_principal(self->kadmin->context, self->principal);
+
+    Py_XDECREF(self->unparsed);
+    Py_XDECREF(self->kadmin);
+
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *PyKAdminName_str(PyKAdminName *self) {
+    Py_INCREF(self->unparsed);
+    return self->unparsed;
+}
+
+static PyObject *PyKAdminName_repr(PyKAdminName *self) {
+    return PyUnicode_FromFormat("kadmin.Name(%R)", self->unparsed);
+}
+
+static Py_hash_t PyKAdminName_hash(PyKAdminName *self) {
+    return PyObject_Hash(self->unparsed);
+}
+
+static PyObject *PyKAdminName_RichCompare(PyObject *o1, PyObject *o2, int opid) {
+
+    PyKAdminName *a  = (PyKAdminName *)o1;
+    PyObject *result = Py_NotImplemented;
+    int equal        = 0;
+
+    if ((opid != Py_EQ) && (opid != Py_NE)) {
+        Py_INCREF(result);
+        return result;
+    }
+
+    if (PyKAdminName_CheckExact(o2)) {
+        equal = krb5_principal_compare(a->kadmin->context, a->principal, ((PyKAdminName *)o2)->principal);
+    } else if (PyUnicodeBytes_Check(o2)) {
+        return PyObject_RichCompare(a->unparsed, o2, opid);
+    } else {
+        Py_INCREF(result);
+        return result;
+    }
+
+    result = ((opid == Py_EQ) == (equal != 0)) ? Py_True : Py_False;
+
+    Py_INCREF(result);
+    return result;
+}
+
+static PyObject *PyKAdminName_get_realm(PyKAdminName *self, void *closure) {
+
+    return PyUnicode_FromStringAndSize(self->principal->realm.data, self->principal->realm.length);
+}
+
+
+static PyGetSetDef PyKAdminName_getters_setters[] = {
+    {"realm", (getter)PyKAdminName_get_realm, NULL, "realm of the principal", NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+PyTypeObject PyKAdminName_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "kadmin.Name",             /*tp_name*/
+    sizeof(PyKAdminName),             /*tp_basicsize*/
+    0,                         /*tp_itemsize*/
+    (destructor)PyKAdminName_dealloc, /*tp_dealloc*/
+    0,                         /*tp_print*/
+    0,                         /*tp_getattr*/
+    0,                         /*tp_setattr*/
+    0,                         /*tp_compare*/
+    (reprfunc)PyKAdminName_repr,       /*tp_repr*/
+    0,                         /*tp_as_number*/
+    0,                         /*tp_as_sequence*/
+    0,                         /*tp_as_mapping*/
+    (hashfunc)PyKAdminName_hash,       /*tp_hash */
+    0,                         /*tp_call*/
+    (reprfunc)PyKAdminName_str,        /*tp_str*/
+    0,                         /*tp_getattro*/
+    0,                         /*tp_setattro*/
+    0,                         /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT,        /*tp_flags*/
+    "Pre-parsed principal name",           /* tp_doc */
+    0,                     /* tp_traverse */
+    0,                     /* tp_clear */
+    PyKAdminName_RichCompare,          /* tp_richcompare */
+    0,                     /* tp_weaklistoffset */
+    0,                     /* tp_iter */
+    0,                     /* tp_iternext */
+    0,                     /* tp_methods */
+    0,                     /* tp_members */
+    PyKAdminName_getters_setters,      /* tp_getset */
+    0,                         /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    0,                         /* tp_init */
+    0,                         /* tp_alloc */
+    0,                         /* tp_new */
+};
+
+
+PyKAdminName *PyKAdminName_create(PyKAdminObject *kadmin, const char *name) {
+
+    krb5_error_code code = 0;
+    char *unparsed       = NULL;
+    PyKAdminName *self   = NULL;
+
+    self = PyObject_New(PyKAdminName, &PyKAdminName_Type);
+    if (!self)
+        return NULL;
+
+    Py_INCREF(kadmin);
+    self->kadmin    = kadmin;
+    self->principal = NULL;
+    self->unparsed  = NULL;
+
+    code = krb5_parse_name(kadmin->context, name, &self->principal);
+    if (code) {
+        PyKAdminError_raise_error(code, "krb5_parse_name");
+        goto error;
+    }
+
+    // keep the canonical form (realm added) rather than the input
+    code = krb5_unparse_name(kadmin->context, self->principal, &unparsed);
+    if (code) {
+        PyKAdminError_raise_error(code, "krb5_unparse_name");
+        goto error;
+    }
+
+    self->unparsed = PyUnicode_FromString(unparsed);
+    krb5_free_unparsed_name(kadmin->context, unparsed);
+
+    if (!self->unparsed)
+        goto error;
+
+    return self;
+
+error:
+    Py_DECREF(self);
+    return NULL;
+}
+
+int PyKAdminName_principal(PyKAdminObject *kadmin, PyObject *object, krb5_principal *principal, int *owned) {
+
+    krb5_error_code code = 0;
+    char *name = NULL;
+
+    *principal = NULL;
+    *owned     = 0;
+
+    if (PyKAdminName_CheckExact(object)) {
+        *principal = ((PyKAdminName *)object)->principal;
+        return 0;
+    }
+
+    if (!PyUnicodeBytes_Check(object)) {
+        PyErr_SetString(PyExc_TypeError, "principal must be str or kadmin.Name");
+        return -1;
+    }
+
+    name = PyUnicode_or_PyBytes_asCString(object);
+    if (!name) {
+        if (!PyErr_Occurred())
+            PyErr_NoMemory();
+        return -1;
+    }
+
+    code = krb5_parse_name(kadmin->context, name, principal);
+    free(name);
+
+    if (code) {
+        PyKAdminError_raise_error(code, "krb5_parse_name");
+        return -1;
+    }
+
+    *owned = 1;
+
+    return 0;
+}
+
+void PyKAdminName_release_principal(PyKAdminObject *kadmin, krb5_principal principal, int owned) {
+
+    if (owned && principal)
+        krb5_free_principal(kadmin->context, principal);
+}
+
+int PyKAdminName_copy_principal(PyKAdminObject *kadmin, PyObject *object, krb5_principal *principal) {
+
+    krb5_error_code code = 0;
+    int owned = 0;
+
+    if (PyKAdminName_principal(kadmin, object, principal, &owned))
+        return -1;
+
+    if (!owned) {
+
+        code = krb5_copy_principal(kadmin->context, *principal, principal);
+
+        if (code) {
+            *principal = NULL;
+            PyKAdminError_raise_error(code, "krb5_copy_principal");
+            return -1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,49 @@
+
+#ifndef PYKADMINNAME_H
+#define PYKADMINNAME_H
+
+#include <Python.h>
+#include <kadm5/admin.h>
+#include <krb5/krb5.h>
+#include <stdio.h>
+#include <string.h>
+#include <structmember.h>
+
+#include "pykadmin.h"
+#include "PyKAdminObject.h"
+
+/*
+    pre-parsed principal name.
+
+    holds the krb5_principal together with its unparsed str so that APIs taking a
+    principal skip krb5_parse_name and the free that follows. compares and hashes
+    like the unparsed str, so it can be used interchangeably as a dict/set key.
+*/
+
+typedef struct {
+    PyObject_HEAD
+
+    PyKAdminObject *kadmin;
+    krb5_principal principal;
+    PyObject *unparsed;
+
+} PyKAdminName;
+
+PyTypeObject PyKAdminName_Type;
+
+#define PyKAdminName_CheckExact(obj) (Py_TYPE(obj) == &PyKAdminName_Type)
+
+PyKAdminName *PyKAdminName_create(PyKAdminObject *kadmin, const char *name);
+
+/*
+    principal for a kadmin.Name, str or bytes argument. a Name's principal is borrowed
+    (*owned = 0), otherwise the name is parsed (*owned = 1). returns 0, or -1 with an
+    exception set. release with PyKAdminName_release_principal.
+*/
+int PyKAdminName_principal(PyKAdminObject *kadmin, PyObject *object, krb5_principal *principal, int *owned);
+void PyKAdminName_release_principal(PyKAdminObject *kadmin, krb5_principal principal, int owned);
+
+/* as above, but always an owned copy (for kadm5 entries that free their principal) */
+int PyKAdminName_copy_principal(PyKAdminObject *kadmin, PyObject *object, krb5_principal *principal);
+
+#endif
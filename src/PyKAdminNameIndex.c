@@ -0,0 +1,313 @@
+
+#include "PyKAdminNameIndex.h"
+#include "PyKAdminCommon.h"
+#include "PyKAdminName.h"
+
+#define kNAMEINDEX_MIN_CAPACITY 64
+
+/* slot holding name, or the empty slot where it belongs */
+static char **_pykadmin_nameindex_slot(char **slots, size_t capacity, const char *name) {
+
+    size_t mask  = capacity - 1;
+    size_t index = pykadmin_string_hash(name) & mask;
+
+    while (slots[index] && strcmp(slots[index], name))
+        index = (index + 1) & mask;
+
+    return &slots[index];
+}
+
+static int _pykadmin_nameindex_resize(PyKAdminNameIndex *self, size_t capacity) {
+
+    char **slots = calloc(capacity, sizeof(char *));
+    size_t index = 0;
+
+    if (!slots)
+        return -1;
+
+    for (; index < self->capacity; index++) {
+        if (self->slots[index])
+            *_pykadmin_nameindex_slot(slots, capacity, self->slots[index]) = self->slots[index];
+    }
+
+    free(self->slots);
+
+    self->slots = slots;
+    self->capacity = capacity;
+
+    return 0;
+}
+
+int PyKAdminNameIndex_add(PyKAdminNameIndex *self, const char *name) {
+
+    char **slot = NULL;
+
+    // keep the load factor under 1/2
+    if (((self->count + 1) * 2) > self->capacity) {
+        if (_pykadmin_nameindex_resize(self, self->capacity * 2)) {
+            PyErr_NoMemory();
+            return -1;
+        }
+    }
+
+    slot = _pykadmin_nameindex_slot(self->slots, self->capacity, name);
+
+    if (!*slot) {
+
+        *slot = strdup(name);
+
+        if (!*slot) {
+            PyErr_NoMemory();
+            return -1;
+        }
+
+        self->count++;
+    }
+
+    return 0;
+}
+
+int PyKAdminNameIndex_contains_name(PyKAdminNameIndex *self, const char *name) {
+    return (*_pykadmin_nameindex_slot(self->slots, self->capacity, name) != NULL);
+}
+
+
+static void PyKAdminNameIndex_dealloc(PyKAdminNameIndex *self) {
+
+    size_t index = 0;
+
+    if (self->slots) {
+
+        for (; index < self->capacity; index++)
+            free(self->slots[index]);
+
+        free(self->slots);
+    }
+
+    Py_TYPE(self)->tp_free((PyObject *)self);
+}
+
+static PyObject *PyKAdminNameIndex_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+
+    PyKAdminNameIndex *self = (PyKAdminNameIndex *)type->tp_alloc(type, 0);
+
+    if (self) {
+
+        self->count = 0;
+        self->capacity = kNAMEINDEX_MIN_CAPACITY;
+        self->slots = calloc(self->capacity, sizeof(char *));
+
+        if (!self->slots) {
+            Py_DECREF(self);
+            return PyErr_NoMemory();
+        }
+    }
+
+    return (PyObject *)self;
+}
+
+static PyObject *PyKAdminNameIndex_add_name(PyKAdminNameIndex *self, PyObject *name);
+
+// a kadmin.Name stands for its unparsed str
+static PyObject *_pykadmin_name_index_key(PyObject *name) {
+    return PyKAdminName_CheckExact(name) ? ((PyKAdminName *)name)->unparsed : name;
+}
+
+static int PyKAdminNameIndex_init(PyKAdminNameIndex *self, PyObject *args, PyObject *kwds) {
+
+    PyObject *names    = NULL;
+    PyObject *iterator = NULL;
+    PyObject *item     = NULL;
+    PyObject *added    = NULL;
+
+    if (!PyArg_ParseTuple(args, "|O", &names))
+        return -1;
+
+    if (names) {
+
+        iterator = PyObject_GetIter(names);
+        if (!iterator)
+            return -1;
+
+        while ((item = PyIter_Next(iterator))) {
+
+            added = PyKAdminNameIndex_add_name(self, item);
+            Py_DECREF(item);
+
+            if (!added)
+                break;
+
+            Py_DECREF(added);
+        }
+
+        Py_DECREF(iterator);
+
+        if (PyErr_Occurred())
+            return -1;
+    }
+
+    return 0;
+}
+
+static PyObject *PyKAdminNameIndex_add_name(PyKAdminNameIndex *self, PyObject *name) {
+
+    char *cname = NULL;
+    int result  = 0;
+
+    name = _pykadmin_name_index_key(name);
+
+    if (!PyUnicodeBytes_Check(name)) {
+        PyErr_SetString(PyExc_TypeError, "principal names must be str");
+        return NULL;
+    }
+
+    // a failed encode (non-ascii str) has already set its own error; only strdup fails silently
+    cname = PyUnicode_or_PyBytes_asCString(name);
+    if (!cname)
+        return PyErr_Occurred() ? NULL : PyErr_NoMemory();
+
+    result = PyKAdminNameIndex_add(self, cname);
+    free(cname);
+
+    if (result)
+        return NULL;
+
+    Py_RETURN_NONE;
+}
+
+static Py_ssize_t PyKAdminNameIndex_length(PyKAdminNameIndex *self) {
+    return (Py_ssize_t)self->count;
+}
+
+static int PyKAdminNameIndex_contains(PyKAdminNameIndex *self, PyObject *name) {
+
+    char *cname = NULL;
+    int result  = 0;
+
+    name = _pykadmin_name_index_key(name);
+
+    if (!PyUnicodeBytes_Check(name))
+        return 0;
+
+    cname = PyUnicode_or_PyBytes_asCString(name);
+    if (!cname) {
+        if (!PyErr_Occurred())
+            PyErr_NoMemory();
+        return -1;
+    }
+
+    result = PyKAdminNameIndex_contains_name(self, cname);
+    free(cname);
+
+    return result;
+}
+
+static PyObject *PyKAdminNameIndex_iter(PyKAdminNameIndex *self) {
+
+    PyObject *names    = PyList_New(0);
+    PyObject *name     = NULL;
+    PyObject *iterator = NULL;
+    size_t index       = 0;
+
+    if (!names)
+        return NULL;
+
+    for (; index < self->capacity; index++) {
+
+        if (self->slots[index]) {
+
+            name = PyUnicode_FromString(self->slots[index]);
+
+            if (!name || PyList_Append(names, name)) {
+                Py_XDECREF(name);
+                Py_DECREF(names);
+                return NULL;
+            }
+
+            Py_DECREF(name);
+        }
+    }
+
+    iterator = PyObject_GetIter(names);
+    Py_DECREF(names);
+
+    return iterator;
+}
+
+
+static PySequenceMethods PyKAdminNameIndex_sequence = {
+    (lenfunc)PyKAdminNameIndex_length,      /* sq_length */
+    0,                                      /* sq_concat */
+    0,                                      /* sq_repeat */
+    0,                                      /* sq_item */
+    0,                                      /* sq_slice */
+    0,                                      /* sq_ass_item */
+    0,                                      /* sq_ass_slice */
+    (objobjproc)PyKAdminNameIndex_contains, /* sq_contains */
+};
+
+static PyMethodDef PyKAdminNameIndex_methods[] = {
+    {"add", (PyCFunction)PyKAdminNameIndex_add_name, METH_O, "add(name)\n\tAdd a principal name to the index."},
+    {NULL, NULL, 0, NULL}
+};
+
+PyTypeObject PyKAdminNameIndex_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "kadmin.NameIndex",             /*tp_name*/
+    sizeof(PyKAdminNameIndex),             /*tp_basicsize*/
+    0,                         /*tp_itemsize*/
+    (destructor)PyKAdminNameIndex_dealloc, /*tp_dealloc*/
+    0,                         /*tp_print*/
+    0,                         /*tp_getattr*/
+    0,                         /*tp_setattr*/
+    0,                         /*tp_compare*/
+    0,                         /*tp_repr*/
+    0,                         /*tp_as_number*/
+    &PyKAdminNameIndex_sequence, /*tp_as_sequence*/
+    0,                         /*tp_as_mapping*/
+    0,                         /*tp_hash */
+    0,                         /*tp_call*/
+    0,                         /*tp_str*/
+    0,                         /*tp_getattro*/
+    0,                         /*tp_setattro*/
+    0,                         /*tp_as_buffer*/
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_ITER, /*tp_flags*/
+    "Set of principal names held in C",           /* tp_doc */
+    0,                     /* tp_traverse */
+    0,                     /* tp_clear */
+    0,                     /* tp_richcompare */
+    0,                     /* tp_weaklistoffset */
+    (getiterfunc)PyKAdminNameIndex_iter,     /* tp_iter */
+    0,                     /* tp_iternext */
+    PyKAdminNameIndex_methods,             /* tp_methods */
+    0,             /* tp_members */
+    0,                         /* tp_getset */
+    0,                         /* tp_base */
+    0,                         /* tp_dict */
+    0,                         /* tp_descr_get */
+    0,                         /* tp_descr_set */
+    0,                         /* tp_dictoffset */
+    (initproc)PyKAdminNameIndex_init,      /* tp_init */
+    0,                         /* tp_alloc */
+    PyKAdminNameIndex_new,                 /* tp_new */
+};
+
+
+PyKAdminNameIndex *PyKAdminNameIndex_create(size_t hint) {
+
+    PyKAdminNameIndex *index = (PyKAdminNameIndex *)PyKAdminNameIndex_new(&PyKAdminNameIndex_Type, NULL, NULL);
+    size_t capacity = kNAMEINDEX_MIN_CAPACITY;
+
+    if (index && hint) {
+
+        while (capacity < (hint * 2))
+            capacity *= 2;
+
+        if ((capacity != index->capacity) && _pykadmin_nameindex_resize(index, capacity)) {
+            Py_DECREF(index);
+            index = (PyKAdminNameIndex *)PyErr_NoMemory();
+        }
+    }
+
+    return index;
+}
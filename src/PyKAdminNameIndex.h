@@ -0,0 +1,37 @@
+
+#ifndef PYKADMINNAMEINDEX_H
+#define PYKADMINNAMEINDEX_H
+
+#include <Python.h>
+#include <stdio.h>
+#include <string.h>
+#include <structmember.h>
+
+#include "pykadmin.h"
+
+/*
+    set of unparsed principal names kept in C.
+
+    filled directly by scans (each_principal(into=kadmin.NameIndex)) and by listings
+    without creating a python object per entry; membership tests hash the C string.
+*/
+
+typedef struct {
+    PyObject_HEAD
+
+    size_t count;
+    size_t capacity;
+    char **slots;
+
+} PyKAdminNameIndex;
+
+PyTypeObject PyKAdminNameIndex_Type;
+
+#define PyKAdminNameIndex_CheckExact(obj) (Py_TYPE(obj) == &PyKAdminNameIndex_Type)
+
+PyKAdminNameIndex *PyKAdminNameIndex_create(size_t hint);
+
+int PyKAdminNameIndex_add(PyKAdminNameIndex *self, const char *name);
+int PyKAdminNameIndex_contains_name(PyKAdminNameIndex *self, const char *name);
+
+#endif
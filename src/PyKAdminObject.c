@@ -4,29 +4,234 @@
 #include "PyKAdminIterator.h"
 #include "PyKAdminPrincipalObject.h"
 #include "PyKAdminPolicyObject.h"
+#include "PyKAdminNameIndex.h"
+#include "PyKAdminName.h"
+#include "PyKAdminLMDB.h"
+#include "PyKAdminRenewal.h"
+#include "PyKAdminCommitQueue.h"
+
+#ifdef KADMIN_LOCAL
+#include <unistd.h>
+#endif
 
 #include "PyKAdminCommon.h"
 
+#include <pthread.h>
+#include <math.h>
+
+PyObject *pykadmin_each_stop = NULL;
+
+unsigned long pykadmin_fork_generation = 0;
+
+#ifdef KADMIN_LOCAL
+int pykadmin_shared_context_enabled = 0;
+#else
+int pykadmin_shared_context_enabled = 1;
+#endif
+
+static krb5_context pykadmin_shared_context = NULL;
+static char *pykadmin_shared_realm = NULL;
+static long pykadmin_shared_context_refs = 0;
+
+/* context and default realm for a new handle; the GIL serializes the refcount */
+static krb5_error_code _pykadmin_context_acquire(PyKAdminObject *self) {
+
+    krb5_error_code code = 0;
+
+    if (!pykadmin_shared_context_enabled) {
+
+        code = kadm5_init_krb5_context(&self->context);
+
+        // attempt to load the default realm 
+        if (!code && krb5_get_default_realm(self->context, &self->realm))
+            self->realm = NULL;
+
+        return code;
+    }
+
+    if (!pykadmin_shared_context) {
+
+        code = kadm5_init_krb5_context(&pykadmin_shared_context);
+        if (code) {
+            pykadmin_shared_context = NULL;
+            return code;
+        }
+
+        if (krb5_get_default_realm(pykadmin_shared_context, &pykadmin_shared_realm))
+            pykadmin_shared_realm = NULL;
+    }
+
+    pykadmin_shared_context_refs++;
+
+    self->context        = pykadmin_shared_context;
+    self->shared_context = 1;
+
+    // each handle still owns (and frees) its realm string
+    if (pykadmin_shared_realm)
+        self->realm = strdup(pykadmin_shared_realm);
+
+    return 0;
+}
+
+static void _pykadmin_context_release(PyKAdminObject *self) {
+
+    if (!self->context)
+        return;
+
+    if (!self->shared_context) {
+        krb5_free_context(self->context);
+    } else if (--pykadmin_shared_context_refs == 0) {
+
+        if (pykadmin_shared_realm)
+            krb5_free_default_realm(pykadmin_shared_context, pykadmin_shared_realm);
+        krb5_free_context(pykadmin_shared_context);
+
+        pykadmin_shared_realm   = NULL;
+        pykadmin_shared_context = NULL;
+    }
+
+    self->context = NULL;
+}
+
+/* move to another admin server (a named one, or the best standby); GIL held */
+static kadm5_ret_t _pykadmin_failover(PyKAdminObject *self, const char *admin_server) {
+
+    kadm5_ret_t retval = KADM5_OK;
+
+    if (self->call_lock) {
+        Py_BEGIN_ALLOW_THREADS
+        PyThread_acquire_lock(self->call_lock, WAIT_LOCK);
+        Py_END_ALLOW_THREADS
+    }
+
+    retval = pykadmin_failover_select(self->failover, self->session, &self->options, admin_server);
+
+    // the old server's handle stays with it as a standby
+    self->server_handle = pykadmin_failover_active(self->failover)->server_handle;
+
+    if (self->call_lock)
+        PyThread_release_lock(self->call_lock);
+
+    return retval;
+}
+
+/* get the primary ready for a write, or promote another server (a named one, or the best standby); GIL held */
+static kadm5_ret_t _pykadmin_failover_writer(PyKAdminObject *self, int promote, const char *admin_server) {
+
+    kadm5_ret_t retval = KADM5_OK;
+
+    if (self->call_lock) {
+        Py_BEGIN_ALLOW_THREADS
+        PyThread_acquire_lock(self->call_lock, WAIT_LOCK);
+        Py_END_ALLOW_THREADS
+    }
+
+    if (promote)
+        retval = pykadmin_failover_promote(self->failover, self->session, &self->options, admin_server);
+    else
+        retval = pykadmin_failover_writer(self->failover, self->session, &self->options);
+
+    // logging the primary in again replaces its handle, which may be the active one's too
+    self->server_handle = pykadmin_failover_active(self->failover)->server_handle;
+
+    if (self->call_lock)
+        PyThread_release_lock(self->call_lock);
+
+    return retval;
+}
+
+/*
+    forget the kadmind session (or database lock) a handle inherited across fork without
+    closing it; it still belongs to the parent. the handle is stale until it logs in again.
+*/
+static void _pykadmin_abandon(PyKAdminObject *self) {
+
+    self->server_handle = NULL;
+    self->locked = 0;
+
+    if (self->failover)
+        pykadmin_failover_abandon(self->failover);
+
+    // a thread that did not survive the fork may have held it
+    if (self->call_lock) {
+        PyThread_free_lock(self->call_lock);
+        self->call_lock = PyThread_allocate_lock();
+    }
+
+    self->generation = pykadmin_fork_generation;
+    self->stale = 1;
+}
+
+/* PyKAdminObject_reconnect for methods that use server_handle directly; 0, or -1 with an exception set */
+static int _pykadmin_ready(PyKAdminObject *self) {
+
+    kadm5_ret_t retval = KADM5_OK;
+
+    if (!PyKAdminObject_STALE(self))
+        return 0;
+
+    retval = PyKAdminObject_reconnect(self);
+    if (retval == KADM5_OK)
+        return 0;
+
+    PyKAdminError_raise_error(retval, self->session ? (char *)pykadmin_session_caller(self->session) : "kadm5_init");
+    return -1;
+}
+
 static void PyKAdminObject_dealloc(PyKAdminObject *self) {
     
     kadm5_ret_t retval;
 
     if (self) {
 
+        if (self->generation != pykadmin_fork_generation)
+            _pykadmin_abandon(self);
+
+        pykadmin_renewal_unregister(self);
+
+        // before the handle it writes through goes away
+        pykadmin_commit_queue_destroy(self->commits);
+        self->commits = NULL;
+
         if (self->locked)
             krb5_db_unlock(self->context);
 
+        pykadmin_cache_destroy(self->context, self->cache);
+        self->cache = NULL;
+
+        pykadmin_policy_table_destroy(self->server_handle, self->policies);
+        self->policies = NULL;
+
+        // the active server's kadm5 handle belongs to the failover set
+        if (self->failover) {
+            pykadmin_failover_destroy(self->failover);
+            self->failover = NULL;
+            self->server_handle = NULL;
+        }
+
         if (self->server_handle) {
             retval = kadm5_destroy(self->server_handle);
             if (retval != KADM5_OK) {
             }
             self->server_handle = NULL;
         }
+
         
-        if (self->context) {
-            krb5_free_context(self->context);
-            self->context = NULL;
-        }
+        pykadmin_session_destroy(self->session);
+        self->session = NULL;
+
+        pykadmin_replica_close(self->replica);
+        self->replica = NULL;
+
+        pykadmin_options_clear(&self->options);
+
+        Py_XDECREF(self->controller);
+        self->controller = NULL;
+
+        if (self->call_lock)
+            PyThread_free_lock(self->call_lock);
+
+        _pykadmin_context_release(self);
 
         if (self->realm) {
             free(self->realm);
@@ -40,13 +245,12 @@ static PyObject *PyKAdminObject_new(PyTypeObject *type, PyObject *args, PyObject
 
     PyKAdminObject *self = NULL;
     kadm5_ret_t retval   = KADM5_OK;
-    krb5_error_code code = 0;
 
     self = (PyKAdminObject *)type->tp_alloc(type, 0);
 
     if (self) {
 
-        retval = kadm5_init_krb5_context(&self->context);
+        retval = _pykadmin_context_acquire(self);
         if (retval != KADM5_OK) { 
             PyKAdminError_raise_error(retval, "kadm5_init_krb5_context");
             Py_TYPE(self)->tp_free((PyObject *)self);
@@ -55,16 +259,24 @@ static PyObject *PyKAdminObject_new(PyTypeObject *type, PyObject *args, PyObject
         }
 
         self->server_handle = NULL;
+        self->session = NULL;
+        self->failover = NULL;
+        self->replica = NULL;
+        self->commits = NULL;
 
-        // attempt to load the default realm 
-        code = krb5_get_default_realm(self->context, &self->realm);
+        self->generation = pykadmin_fork_generation;
+        self->stale = 0;
 
-        /*if (code) { 
-            PyKAdminError_raise_krb5_error(code, "krb5_get_default_realm");
+        if (pykadmin_options_copy(&self->options, &pykadmin_default_options)) {
+            PyErr_NoMemory();
+            Py_DECREF(self);
+            self = NULL;
             goto cleanup;
-        }*/
+        }
 
         self->_storage = PyDict_New();
+        self->cache = NULL;
+        self->policies = NULL;
         self->locked = 0;
     }
 
@@ -82,27 +294,31 @@ static int PyKAdminObject_init(PyKAdminObject *self, PyObject *args, PyObject *k
 static PyObject *PyKAdminObject_principal_exists(PyKAdminObject *self, PyObject *args, PyObject *kwds) {
 
     kadm5_ret_t retval = KADM5_OK;
-    krb5_error_code code = 0;
     krb5_principal princ = NULL;
+    int owned = 0;
 
-    char *client_name = NULL;
+    PyObject *name = NULL;
     PyObject *result = Py_False;
 
     kadm5_principal_ent_rec entry;
     int entry_initialized = 0;
 
-    if (!PyArg_ParseTuple(args, "s", &client_name))
+    if (!PyArg_ParseTuple(args, "O", &name))
+        return NULL;
+
+    // an inherited handle whose login failed has none; don't skip the call silently
+    if (_pykadmin_ready(self))
         return NULL;
 
     if (self->server_handle) {
 
-        code = krb5_parse_name(self->context, client_name, &princ);
-        if (code) { 
-            PyKAdminError_raise_error(code, "krb5_parse_name");
+        if (PyKAdminName_principal(self, name, &princ, &owned)) {
+            result = NULL;
             goto cleanup;
         }
 
-        retval = kadm5_get_principal(self->server_handle, princ, &entry, KADM5_PRINCIPAL);
+        if (!pykadmin_replica_get_principal(self->replica, princ, &entry, KADM5_PRINCIPAL, &retval))
+            PyKAdmin_CALL(self, retval, 1, kadm5_get_principal(self->server_handle, princ, &entry, KADM5_PRINCIPAL));
 
         if (retval == KADM5_OK) {
             result = Py_True;
@@ -117,7 +333,7 @@ static PyObject *PyKAdminObject_principal_exists(PyKAdminObject *self, PyObject
 
 cleanup:
     
-    krb5_free_principal(self->context, princ);
+    PyKAdminName_release_principal(self, princ, owned);
 
     if(entry_initialized) {
         kadm5_free_principal_ent(self->server_handle, &entry);
@@ -131,26 +347,33 @@ cleanup:
 static PyObject *PyKAdminObject_delete_principal(PyKAdminObject *self, PyObject *args, PyObject *kwds) {
 
     kadm5_ret_t retval = KADM5_OK;
-    krb5_error_code code = 0;
     krb5_principal princ = NULL;
+    int owned = 0;
 
-    char *client_name = NULL;
+    PyObject *name = NULL;
     
     PyObject *result = Py_True;
 
-    if (!PyArg_ParseTuple(args, "s", &client_name))
+    if (!PyArg_ParseTuple(args, "O", &name))
+        return NULL;
+
+    if (_pykadmin_ready(self))
         return NULL;
 
     if (self->server_handle) {
 
-        code = krb5_parse_name(self->context, client_name, &princ);
-        if (code) { 
-            PyKAdminError_raise_error(code, "krb5_parse_name");
+        if (PyKAdminName_principal(self, name, &princ, &owned)) {
             result = NULL;
             goto cleanup;
         }
 
-        retval = kadm5_delete_principal(self->server_handle, princ);
+        PyKAdmin_WRITE(self, retval, princ, kadm5_delete_principal(self->server_handle, princ));
+
+        pykadmin_cache_invalidate(self->context, self->cache, princ);
+
+        if (self->commits)
+            pykadmin_commit_queue_drop(self->commits, princ);
+
         if (retval != KADM5_OK) {
             PyKAdminError_raise_error(retval, "kadm5_delete_principal");
             result = NULL;
@@ -161,8 +384,7 @@ static PyObject *PyKAdminObject_delete_principal(PyKAdminObject *self, PyObject
 
 cleanup:
     
-    if (princ)
-        krb5_free_principal(self->context, princ);
+    PyKAdminName_release_principal(self, princ, owned);
 
     Py_XINCREF(result);
     return result;
@@ -170,44 +392,295 @@ cleanup:
 }
 
 
+/* ank(enctypes=...): "aes256-cts:normal aes128-cts", or a sequence of such; the salt defaults to normal */
+static int _pykadmin_parse_enctypes(PyObject *enctypes, krb5_key_salt_tuple **ks_tuple, int *n_ks_tuple) {
+
+    krb5_key_salt_tuple *tuples = NULL;
+    PyObject *sequence = NULL;
+    PyObject *item     = NULL;
+    char *string       = NULL;
+    char *token        = NULL;
+    char *salt         = NULL;
+    char *state        = NULL;
+    Py_ssize_t index   = 0;
+    int count          = 0;
+    int result         = -1;
+
+    if (PyUnicodeBytes_Check(enctypes))
+        sequence = PyTuple_Pack(1, enctypes);
+    else
+        sequence = PySequence_Fast(enctypes, "enctypes must be a str or a sequence of str");
+
+    if (!sequence)
+        return -1;
+
+    for (index = 0; index < PySequence_Fast_GET_SIZE(sequence); index++) {
+
+        item = PySequence_Fast_GET_ITEM(sequence, index);
+
+        if (!PyUnicodeBytes_Check(item)) {
+            PyErr_SetString(PyExc_TypeError, "enctypes must be a str or a sequence of str");
+            goto cleanup;
+        }
+
+        string = PyUnicode_or_PyBytes_asCString(item);
+        if (!string)
+            goto cleanup;
+
+        for (token = strtok_r(string, ", \t", &state); token; token = strtok_r(NULL, ", \t", &state)) {
+
+            tuples = realloc(*ks_tuple, (count + 1) * sizeof(krb5_key_salt_tuple));
+            if (!tuples) {
+                PyErr_NoMemory();
+                goto cleanup;
+            }
+
+            *ks_tuple = tuples;
+
+            salt = strchr(token, ':');
+            if (salt)
+                *salt++ = '\0';
+
+            tuples[count].ks_salttype = KRB5_KDB_SALTTYPE_NORMAL;
+
+            if (krb5_string_to_enctype(token, &tuples[count].ks_enctype)
+                || (salt && krb5_string_to_salttype(salt, &tuples[count].ks_salttype))) {
+                PyErr_Format(PyExc_ValueError, "invalid enctype \"%s%s%s\"", token, salt ? ":" : "", salt ? salt : "");
+                goto cleanup;
+            }
+
+            count++;
+        }
+
+        free(string);
+        string = NULL;
+    }
+
+    if (!count) {
+        PyErr_SetString(PyExc_ValueError, "enctypes must name at least one enctype");
+        goto cleanup;
+    }
+
+    *n_ks_tuple = count;
+    result = 0;
+
+cleanup:
+
+    free(string);
+    Py_DECREF(sequence);
+
+    if (result) {
+        free(*ks_tuple);
+        *ks_tuple = NULL;
+    }
+
+    return result;
+}
+
+/* ank(template=...): start from another principal's limits, flags and policy */
+static int _pykadmin_apply_template(PyKAdminObject *self, PyObject *template, kadm5_principal_ent_rec *entry, long *mask) {
+
+    PyKAdminPrincipalObject *principal = NULL;
+    krb5_principal princ = NULL;
+    int owned  = 0;
+    int result = -1;
+
+    if (PyKAdminPrincipalObject_CheckExact(template)) {
+        principal = (PyKAdminPrincipalObject *)template;
+        Py_INCREF(principal);
+    } else {
+
+        if (PyKAdminName_principal(self, template, &princ, &owned))
+            return -1;
+
+        principal = PyKAdminPrincipalObject_principal_with_principal(self, princ);
+        PyKAdminName_release_principal(self, princ, owned);
+
+        if (!principal)
+            return -1;
+    }
+
+    if ((PyObject *)principal == Py_None) {
+        if (!PyErr_Occurred())
+            PyKAdminError_raise_error(KADM5_UNK_PRINC, "kadm5_get_principal");
+        goto cleanup;
+    }
+
+    entry->attributes         = principal->entry.attributes;
+    entry->max_life           = principal->entry.max_life;
+    entry->max_renewable_life = principal->entry.max_renewable_life;
+
+    // not the template's expiry dates: they are absolute, pw_expiration comes from the policy
+    *mask |= (KADM5_ATTRIBUTES | KADM5_MAX_LIFE | KADM5_MAX_RLIFE);
+
+    if (principal->entry.policy) {
+
+        entry->policy = strdup(principal->entry.policy);
+        if (!entry->policy) {
+            PyErr_NoMemory();
+            goto cleanup;
+        }
+
+        *mask |= KADM5_POLICY;
+    }
+
+    result = 0;
+
+cleanup:
+
+    Py_DECREF(principal);
+
+    return result;
+}
+
+/*
+    ank(name, password=None, db_args=None, policy=, expire=, pwexpire=, maxlife=,
+        maxrenewlife=, attributes=, enctypes=, template=)
+
+    everything goes into the one entry and mask of a single create call; explicit values
+    override the template's. kadmind only warns about an unknown policy, so an explicit
+    one is looked up first (through the policy table when enabled), as the setter does.
+*/
 static PyObject *PyKAdminObject_create_principal(PyKAdminObject *self, PyObject *args, PyObject *kwds) {
 
     kadm5_ret_t retval   = KADM5_OK;
-    krb5_error_code code = 0;
-    char *princ_name = NULL;
+    PyObject *princ_name = NULL;
     char *princ_pass = NULL;
     PyObject *db_args = NULL;
 
+    PyObject *policy       = NULL;
+    PyObject *expire       = NULL;
+    PyObject *pwexpire     = NULL;
+    PyObject *maxlife      = NULL;
+    PyObject *maxrenewlife = NULL;
+    PyObject *attributes   = NULL;
+    PyObject *enctypes     = NULL;
+    PyObject *template     = NULL;
+
+    krb5_key_salt_tuple *ks_tuple = NULL;
+    int n_ks_tuple = 0;
+    long mask      = (KADM5_PRINCIPAL | KADM5_TL_DATA);
+
     PyObject *result = Py_True;
+    PyObject *empty  = NULL;
+    int parsed       = 0;
 
     kadm5_principal_ent_rec entry;
     
     memset(&entry, 0, sizeof(entry));
     entry.attributes = 0;
 
-    // todo set default attributes.
-    static char *kwlist[] = {"db_args", NULL};
+    static char *kwlist[] = {"db_args", "policy", "expire", "pwexpire", "maxlife", "maxrenewlife", "attributes", "enctypes", "template", NULL};
 
-    if (!PyArg_ParseTuple(args, "s|z", &princ_name, &princ_pass))
+    if (!PyArg_ParseTuple(args, "O|z", &princ_name, &princ_pass))
         return NULL;
     
-    if (!PyArg_ParseTupleAndKeywords(PyTuple_New(0), kwds, "|O", kwlist, &db_args))
+    // the keywords alone; name and password stay positional
+    empty = PyTuple_New(0);
+    if (!empty)
+        return NULL;
+
+    parsed = PyArg_ParseTupleAndKeywords(empty, kwds, "|OOOOOOOOO", kwlist, &db_args, &policy, &expire, &pwexpire, &maxlife, &maxrenewlife, &attributes, &enctypes, &template);
+    Py_DECREF(empty);
+
+    if (!parsed)
+        return NULL;
+
+    if (_pykadmin_ready(self))
         return NULL;
 
     pykadmin_principal_append_db_args(&entry, db_args);
 
     if (self->server_handle) {
 
-        code = krb5_parse_name(self->context, princ_name, &entry.principal);
-        if (code) { 
-            PyKAdminError_raise_error(code, "krb5_parse_name");
+        if (PyKAdminName_copy_principal(self, princ_name, &entry.principal)) {
+            result = NULL;
+            goto cleanup;
+        }
+
+        if (template && (template != Py_None) && _pykadmin_apply_template(self, template, &entry, &mask)) {
+            result = NULL;
+            goto cleanup;
+        }
+
+        if (policy) {
+
+            free(entry.policy);
+            entry.policy = NULL;
+            mask &= ~KADM5_POLICY;
+
+            if (PyKAdminPolicyObject_CheckExact(policy))
+                entry.policy = strdup(PyKAdminPolicyObject_policy_name((PyKAdminPolicyObject *)policy));
+            else if (PyUnicodeBytes_Check(policy))
+                entry.policy = PyUnicode_or_PyBytes_asCString(policy);
+            else if (policy != Py_None)
+                PyErr_SetString(PyExc_TypeError, "policy must be a str, kadmin.Policy or None");
+
+            if (PyErr_Occurred() || ((policy != Py_None) && !entry.policy)) {
+                if (!PyErr_Occurred())
+                    PyErr_NoMemory();
+                result = NULL;
+                goto cleanup;
+            }
+
+            if (entry.policy) {
+
+                if (!pykadmin_policy_exists(self, entry.policy)) {
+                    if (!PyErr_Occurred())
+                        PyKAdminError_raise_error(KADM5_UNK_POLICY, "kadm5_get_policy");
+                    result = NULL;
+                    goto cleanup;
+                }
+
+                mask |= KADM5_POLICY;
+            }
+        }
+
+        if (expire) {
+            entry.princ_expire_time = PyKAdminPrincipal_decode_timestamp(expire);
+            mask |= KADM5_PRINC_EXPIRE_TIME;
+        }
+
+        if (pwexpire && !PyErr_Occurred()) {
+            entry.pw_expiration = PyKAdminPrincipal_decode_timestamp(pwexpire);
+            mask |= KADM5_PW_EXPIRATION;
+        }
+
+        if (maxlife && !PyErr_Occurred()) {
+            entry.max_life = PyKAdminPrincipal_decode_timedelta(maxlife);
+            mask |= KADM5_MAX_LIFE;
+        }
+
+        if (maxrenewlife && !PyErr_Occurred()) {
+            entry.max_renewable_life = PyKAdminPrincipal_decode_timedelta(maxrenewlife);
+            mask |= KADM5_MAX_RLIFE;
+        }
+
+        if (attributes && !PyErr_Occurred()) {
+
+            if (PyUnifiedLongInt_Check(attributes))
+                entry.attributes = (krb5_flags)PyUnifiedLongInt_AsLong(attributes);
+            else
+                PyErr_SetString(PyExc_TypeError, "attributes must be an int");
+
+            mask |= KADM5_ATTRIBUTES;
+        }
+
+        if (enctypes && (enctypes != Py_None) && !PyErr_Occurred())
+            _pykadmin_parse_enctypes(enctypes, &ks_tuple, &n_ks_tuple);
+
+        if (PyErr_Occurred()) {
             result = NULL;
             goto cleanup;
         }
 
-        retval = kadm5_create_principal(self->server_handle, &entry, (KADM5_PRINCIPAL | KADM5_TL_DATA), princ_pass); 
+        if (n_ks_tuple)
+            PyKAdmin_WRITE(self, retval, entry.principal, kadm5_create_principal_3(self->server_handle, &entry, mask, n_ks_tuple, ks_tuple, princ_pass));
+        else
+            PyKAdmin_WRITE(self, retval, entry.principal, kadm5_create_principal(self->server_handle, &entry, mask, princ_pass));
+
         if (retval != KADM5_OK) {
-            PyKAdminError_raise_error(retval, "kadm5_create_principal");
+            PyKAdminError_raise_error(retval, n_ks_tuple ? "kadm5_create_principal_3" : "kadm5_create_principal");
             result = NULL;
         }
 
@@ -215,6 +688,8 @@ static PyObject *PyKAdminObject_create_principal(PyKAdminObject *self, PyObject
 
 cleanup:
 
+    free(ks_tuple);
+
     kadm5_free_principal_ent(self->server_handle, &entry);
 
     Py_XINCREF(result);
@@ -225,14 +700,19 @@ cleanup:
 static PyKAdminPrincipalObject *PyKAdminObject_get_principal(PyKAdminObject *self, PyObject *args, PyObject *kwds) {
 
     PyKAdminPrincipalObject *principal = NULL;
-    char *client_name = NULL;
+    krb5_principal princ = NULL;
+    PyObject *name = NULL;
+    int owned = 0;
+
+    if (!PyArg_ParseTuple(args, "O", &name))
+        return NULL;
 
-    if (!PyArg_ParseTuple(args, "s", &client_name))
+    if (PyKAdminName_principal(self, name, &princ, &owned))
         return NULL;
 
-    principal = PyKAdminPrincipalObject_principal_with_name(self, client_name);
+    principal = PyKAdminPrincipalObject_principal_with_principal(self, princ);
 
-    
+    PyKAdminName_release_principal(self, princ, owned);
 
     return principal;
 }
@@ -251,241 +731,1433 @@ static PyKAdminPolicyObject *PyKAdminObject_get_policy(PyKAdminObject *self, PyO
 }
 
 
-static PyKAdminIterator *PyKAdminObject_principal_iter(PyKAdminObject *self, PyObject *args, PyObject *kwds) {
+static PyObject *PyKAdminObject_enable_cache(PyKAdminObject *self, PyObject *args, PyObject *kwds) {
 
-    char *match = NULL;
+    Py_ssize_t max_entries = 1024;
+    double ttl = 60;
 
-    static char *kwlist[] = {"match", NULL};
+    static char *kwlist[] = {"max_entries", "ttl", NULL};
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|z", kwlist, &match))
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|nd", kwlist, &max_entries, &ttl))
         return NULL;
 
-    return PyKAdminIterator_principal_iterator(self, match);
-}
+    if ((max_entries < 0) || (ttl < 0)) {
+        PyErr_SetString(PyExc_ValueError, "max_entries and ttl must not be negative");
+        return NULL;
+    }
 
+    pykadmin_cache_destroy(self->context, self->cache);
 
-static PyKAdminIterator *PyKAdminObject_policy_iter(PyKAdminObject *self, PyObject *args, PyObject *kwds) {
+    self->cache = pykadmin_cache_create((size_t)max_entries, ttl);
+    if (!self->cache)
+        return PyErr_NoMemory();
 
-    char *match = NULL;
+    Py_RETURN_TRUE;
+}
 
-    static char *kwlist[] = {"match", NULL};
+static PyObject *PyKAdminObject_disable_cache(PyKAdminObject *self) {
 
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|z", kwlist, &match))
-        return NULL;
+    pykadmin_cache_destroy(self->context, self->cache);
+    self->cache = NULL;
 
-    return PyKAdminIterator_policy_iterator(self, match);
+    Py_RETURN_TRUE;
 }
 
+static PyObject *PyKAdminObject_cache_stats(PyKAdminObject *self) {
 
-#ifdef KADMIN_LOCAL
-
-static void _pykadmin_each_encapsulate_error(PyObject **store) {
+    pykadmin_cache_stats_t stats;
 
-    PyObject *ptype      = NULL;
-    PyObject *pvalue     = NULL;
-    PyObject *ptraceback = NULL;
+    pykadmin_cache_stats(self->cache, &stats);
 
-    if (PyErr_Occurred()) {
-        PyErr_Fetch(&ptype, &pvalue, &ptraceback);
-        *store = PyTuple_Pack(3, ptype, pvalue, ptraceback);
-    } else {
-        *store = PyExc_RuntimeError;
-    }
+    return Py_BuildValue("{s:O,s:n,s:n,s:d,s:K,s:K,s:K,s:K}",
+        "enabled",       self->cache ? Py_True : Py_False,
+        "entries",       (Py_ssize_t)stats.entries,
+        "max_entries",   (Py_ssize_t)stats.max_entries,
+        "ttl",           stats.ttl,
+        "hits",          stats.hits,
+        "misses",        stats.misses,
+        "evictions",     stats.evictions,
+        "invalidations", stats.invalidations);
 }
 
-static void _pykadmin_each_restore_error(PyObject *store) {
-    
-    if (PyTuple_CheckExact(store)) {
+static PyObject *PyKAdminObject_enable_write_behind(PyKAdminObject *self, PyObject *args, PyObject *kwds) {
 
-        PyObject *ptype      = PyTuple_GetItem(store, 0);
-        PyObject *pvalue     = PyTuple_GetItem(store, 1);
-        PyObject *ptraceback = PyTuple_GetItem(store, 2);
+    Py_ssize_t max_pending = 0;
+    double delay = 1;
 
-        PyErr_Restore(ptype, pvalue, ptraceback);
-        Py_DECREF(store);
+    static char *kwlist[] = {"delay", "max_pending", NULL};
 
-    } else {
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|dn", kwlist, &delay, &max_pending))
+        return NULL;
 
-        PyErr_SetString(PyExc_RuntimeError, "Internal Fatal Iteration Exception");
+    if ((delay < 0) || (max_pending < 0)) {
+        PyErr_SetString(PyExc_ValueError, "delay and max_pending must not be negative");
+        return NULL;
     }
-}
 
+    // what is already queued stays queued
+    if (self->commits) {
+        pykadmin_commit_queue_configure(self->commits, delay, (size_t)max_pending);
+        Py_RETURN_TRUE;
+    }
+
+    self->commits = pykadmin_commit_queue_create(self, delay, (size_t)max_pending);
+    if (!self->commits)
+        return NULL;
+
+    Py_RETURN_TRUE;
+}
+
+static PyObject *PyKAdminObject_disable_write_behind(PyKAdminObject *self) {
+
+    PyObject *results = NULL;
+
+    if (!self->commits)
+        return PyDict_New();
+
+    results = pykadmin_commit_queue_flush(self->commits);
+
+    if (results) {
+        pykadmin_commit_queue_destroy(self->commits);
+        self->commits = NULL;
+    }
+
+    return results;
+}
+
+static PyObject *PyKAdminObject_flush(PyKAdminObject *self) {
+
+    if (!self->commits)
+        return PyDict_New();
+
+    return pykadmin_commit_queue_flush(self->commits);
+}
+
+
+kadm5_ret_t PyKAdminObject_load_policies(PyKAdminObject *self, int force) {
+
+    kadm5_ret_t retval = KADM5_OK;
+    pykadmin_policy_slot_t *slots = NULL;
+    char **names = NULL;
+    int count    = 0;
+    int loaded   = 0;
+    int index    = 0;
+
+    if (!force && !pykadmin_policy_table_expired(self->policies))
+        return KADM5_OK;
+
+    PyKAdmin_CALL(self, retval, 1, kadm5_get_policies(self->server_handle, "*", &names, &count));
+    if (retval != KADM5_OK)
+        return retval;
+
+    if (count > 0) {
+        slots = calloc(count, sizeof(pykadmin_policy_slot_t));
+        if (!slots) {
+            retval = ENOMEM;
+            goto cleanup;
+        }
+    }
+
+    for (index = 0; index < count; index++) {
+
+        PyKAdmin_CALL(self, retval, 1, kadm5_get_policy(self->server_handle, names[index], &slots[loaded].entry));
+
+        // removed between the listing and the fetch
+        if (retval == KADM5_UNK_POLICY)
+            continue;
+
+        if (retval != KADM5_OK) {
+            pykadmin_policy_table_release(self->server_handle, slots, loaded);
+            slots = NULL;
+            goto cleanup;
+        }
+
+        loaded++;
+    }
+
+    retval = KADM5_OK;
+
+    // disabled while a call had the GIL released
+    if (self->policies) {
+        pykadmin_policy_table_replace(self->server_handle, self->policies, slots, loaded);
+        slots = NULL;
+    }
+
+cleanup:
+
+    if (slots)
+        pykadmin_policy_table_release(self->server_handle, slots, loaded);
+
+    kadm5_free_name_list(self->server_handle, names, count);
+
+    return retval;
+}
+
+static PyObject *PyKAdminObject_enable_policy_cache(PyKAdminObject *self, PyObject *args, PyObject *kwds) {
+
+    kadm5_ret_t retval = KADM5_OK;
+    double ttl = 0;
+
+    static char *kwlist[] = {"ttl", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|d", kwlist, &ttl))
+        return NULL;
+
+    if (_pykadmin_ready(self))
+        return NULL;
+
+    pykadmin_policy_table_destroy(self->server_handle, self->policies);
+
+    self->policies = pykadmin_policy_table_create(ttl);
+    if (!self->policies)
+        return PyErr_NoMemory();
+
+    retval = PyKAdminObject_load_policies(self, 1);
+    if (retval != KADM5_OK) {
+        pykadmin_policy_table_destroy(self->server_handle, self->policies);
+        self->policies = NULL;
+        PyKAdminError_raise_error(retval, "kadm5_get_policies");
+        return NULL;
+    }
+
+    Py_RETURN_TRUE;
+}
+
+static PyObject *PyKAdminObject_disable_policy_cache(PyKAdminObject *self) {
+
+    pykadmin_policy_table_destroy(self->server_handle, self->policies);
+    self->policies = NULL;
+
+    Py_RETURN_TRUE;
+}
+
+static PyObject *PyKAdminObject_refresh_policies(PyKAdminObject *self) {
+
+    kadm5_ret_t retval = KADM5_OK;
+
+    if (self->policies) {
+
+        if (_pykadmin_ready(self))
+            return NULL;
+
+        retval = PyKAdminObject_load_policies(self, 1);
+
+        if (retval != KADM5_OK) {
+            PyKAdminError_raise_error(retval, "kadm5_get_policies");
+            return NULL;
+        }
+    }
+
+    return PyUnifiedLongInt_FromLong((long)pykadmin_policy_table_count(self->policies));
+}
+
+
+/*
+    exists_many plans its kadm5 calls from a cost estimate, in units of one
+    kadm5_get_principal round trip. the names are sorted and split into shards of
+    neighbours; a shard is answered either by one lookup per name or by one
+    kadm5_get_principals listing of its common prefix, loaded into a kadmin.NameIndex,
+    whichever is estimated cheaper. a listing costs one round trip plus the names it
+    returns, kEXISTS_MANY_NAMES_PER_CALL of them per round trip; a prefix of length l is
+    estimated to match realm_size / kEXISTS_MANY_FANOUT^l principals. realm_size is the
+    caller's hint, else the size of this handle's last full listing, else
+    kEXISTS_MANY_REALM_SIZE. a neighbour joins a shard only when that costs no more than
+    answering it on its own, so unrelated names never widen a listing to the whole realm.
+    below `threshold` names every name is simply looked up.
+*/
+#define kEXISTS_MANY_THRESHOLD      64
+#define kEXISTS_MANY_NAMES_PER_CALL 100.0
+#define kEXISTS_MANY_FANOUT         8.0
+#define kEXISTS_MANY_REALM_SIZE     1000000.0
+
+typedef struct {
+    const char *name;
+    Py_ssize_t position;    // in the caller's names
+} pykadmin_exists_name_t;
+
+typedef struct {
+    Py_ssize_t start;       // sorted[start, end)
+    Py_ssize_t end;
+    size_t prefix;          // common prefix length
+    double cost;
+    int list;
+} pykadmin_exists_shard_t;
+
+static void _pykadmin_free_names(char **names, Py_ssize_t count) {
+
+    Py_ssize_t index = 0;
+
+    if (names) {
+        for (; index < count; index++)
+            free(names[index]);
+        free(names);
+    }
+}
+
+/* canonical unparsed form of every name, as kadm5_get_principals reports them */
+static char **_pykadmin_canonical_names(PyKAdminObject *self, PyObject *sequence, Py_ssize_t count) {
+
+    krb5_error_code code = 0;
+    krb5_principal princ = NULL;
+    char *unparsed       = NULL;
+    char **names         = NULL;
+    int owned            = 0;
+    Py_ssize_t index     = 0;
+
+    names = calloc(count ? count : 1, sizeof(char *));
+    if (!names)
+        return (char **)PyErr_NoMemory();
+
+    for (; index < count; index++) {
+
+        if (PyKAdminName_principal(self, PySequence_Fast_GET_ITEM(sequence, index), &princ, &owned))
+            goto error;
+
+        code = krb5_unparse_name(self->context, princ, &unparsed);
+        PyKAdminName_release_principal(self, princ, owned);
+
+        if (code) {
+            PyKAdminError_raise_error(code, "krb5_unparse_name");
+            goto error;
+        }
+
+        names[index] = strdup(unparsed);
+        krb5_free_unparsed_name(self->context, unparsed);
+
+        if (!names[index]) {
+            PyErr_NoMemory();
+            goto error;
+        }
+    }
+
+    return names;
+
+error:
+    _pykadmin_free_names(names, count);
+    return NULL;
+}
+
+static int _pykadmin_exists_name_compare(const void *a, const void *b) {
+    return strcmp(((const pykadmin_exists_name_t *)a)->name, ((const pykadmin_exists_name_t *)b)->name);
+}
+
+static size_t _pykadmin_common_prefix(const char *a, const char *b) {
+
+    size_t length = 0;
+
+    while (a[length] && (a[length] == b[length]))
+        length++;
+
+    return length;
+}
+
+/* cost of answering sorted[start, end) with the prefix, and whether listing wins */
+static void _pykadmin_exists_plan(pykadmin_exists_shard_t *shard, double realm_size, const char *method) {
+
+    double lookups = (double)(shard->end - shard->start);
+    double listing = 1 + (realm_size / pow(kEXISTS_MANY_FANOUT, (double)shard->prefix)) / kEXISTS_MANY_NAMES_PER_CALL;
+
+    if (!strcmp(method, "list"))
+        shard->list = 1;
+    else if (!strcmp(method, "lookup"))
+        shard->list = 0;
+    else
+        shard->list = (listing < lookups);
+
+    shard->cost = shard->list ? listing : lookups;
+}
+
+/*
+    glob for the principals starting with the first length characters of name (unparsed).
+    kadm5 makes a POSIX basic regexp of it, the replica an fnmatch pattern: '.', '*', '^',
+    '$', '[', ']' and '\' are escaped with a backslash, which both read as the character
+    itself. '?', '+', '(', ')', '{', '}' and '|' have no spelling both read literally
+    (kadm5 passes "\?" or "\(" on as operators), so the prefix stops short of them and the
+    listing is only wider. a glob without '@' would get "@<default realm>" appended,
+    missing other realms, so one without gets an explicit "@*".
+*/
+static char *_pykadmin_prefix_match(const char *name, size_t length) {
+
+    char *match  = malloc((length * 2) + 4);
+    char *cursor = match;
+    size_t index = 0;
+    int realm    = 0;
+
+    if (!match)
+        return NULL;
+
+    for (; (index < length) && !strchr("?+(){}|", name[index]); index++) {
+
+        if (strchr(".*^$[]\\", name[index]))
+            *cursor++ = '\\';
+
+        realm |= (name[index] == '@');
+        *cursor++ = name[index];
+    }
+
+    *cursor++ = '*';
+
+    if (!realm) {
+        *cursor++ = '@';
+        *cursor++ = '*';
+    }
+
+    *cursor = '\0';
+
+    return match;
+}
+
+static int _pykadmin_exists_by_listing(PyKAdminObject *self, pykadmin_exists_name_t *sorted, pykadmin_exists_shard_t *shard, unsigned char *found) {
+
+    kadm5_ret_t retval      = KADM5_OK;
+    PyKAdminNameIndex *index = NULL;
+    char **listing          = NULL;
+    char *match             = NULL;
+    int listed              = 0;
+    int result              = -1;
+    int name                = 0;
+    Py_ssize_t position     = 0;
+
+    match = _pykadmin_prefix_match(sorted[shard->start].name, shard->prefix);
+    if (!match) {
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    if (!pykadmin_replica_get_principals(self->replica, match, &listing, &listed))
+        PyKAdmin_CALL(self, retval, 1, kadm5_get_principals(self->server_handle, match, &listing, &listed));
+    free(match);
+
+    if (retval != KADM5_OK) {
+        PyKAdminError_raise_error(retval, "kadm5_get_principals");
+        return -1;
+    }
+
+    // the next estimate starts from the realm's real size
+    if (!shard->prefix)
+        self->realm_size = (size_t)listed;
+
+    index = PyKAdminNameIndex_create((size_t)listed);
+    if (!index)
+        goto cleanup;
+
+    for (name = 0; name < listed; name++) {
+        if (PyKAdminNameIndex_add(index, listing[name]))
+            goto cleanup;
+    }
+
+    for (position = shard->start; position < shard->end; position++)
+        found[sorted[position].position] = (unsigned char)PyKAdminNameIndex_contains_name(index, sorted[position].name);
+
+    result = 0;
+
+cleanup:
+
+    Py_XDECREF(index);
+    kadm5_free_name_list(self->server_handle, listing, listed);
+
+    return result;
+}
+
+static int _pykadmin_exists_by_lookup(PyKAdminObject *self, pykadmin_exists_name_t *sorted, pykadmin_exists_shard_t *shard, unsigned char *found) {
+
+    kadm5_ret_t retval = KADM5_OK;
+    krb5_error_code code = 0;
+    krb5_principal princ = NULL;
+    kadm5_principal_ent_rec entry;
+    Py_ssize_t index = shard->start;
+
+    for (; index < shard->end; index++) {
+
+        if ((code = krb5_parse_name(self->context, sorted[index].name, &princ))) {
+            PyKAdminError_raise_error(code, "krb5_parse_name");
+            return -1;
+        }
+
+        if (!pykadmin_replica_get_principal(self->replica, princ, &entry, KADM5_PRINCIPAL, &retval))
+            PyKAdmin_CALL(self, retval, 1, kadm5_get_principal(self->server_handle, princ, &entry, KADM5_PRINCIPAL));
+        krb5_free_principal(self->context, princ);
+
+        if (retval == KADM5_OK) {
+            kadm5_free_principal_ent(self->server_handle, &entry);
+            found[sorted[index].position] = 1;
+        } else if (retval == KADM5_UNK_PRINC) {
+            found[sorted[index].position] = 0;
+        } else {
+            PyKAdminError_raise_error(retval, "kadm5_get_principal");
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/*
+    answer names[0, count) into found, shard by shard. returns 0, or -1 with an exception
+    set.
+*/
+static int _pykadmin_exists_sharded(PyKAdminObject *self, char **names, Py_ssize_t count, const char *method, double realm_size, unsigned char *found) {
+
+    pykadmin_exists_name_t *sorted = NULL;
+    pykadmin_exists_shard_t shard;
+    pykadmin_exists_shard_t merged;
+    pykadmin_exists_shard_t single;
+    Py_ssize_t index = 0;
+    int result = -1;
+
+    sorted = malloc(count * sizeof(pykadmin_exists_name_t));
+    if (!sorted) {
+        PyErr_NoMemory();
+        return -1;
+    }
+
+    for (index = 0; index < count; index++) {
+        sorted[index].name     = names[index];
+        sorted[index].position = index;
+    }
+
+    qsort(sorted, count, sizeof(pykadmin_exists_name_t), _pykadmin_exists_name_compare);
+
+    shard.start  = 0;
+    shard.end    = 1;
+    shard.prefix = strlen(sorted[0].name);
+    _pykadmin_exists_plan(&shard, realm_size, method);
+
+    for (index = 1; index <= count; index++) {
+
+        if (index < count) {
+
+            single.start  = index;
+            single.end    = index + 1;
+            single.prefix = strlen(sorted[index].name);
+            _pykadmin_exists_plan(&single, realm_size, method);
+
+            // sorted, so the shard's common prefix is its first and last name's
+            merged.start  = shard.start;
+            merged.end    = index + 1;
+            merged.prefix = _pykadmin_common_prefix(sorted[shard.start].name, sorted[index].name);
+            _pykadmin_exists_plan(&merged, realm_size, method);
+
+            if (merged.cost <= shard.cost + single.cost) {
+                shard = merged;
+                continue;
+            }
+        }
+
+        if (shard.list)
+            result = _pykadmin_exists_by_listing(self, sorted, &shard, found);
+        else
+            result = _pykadmin_exists_by_lookup(self, sorted, &shard, found);
+
+        if (result)
+            goto cleanup;
+
+        shard = single;
+    }
+
+    result = 0;
+
+cleanup:
+
+    free(sorted);
+
+    return result;
+}
+
+static PyObject *PyKAdminObject_exists_many(PyKAdminObject *self, PyObject *args, PyObject *kwds) {
+
+    PyObject *names_in  = NULL;
+    PyObject *sequence  = NULL;
+    PyObject *result    = NULL;
+    PyObject *bitmap    = Py_False;
+    char *method        = "auto";
+    Py_ssize_t threshold = kEXISTS_MANY_THRESHOLD;
+    Py_ssize_t realm_size = 0;
+    Py_ssize_t count    = 0;
+    Py_ssize_t index    = 0;
+    unsigned char *found = NULL;
+    char **names        = NULL;
+    int status          = 0;
+
+    static char *kwlist[] = {"names", "method", "threshold", "bitmap", "realm_size", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|snOn", kwlist, &names_in, &method, &threshold, &bitmap, &realm_size))
+        return NULL;
+
+    if (strcmp(method, "auto") && strcmp(method, "lookup") && strcmp(method, "list")) {
+        PyErr_SetString(PyExc_ValueError, "method must be \"auto\", \"lookup\" or \"list\"");
+        return NULL;
+    }
+
+    if (_pykadmin_ready(self))
+        return NULL;
+
+    sequence = PySequence_Fast(names_in, "names must be iterable");
+    if (!sequence)
+        return NULL;
+
+    count = PySequence_Fast_GET_SIZE(sequence);
+
+    names = _pykadmin_canonical_names(self, sequence, count);
+    found = calloc(count ? count : 1, 1);
+
+    if (!names || !found) {
+        if (!PyErr_Occurred())
+            PyErr_NoMemory();
+        goto cleanup;
+    }
+
+    if (realm_size <= 0)
+        realm_size = self->realm_size ? (Py_ssize_t)self->realm_size : (Py_ssize_t)kEXISTS_MANY_REALM_SIZE;
+
+    if (!strcmp(method, "auto") && (count < threshold))
+        method = "lookup";
+
+    if (count) {
+        status = _pykadmin_exists_sharded(self, names, count, method, (double)realm_size, found);
+        if (status)
+            goto cleanup;
+    }
+
+    if (PyObject_IsTrue(bitmap)) {
+
+        // bit i of byte i / 8 is set when names[i] exists
+        result = PyBytes_FromStringAndSize(NULL, (count + 7) / 8);
+
+        if (result) {
+            memset(PyBytes_AS_STRING(result), 0, (count + 7) / 8);
+            for (index = 0; index < count; index++) {
+                if (found[index])
+                    PyBytes_AS_STRING(result)[index / 8] |= (char)(1 << (index % 8));
+            }
+        }
+
+    } else {
+
+        result = PyList_New(count);
+
+        for (index = 0; result && (index < count); index++) {
+            Py_INCREF(found[index] ? Py_True : Py_False);
+            PyList_SET_ITEM(result, index, found[index] ? Py_True : Py_False);
+        }
+    }
+
+cleanup:
+
+    _pykadmin_free_names(names, count);
+    free(found);
+    Py_DECREF(sequence);
+
+    return result;
+}
+
+static PyObject *PyKAdminObject_name(PyKAdminObject *self, PyObject *args) {
+
+    PyObject *name = NULL;
+    char *client_name = NULL;
+    PyKAdminName *result = NULL;
+
+    if (!PyArg_ParseTuple(args, "O", &name))
+        return NULL;
+
+    if (PyKAdminName_CheckExact(name)) {
+        Py_INCREF(name);
+        return name;
+    }
+
+    if (!PyUnicodeBytes_Check(name)) {
+        PyErr_SetString(PyExc_TypeError, "principal must be str or kadmin.Name");
+        return NULL;
+    }
+
+    client_name = PyUnicode_or_PyBytes_asCString(name);
+    if (!client_name)
+        return PyErr_Occurred() ? NULL : PyErr_NoMemory();
+
+    result = PyKAdminName_create(self, client_name);
+    free(client_name);
+
+    return (PyObject *)result;
+}
+
+static PyKAdminIterator *PyKAdminObject_principal_iter(PyKAdminObject *self, PyObject *args, PyObject *kwds) {
+
+    char *match = NULL;
+    PyObject *names = Py_False;
+    PyKAdminIterator *iter = NULL;
+
+    static char *kwlist[] = {"match", "names", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|zO", kwlist, &match, &names))
+        return NULL;
+
+    iter = PyKAdminIterator_principal_iterator(self, match);
+
+    if (iter)
+        iter->yield_names = PyObject_IsTrue(names);
+
+    return iter;
+}
+
+
+static PyKAdminIterator *PyKAdminObject_policy_iter(PyKAdminObject *self, PyObject *args, PyObject *kwds) {
+
+    char *match = NULL;
+
+    static char *kwlist[] = {"match", NULL};
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|z", kwlist, &match))
+        return NULL;
+
+    return PyKAdminIterator_policy_iterator(self, match);
+}
+
+
+#ifdef KADMIN_LOCAL
+
+static void _pykadmin_each_encapsulate_error(PyObject **store) {
+
+    PyObject *ptype      = NULL;
+    PyObject *pvalue     = NULL;
+    PyObject *ptraceback = NULL;
+
+    if (PyErr_Occurred()) {
+        PyErr_Fetch(&ptype, &pvalue, &ptraceback);
+        *store = PyTuple_Pack(3, ptype, pvalue, ptraceback);
+    } else {
+        *store = PyExc_RuntimeError;
+    }
+}
+
+static void _pykadmin_each_restore_error(PyObject *store) {
+    
+    if (PyTuple_CheckExact(store)) {
+
+        PyObject *ptype      = PyTuple_GetItem(store, 0);
+        PyObject *pvalue     = PyTuple_GetItem(store, 1);
+        PyObject *ptraceback = PyTuple_GetItem(store, 2);
+
+        PyErr_Restore(ptype, pvalue, ptraceback);
+        Py_DECREF(store);
+
+    } else {
+
+        PyErr_SetString(PyExc_RuntimeError, "Internal Fatal Iteration Exception");
+    }
+}
+
+
+/*
+    krb5_db_iterate ends the scan as soon as the callback returns nonzero and hands
+    that value back to us; kEACH_STOP marks a requested stop rather than a failure.
+*/
+static const krb5_error_code kEACH_STOP = 0x4b535450;
+
+static int _pykadmin_each_lock_mode(const char *name) {
+
+    if (!name || !strcmp(name, "full"))
+        return kEACH_LOCK_FULL;
+
+    if (!strcmp(name, "chunked"))
+        return kEACH_LOCK_CHUNKED;
+
+    if (!strcmp(name, "none"))
+        return kEACH_LOCK_NONE;
+
+    PyErr_SetString(PyExc_ValueError, "lock must be one of \"full\", \"chunked\" or \"none\"");
+    return -1;
+}
+
+static kadm5_ret_t _pykadmin_each_lock(PyKAdminObject *self, each_iteration_t *each) {
+
+    kadm5_ret_t lock = KADM5_OK;
+
+    if (each->lock_mode != kEACH_LOCK_NONE) {
+
+        lock = kadm5_lock(self->server_handle);
+
+        if (lock == KADM5_OK)
+            self->locked = 1;
+        else if (lock == KRB5_PLUGIN_OP_NOTSUPP)
+            lock = KADM5_OK;
+    }
+
+    return lock;
+}
+
+static void _pykadmin_each_unlock(PyKAdminObject *self) {
+
+    if (self->locked) {
+        if (kadm5_unlock(self->server_handle) == KADM5_OK)
+            self->locked = 0;
+    }
+}
+
+/*
+    in chunked mode drop and retake kadm5_lock every `chunk` entries. this is all it does:
+    krb5_db_iterate keeps the backend's own lock, so on DB2 writers still wait for the end
+    of the scan unless unlockiter is set. a lock that cannot be retaken ends the scan with
+    an error rather than letting it carry on unlocked; returns 1 then.
+*/
+static int _pykadmin_each_cycle_lock(PyKAdminObject *self, each_iteration_t *each) {
+
+    kadm5_ret_t lock = KADM5_OK;
+
+    if ((each->lock_mode == kEACH_LOCK_CHUNKED) && (each->chunk > 0) && self->locked) {
+
+        if ((each->count % each->chunk) == 0) {
+
+            _pykadmin_each_unlock(self);
+
+            // kadm5_unlock failed and the lock is still held; carry on under it
+            if (self->locked)
+                return 0;
+
+            if ((lock = _pykadmin_each_lock(self, each)) != KADM5_OK) {
+                if (!each->error) {
+                    PyKAdminError_raise_error(lock, "kadm5_lock");
+                    _pykadmin_each_encapsulate_error(&each->error);
+                }
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int _pykadmin_each_should_stop(each_iteration_t *each) {
+
+    if (each->error)
+        return 1;
+
+    if (PyErr_CheckSignals()) {
+        _pykadmin_each_encapsulate_error(&each->error);
+        return 1;
+    }
+
+    if ((each->limit > 0) && (each->count >= each->limit))
+        return 1;
+
+    if ((each->deadline > 0) && (pykadmin_monotonic() >= each->deadline))
+        return 1;
+
+    return 0;
+}
+
+/*
+    callbacks may be any callable. they receive (entry, data) when data was supplied or
+    when the callback is a plain python function (the historic signature), otherwise (entry)
+    so that C callables such as list.append can be used directly.
+*/
+static int _pykadmin_each_parse_callback(each_iteration_t *each, PyObject *callback, PyObject *data) {
+
+    if (callback == Py_None)
+        callback = NULL;
+
+    if (callback && !PyCallable_Check(callback)) {
+        PyErr_SetString(PyExc_TypeError, "callback must be callable");
+        return -1;
+    }
+
+    each->callback = callback;
+    each->data     = data ? data : Py_None;
+
+    return 0;
+}
+
+/* one convention for every kind of callable: callback(entry, data), data None when not given */
+static PyObject *_pykadmin_each_invoke(each_iteration_t *each, PyObject *entry) {
+    return PyKAdmin_CallTwoArgs(each->callback, entry, each->data);
+}
+
+/* resolve into= to a container; a type (list, dict, kadmin.NameIndex) creates a new one */
+static PyObject *_pykadmin_each_parse_into(PyObject *into) {
+
+    if (!into || (into == Py_None))
+        return NULL;
+
+    if (into == (PyObject *)&PyList_Type)
+        return PyList_New(0);
+
+    if (into == (PyObject *)&PyDict_Type)
+        return PyDict_New();
+
+    if (into == (PyObject *)&PyKAdminNameIndex_Type)
+        return (PyObject *)PyKAdminNameIndex_create(0);
+
+    if (PyList_Check(into) || PyDict_Check(into) || PyKAdminNameIndex_CheckExact(into)) {
+        Py_INCREF(into);
+        return into;
+    }
+
+    PyErr_SetString(PyExc_TypeError, "into must be list, dict, kadmin.NameIndex or an instance of one");
+    return NULL;
+}
+
+static int _pykadmin_each_store_name(PyKAdminObject *self, krb5_principal princ) {
+
+    krb5_error_code code = 0;
+    char *client_name    = NULL;
+    int result           = 0;
+
+    code = krb5_unparse_name(self->context, princ, &client_name);
+    if (code) {
+        PyKAdminError_raise_error(code, "krb5_unparse_name");
+        return -1;
+    }
+
+    result = PyKAdminNameIndex_add((PyKAdminNameIndex *)self->each_principal.into, client_name);
+
+    krb5_free_unparsed_name(self->context, client_name);
+
+    return result;
+}
+
+static int _pykadmin_each_store_principal(PyKAdminObject *self, PyKAdminPrincipalObject *principal) {
+
+    krb5_error_code code = 0;
+    PyObject *into       = self->each_principal.into;
+    PyObject *key        = NULL;
+    char *client_name    = NULL;
+    int result           = 0;
+
+    if (PyList_Check(into))
+        return PyList_Append(into, (PyObject *)principal);
+
+    code = krb5_unparse_name(self->context, principal->entry.principal, &client_name);
+    if (code) {
+        PyKAdminError_raise_error(code, "krb5_unparse_name");
+        return -1;
+    }
+
+    key = PyUnicode_FromString(client_name);
+    krb5_free_unparsed_name(self->context, client_name);
+
+    if (!key)
+        return -1;
+
+    result = PyDict_SetItem(into, key, (PyObject *)principal);
+    Py_DECREF(key);
+
+    return result;
+}
+
+/*
+    one step of each_principal for an entry from either source: a krb5_db_entry from
+    krb5_db_iterate, or a converted kadm5 entry from a threaded klmdb scan (whose contents are
+    taken over by the principal object when one is built). nonzero stops the walk.
+*/
+static int _pykadmin_each_principal_step(PyKAdminObject *self, krb5_db_entry *kdb, kadm5_principal_ent_rec *entry) {
+
+    each_iteration_t *each = &self->each_principal;
+
+    PyKAdminPrincipalObject *principal = NULL;
+    PyObject *result = NULL;
+    int stop = 0;
+
+    if (_pykadmin_each_should_stop(each))
+        return 1;
+
+    // names only: nothing needs a principal object
+    if (each->into && PyKAdminNameIndex_CheckExact(each->into)) {
+        if (_pykadmin_each_store_name(self, kdb ? kdb->princ : entry->principal))
+            stop = 1;
+    }
+
+    if (!stop && (each->callback || (each->into && !PyKAdminNameIndex_CheckExact(each->into)))) {
+
+        if (kdb)
+            principal = PyKAdminPrincipalObject_principal_with_db_entry(self, kdb);
+        else
+            principal = PyKAdminPrincipalObject_principal_with_kadm_entry(self, entry);
+
+        if (principal) {
+
+            if (each->into && !PyKAdminNameIndex_CheckExact(each->into)) {
+                if (_pykadmin_each_store_principal(self, principal))
+                    stop = 1;
+            }
+
+            if (!stop && each->callback) {
+
+                result = _pykadmin_each_invoke(each, (PyObject *)principal);
+
+                if (!result) { 
+                    stop = 1;
+                } else if (result == pykadmin_each_stop) {
+                    stop = 1;
+                }
+
+                Py_XDECREF(result);
+            }
+            
+            Py_DECREF(principal);
+        }
+    }
+
+    if (stop && PyErr_Occurred())
+        _pykadmin_each_encapsulate_error(&each->error);
+
+    each->count++;
+
+    if (!stop && _pykadmin_each_cycle_lock(self, each))
+        stop = 1;
+
+    return stop;
+}
 
 static int kdb_iter_princs(void *data, krb5_db_entry *kdb) {
+    return _pykadmin_each_principal_step((PyKAdminObject *)data, kdb, NULL) ? kEACH_STOP : 0;
+}
+
+#ifdef KADMIN_LOCAL
+
+static int lmdb_iter_princs(void *data, kadm5_principal_ent_rec *entry) {
+    return _pykadmin_each_principal_step((PyKAdminObject *)data, NULL, entry) ? kEACH_STOP : 0;
+}
+
+/*
+    threads > 0 (-1: one per cpu) on a klmdb realm: entries are converted on that many
+    threads. names-only scans have nothing to convert and take the plain path.
+*/
+static int _pykadmin_each_principal_threads(PyKAdminObject *self, int threads) {
+
+    each_iteration_t *each = &self->each_principal;
+
+    if (!threads || (!each->callback && PyKAdminNameIndex_CheckExact(each->into)))
+        return 0;
+
+    if (!pykadmin_lmdb_realm(self->context, self->realm))
+        return 0;
+
+    return (threads < 0) ? (int)sysconf(_SC_NPROCESSORS_ONLN) : threads;
+}
+
+#endif
+
+static PyObject *PyKAdminObject_each_principal(PyKAdminObject *self, PyObject *args, PyObject *kwds) {
+
+    PyObject *result = Py_True;
+    PyObject *callback = NULL;
+    PyObject *data = NULL;
+    PyObject *into = NULL;
+    char *match = NULL;
+    char *lock_name = NULL;
+    long limit = 0;
+    long chunk = 1000;
+    int threads = 0;
+    double deadline = 0;
+    krb5_error_code code = 0; 
+    kadm5_ret_t lock = KADM5_OK; 
+
+
+    static char *kwlist[] = {"callback", "data", "match", "limit", "deadline", "lock", "chunk", "into", "threads", NULL};
+    
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|OOzldzlOi", kwlist, &callback, &data, &match, &limit, &deadline, &lock_name, &chunk, &into, &threads))
+        return NULL;
+
+    if ((self->each_principal.lock_mode = _pykadmin_each_lock_mode(lock_name)) < 0)
+        return NULL;
+
+    if (_pykadmin_ready(self))
+        return NULL;
+
+    if (_pykadmin_each_parse_callback(&self->each_principal, callback, data))
+        return NULL;
+
+    self->each_principal.into = _pykadmin_each_parse_into(into);
+
+    if (PyErr_Occurred())
+        return NULL;
+
+    if (!self->each_principal.callback && !self->each_principal.into) {
+        PyErr_SetString(PyExc_TypeError, "each_principal requires a callback or into=");
+        return NULL;
+    }
+
+    self->each_principal.error = NULL;
+    self->each_principal.count = 0;
+    self->each_principal.limit = limit;
+    self->each_principal.chunk = chunk;
+    self->each_principal.deadline = (deadline > 0) ? pykadmin_monotonic() + deadline : 0;
+
+    Py_XINCREF(self->each_principal.callback);
+    Py_INCREF(self->each_principal.data);
+
+#ifdef KADMIN_LOCAL
+    threads = _pykadmin_each_principal_threads(self, threads);
+#endif
+
+    if ((lock = _pykadmin_each_lock(self, &self->each_principal)) == KADM5_OK) {
+
+        krb5_clear_error_message(self->context);
+
+#ifdef KADMIN_LOCAL
+        if (threads > 0)
+            code = pykadmin_lmdb_iterate(self->context, match, threads, (KADM5_PRINCIPAL_NORMAL_MASK | KADM5_KEY_DATA), lmdb_iter_princs, (void *)self);
+        else
+#endif
+        code = krb5_db_iterate(self->context, match, kdb_iter_princs, (void *)self
+#if (KRB5_KDB_API_VERSION >= 8)
+            , 0 /* flags */
+#endif
+        );
+
+        if (code == kEACH_STOP)
+            code = 0;
+    
+        _pykadmin_each_unlock(self);
+    }
+
+    Py_XDECREF(self->each_principal.callback);
+    Py_DECREF(self->each_principal.data);
+
+    if (lock != KADM5_OK) {
+        PyKAdminError_raise_error(lock, "kadm5_lock");
+        result = NULL;
+        goto cleanup;
+    }
+
+    if (code) { 
+        PyKAdminError_raise_error(code, "krb5_db_iterate");
+        result = NULL;
+        goto cleanup;
+    }
+
+    if (self->each_principal.error) {
+        _pykadmin_each_restore_error(self->each_principal.error);
+        result = NULL;
+        goto cleanup;
+    }
+
+    // with a sink the filled container is the result
+    if (self->each_principal.into)
+        result = self->each_principal.into;
+
+cleanup:
+
+    Py_XINCREF(result);
+    Py_CLEAR(self->each_principal.into);
+
+    return(result);
+
+}
+
+
+
+static void kdb_iter_pols(void *data, osa_policy_ent_rec *entry) {
+
+    PyKAdminObject *self = (PyKAdminObject *)data;
+    PyKAdminPolicyObject *policy = NULL;
+    PyObject *result = NULL;
+
+    if (!self->each_policy.error) {
+
+        policy = PyKAdminPolicyObject_policy_with_osa_entry(self, entry);
+
+        if (policy) {
+
+            if (self->each_policy.callback) {
+                
+                result = _pykadmin_each_invoke(&self->each_policy, (PyObject *)policy);
+                if (!result) { _pykadmin_each_encapsulate_error(&self->each_policy.error); }
+
+                Py_XDECREF(result);
+            }
+            
+            Py_DECREF(policy);
+        }
+
+        self->each_policy.count++;
+
+        _pykadmin_each_cycle_lock(self, &self->each_policy);
+    }   
+}
+
+
+static PyObject *PyKAdminObject_each_policy(PyKAdminObject *self, PyObject *args, PyObject *kwds) {
+    
+    char *match = NULL;
+    char *lock_name = NULL;
+    long chunk = 1000;
+    krb5_error_code code = 0; 
+    kadm5_ret_t lock = KADM5_OK; 
+
+    PyObject *result = Py_True;
+    PyObject *callback = NULL;
+    PyObject *data = NULL;
+
+    static char *kwlist[] = {"", "data", "match", "lock", "chunk", NULL};
+    
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O|Ozzl", kwlist, &callback, &data, &match, &lock_name, &chunk))
+        return NULL;
+
+    if ((self->each_policy.lock_mode = _pykadmin_each_lock_mode(lock_name)) < 0)
+        return NULL;
+
+    if (_pykadmin_ready(self))
+        return NULL;
+
+    if (_pykadmin_each_parse_callback(&self->each_policy, callback, data))
+        return NULL;
+
+    if (!self->each_policy.callback) {
+        PyErr_SetString(PyExc_TypeError, "each_policy requires a callback");
+        return NULL;
+    }
+
+    self->each_policy.error = NULL;
+    self->each_policy.count = 0;
+    self->each_policy.chunk = chunk;
+
+    Py_INCREF(self->each_policy.callback);
+    Py_INCREF(self->each_policy.data);
+    
+    lock = _pykadmin_each_lock(self, &self->each_policy);
+
+    if (lock == KADM5_OK) {
+
+        krb5_clear_error_message(self->context);
+
+        code = krb5_db_iter_policy(self->context, match, kdb_iter_pols, (void *)self);
+    
+        _pykadmin_each_unlock(self);
+    }
+
+    Py_DECREF(self->each_policy.callback);
+    Py_DECREF(self->each_policy.data);
+
+    if (lock != KADM5_OK) {
+        PyKAdminError_raise_error(lock, "kadm5_lock");
+        result = NULL;
+        goto cleanup;
+    }
+
+    if (code) { 
+        PyKAdminError_raise_error(code, "krb5_db_iter_policy");
+        result = NULL;
+        goto cleanup;
+    } 
+
+    if (self->each_policy.error) {
+        _pykadmin_each_restore_error(self->each_policy.error);
+        result = NULL;
+    }
+
+cleanup:
+
+    Py_XINCREF(result);
+    return result;
+
+}
+#endif
+
+static PyObject *PyKAdminObject_get_option(PyKAdminObject *self, PyObject *args) {
+
+    char *option = NULL;
+
+    if (!PyArg_ParseTuple(args, "s", &option))
+        return NULL;
+
+    return pykadmin_options_get(&self->options, option);
+}
 
-    PyKAdminObject *self = (PyKAdminObject *)data;
+static PyObject *PyKAdminObject_set_option(PyKAdminObject *self, PyObject *args) {
 
-    PyKAdminPrincipalObject *principal = NULL;
-    PyObject *result = NULL;
+    char *option    = NULL;
+    PyObject *value = NULL;
+    int result      = 0;
 
-    if (!self->each_principal.error) {
+    kadm5_ret_t retval = KADM5_OK;
 
-        principal = PyKAdminPrincipalObject_principal_with_db_entry(self, kdb);
+    if (!PyArg_ParseTuple(args, "sO", &option, &value))
+        return NULL;
 
-        if (principal) {
+    result = pykadmin_options_set(&self->options, option, value);
 
-            if (self->each_principal.callback) {
+    if (result > 0)
+        PyErr_Format(PyExc_ValueError, "unknown option \"%s\"", option);
+    if (result)
+        return NULL;
 
-                result = PyObject_CallFunctionObjArgs(self->each_principal.callback, principal, self->each_principal.data, NULL);            
-                if (!result) { _pykadmin_each_encapsulate_error(&self->each_principal.error); }
-            }
-            
-            Py_DECREF(principal);
+    // the rest only take effect when the handle next logs in
+    if (!strcmp(option, "timeout") && self->server_handle) {
+        retval = pykadmin_options_apply_timeout(self->server_handle, self->options.timeout);
+        if (retval != KADM5_OK) {
+            PyKAdminError_raise_error(retval, "clnt_control");
+            return NULL;
         }
     }
 
-    return 0;
-
+    Py_RETURN_NONE;
 }
 
+#ifndef KADMIN_LOCAL
+static PyObject *PyKAdminObject_enable_renewal(PyKAdminObject *self, PyObject *args, PyObject *kwds) {
 
+    double margin = 300;
 
-static PyObject *PyKAdminObject_each_principal(PyKAdminObject *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"margin", NULL};
 
-    PyObject *result = Py_True;
-    char *match = NULL;
-    krb5_error_code code = 0; 
-    kadm5_ret_t lock = KADM5_OK; 
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|d", kwlist, &margin))
+        return NULL;
 
+    if (margin < 0) {
+        PyErr_SetString(PyExc_ValueError, "margin must not be negative");
+        return NULL;
+    }
 
-    static char *kwlist[] = {"callback", "data", "match", NULL};
-    
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!|Oz", kwlist, &PyFunction_Type, &self->each_principal.callback, &self->each_principal.data, &match))
+    if (pykadmin_renewal_register(self, margin))
         return NULL;
 
-    if (!self->each_principal.data)
-        self->each_principal.data = Py_None;
+    Py_RETURN_TRUE;
+}
 
-    self->each_principal.error = NULL;
+static PyObject *PyKAdminObject_disable_renewal(PyKAdminObject *self) {
 
-    Py_INCREF(self->each_principal.callback);
-    Py_INCREF(self->each_principal.data);
-    
-    lock = kadm5_lock(self->server_handle);
+    pykadmin_renewal_unregister(self);
 
-    if ((lock == KADM5_OK) || (lock == KRB5_PLUGIN_OP_NOTSUPP)) {
+    Py_RETURN_TRUE;
+}
 
-        if (lock == KADM5_OK)
-            self->locked = 1;
+static PyObject *PyKAdminObject_failover(PyKAdminObject *self, PyObject *args, PyObject *kwds) {
 
-        krb5_clear_error_message(self->context);
+    kadm5_ret_t retval = KADM5_OK;
+    char *admin_server = NULL;
+    size_t index       = 0;
 
-        code = krb5_db_iterate(self->context, match, kdb_iter_princs, (void *)self
-#if (KRB5_KDB_API_VERSION >= 8)
-            , 0 /* flags */
-#endif
-        );
-    
-        if (lock != KRB5_PLUGIN_OP_NOTSUPP)  {
-            lock = kadm5_unlock(self->server_handle);
-            if (lock == KADM5_OK)
-                self->locked = 0;
-        }
-    }
+    static char *kwlist[] = {"admin_server", NULL};
 
-    Py_DECREF(self->each_principal.callback);
-    Py_DECREF(self->each_principal.data);
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|z", kwlist, &admin_server))
+        return NULL;
 
-    if (code) { 
-        PyKAdminError_raise_error(code, "krb5_db_iterate");
-        result = NULL;
-        goto cleanup;
+    if (!self->failover) {
+        PyErr_SetString(PyExc_ValueError, "handle was not connected with admin_servers");
+        return NULL;
     }
 
-    if (self->each_principal.error) {
-        _pykadmin_each_restore_error(self->each_principal.error);
+    if (_pykadmin_ready(self))
+        return NULL;
+
+    if (admin_server) {
+
+        for (; index < self->failover->count; index++) {
+            if (!strcmp(self->failover->members[index].admin_server, admin_server))
+                break;
+        }
+
+        if (index == self->failover->count) {
+            PyErr_Format(PyExc_ValueError, "\"%s\" is not one of the handle's admin_servers", admin_server);
+            return NULL;
+        }
     }
 
-cleanup:
+    retval = _pykadmin_failover(self, admin_server);
 
-    Py_XINCREF(result);
-    return(result);
+    if (retval != KADM5_OK) {
+        PyKAdminError_raise_error(retval, "kadmin.failover");
+        return NULL;
+    }
 
+    return PyUnicode_FromString(pykadmin_failover_active(self->failover)->admin_server);
 }
 
+static PyObject *PyKAdminObject_promote(PyKAdminObject *self, PyObject *args, PyObject *kwds) {
 
+    kadm5_ret_t retval = KADM5_OK;
+    char *admin_server = NULL;
+    size_t index       = 0;
 
-static void kdb_iter_pols(void *data, osa_policy_ent_rec *entry) {
-
-    PyKAdminObject *self = (PyKAdminObject *)data;
-    PyKAdminPolicyObject *policy = NULL;
-    PyObject *result = NULL;
+    static char *kwlist[] = {"admin_server", NULL};
 
-    if (!self->each_policy.error) {
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|z", kwlist, &admin_server))
+        return NULL;
 
-        policy = PyKAdminPolicyObject_policy_with_osa_entry(self, entry);
+    if (!self->failover) {
+        PyErr_SetString(PyExc_ValueError, "handle was not connected with admin_servers");
+        return NULL;
+    }
 
-        if (policy) {
+    if (_pykadmin_ready(self))
+        return NULL;
 
-            if (self->each_policy.callback) {
-                
-                result = PyObject_CallFunctionObjArgs(self->each_policy.callback, policy, self->each_policy.data, NULL);
-                if (!result) { _pykadmin_each_encapsulate_error(&self->each_policy.error); }
+    if (admin_server) {
 
-            }
-            
-            Py_DECREF(policy);
+        for (; index < self->failover->count; index++) {
+            if (!strcmp(self->failover->members[index].admin_server, admin_server))
+                break;
         }
-    }   
-}
-
 
-static PyObject *PyKAdminObject_each_policy(PyKAdminObject *self, PyObject *args, PyObject *kwds) {
-    
-    char *match = NULL;
-    krb5_error_code code = 0; 
-    kadm5_ret_t lock = KADM5_OK; 
+        if (index == self->failover->count) {
+            PyErr_Format(PyExc_ValueError, "\"%s\" is not one of the handle's admin_servers", admin_server);
+            return NULL;
+        }
+    }
 
-    PyObject *result = Py_True;
+    retval = _pykadmin_failover_writer(self, 1, admin_server);
 
-    static char *kwlist[] = {"", "data", "match", NULL};
-    
-    if (!PyArg_ParseTupleAndKeywords(args, kwds, "O!|Oz", kwlist, &PyFunction_Type, &self->each_policy.callback, &self->each_policy.data, &match))
+    if (retval != KADM5_OK) {
+        PyKAdminError_raise_error(retval, "kadmin.promote");
         return NULL;
+    }
 
-    if (!self->each_policy.data)
-        self->each_policy.data = Py_None;
+    return PyUnicode_FromString(pykadmin_failover_primary(self->failover)->admin_server);
+}
 
-    Py_INCREF(self->each_policy.callback);
-    Py_INCREF(self->each_policy.data);
-    
-    lock = kadm5_lock(self->server_handle);
+static PyObject *PyKAdminObject_attach_replica(PyKAdminObject *self, PyObject *args, PyObject *kwds) {
 
-    if ((lock == KADM5_OK) || (lock == KRB5_PLUGIN_OP_NOTSUPP)) {
+    pykadmin_replica_t *replica = NULL;
+    krb5_error_code code = 0;
+    PyObject *py_db_args = NULL;
+    char **db_args       = NULL;
+    double max_staleness = 0;
 
-        if (lock == KADM5_OK)
-            self->locked = 1;
+    static char *kwlist[] = {"db_args", "max_staleness", NULL};
 
-        krb5_clear_error_message(self->context);
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|Od", kwlist, &py_db_args, &max_staleness))
+        return NULL;
 
-        code = krb5_db_iter_policy(self->context, match, kdb_iter_pols, (void *)self);
-    
-        if (lock != KRB5_PLUGIN_OP_NOTSUPP)  {
-            lock = kadm5_unlock(self->server_handle);
-            if (lock == KADM5_OK)
-                self->locked = 0;
+    if (max_staleness < 0) {
+        PyErr_SetString(PyExc_ValueError, "max_staleness must not be negative");
+        return NULL;
+    }
+
+    if (py_db_args && (py_db_args != Py_None)) {
+        db_args = pykadmin_parse_db_args(py_db_args);
+        if (PyErr_Occurred()) {
+            pykadmin_free_db_args(db_args);
+            return NULL;
         }
     }
 
-    Py_DECREF(self->each_policy.callback);
-    Py_DECREF(self->each_policy.data);
+    // the replica keeps db_args, to open the database again after a fork
+    code = pykadmin_replica_open(self->realm, db_args, max_staleness, &replica);
 
-    if (code) { 
-        PyKAdminError_raise_error(code, "krb5_db_iter_policy");
-        result = NULL;
-        goto cleanup;
-    } 
+    if (code) {
+        PyKAdminError_raise_error(code, "krb5_db_open");
+        return NULL;
+    }
 
-    if (self->each_policy.error) {
-        _pykadmin_each_restore_error(self->each_policy.error);
-        result = NULL;
+    // without an update log no read would ever be found fresh enough
+    if ((max_staleness > 0) && !replica->ulog) {
+        pykadmin_replica_close(replica);
+        PyErr_SetString(PyExc_ValueError, "max_staleness needs iprop on the replica; pass 0 to read it whatever its age");
+        return NULL;
     }
 
-cleanup:
+    pykadmin_replica_close(self->replica);
+    self->replica = replica;
 
-    Py_XINCREF(result);
-    return result;
+    Py_RETURN_TRUE;
+}
+
+static PyObject *PyKAdminObject_detach_replica(PyKAdminObject *self) {
 
+    pykadmin_replica_close(self->replica);
+    self->replica = NULL;
+
+    Py_RETURN_TRUE;
 }
 #endif
 
@@ -500,11 +2172,39 @@ static PyMethodDef PyKAdminObject_methods[] = {
 
     {"principal_exists",    (PyCFunction)PyKAdminObject_principal_exists, METH_VARARGS, ""},
 
+    {"exists_many",         (PyCFunction)PyKAdminObject_exists_many,      (METH_VARARGS | METH_KEYWORDS), ""},
+
+    {"name",                (PyCFunction)PyKAdminObject_name,             METH_VARARGS, ""},
+
     // kadmin modify princ, rename princ 
 
     {"getprinc",            (PyCFunction)PyKAdminObject_get_principal,    METH_VARARGS, ""},
     {"get_principal",       (PyCFunction)PyKAdminObject_get_principal,    METH_VARARGS, ""},
     
+    {"enable_cache",        (PyCFunction)PyKAdminObject_enable_cache,     (METH_VARARGS | METH_KEYWORDS), ""},
+    {"disable_cache",       (PyCFunction)PyKAdminObject_disable_cache,    METH_NOARGS, ""},
+    {"cache_stats",         (PyCFunction)PyKAdminObject_cache_stats,      METH_NOARGS, ""},
+
+    {"enable_write_behind", (PyCFunction)PyKAdminObject_enable_write_behind,  (METH_VARARGS | METH_KEYWORDS), ""},
+    {"disable_write_behind",(PyCFunction)PyKAdminObject_disable_write_behind, METH_NOARGS, ""},
+    {"flush",               (PyCFunction)PyKAdminObject_flush,                METH_NOARGS, ""},
+
+    {"enable_policy_cache", (PyCFunction)PyKAdminObject_enable_policy_cache,  (METH_VARARGS | METH_KEYWORDS), ""},
+    {"disable_policy_cache",(PyCFunction)PyKAdminObject_disable_policy_cache, METH_NOARGS, ""},
+    {"refresh_policies",    (PyCFunction)PyKAdminObject_refresh_policies,     METH_NOARGS, ""},
+
+    {"get_option",          (PyCFunction)PyKAdminObject_get_option,       METH_VARARGS, ""},
+    {"set_option",          (PyCFunction)PyKAdminObject_set_option,       METH_VARARGS, ""},
+
+#   ifndef KADMIN_LOCAL
+    {"enable_renewal",      (PyCFunction)PyKAdminObject_enable_renewal,   (METH_VARARGS | METH_KEYWORDS), ""},
+    {"disable_renewal",     (PyCFunction)PyKAdminObject_disable_renewal,  METH_NOARGS, ""},
+    {"failover",            (PyCFunction)PyKAdminObject_failover,         (METH_VARARGS | METH_KEYWORDS), ""},
+    {"promote",             (PyCFunction)PyKAdminObject_promote,          (METH_VARARGS | METH_KEYWORDS), ""},
+    {"attach_replica",      (PyCFunction)PyKAdminObject_attach_replica,   (METH_VARARGS | METH_KEYWORDS), ""},
+    {"detach_replica",      (PyCFunction)PyKAdminObject_detach_replica,   METH_NOARGS, ""},
+#   endif
+
     {"getpol",              (PyCFunction)PyKAdminObject_get_policy,       METH_VARARGS, ""},
     {"get_policy",          (PyCFunction)PyKAdminObject_get_policy,       METH_VARARGS, ""},
 
@@ -527,6 +2227,169 @@ static PyMethodDef PyKAdminObject_methods[] = {
     {NULL, NULL, 0, NULL}
 };
 
+static PyObject *PyKAdminObject_get_time_format(PyKAdminObject *self, void *closure) {
+    return PyUnicode_FromString((self->time_format == kTIME_FORMAT_EPOCH) ? "epoch" : "datetime");
+}
+
+static int PyKAdminObject_set_time_format(PyKAdminObject *self, PyObject *value, void *closure) {
+
+    char *format = NULL;
+    int result   = -1;
+
+    if (value && PyUnicodeBytes_Check(value))
+        format = PyUnicode_or_PyBytes_asCString(value);
+
+    if (format) {
+        if (!strcmp(format, "epoch")) {
+            self->time_format = kTIME_FORMAT_EPOCH;
+            result = 0;
+        } else if (!strcmp(format, "datetime")) {
+            self->time_format = kTIME_FORMAT_DATETIME;
+            result = 0;
+        }
+        free(format);
+    }
+
+    if (result)
+        PyErr_SetString(PyExc_ValueError, "time_format must be \"epoch\" or \"datetime\"");
+
+    return result;
+}
+
+static PyObject *PyKAdminObject_get_controller(PyKAdminObject *self, void *closure) {
+
+    PyObject *controller = self->controller ? (PyObject *)self->controller : Py_None;
+
+    Py_INCREF(controller);
+    return controller;
+}
+
+static int PyKAdminObject_set_controller(PyKAdminObject *self, PyObject *value, void *closure) {
+
+    PyKAdminController *controller = NULL;
+
+    if (value && (value != Py_None)) {
+
+        if (!PyKAdminController_Check(value)) {
+            PyErr_SetString(PyExc_TypeError, "controller must be a kadmin.Controller or None");
+            return -1;
+        }
+
+        /*
+            calls only leave the GIL when nothing else uses the kadm5 handle's krb5 context:
+            with several admin servers each has its own, while a handle's single context is
+            also used for names, getters and caches under the GIL alone.
+        */
+        if (self->failover && !self->call_lock) {
+            self->call_lock = PyThread_allocate_lock();
+            if (!self->call_lock) {
+                PyErr_NoMemory();
+                return -1;
+            }
+        }
+
+        controller = (PyKAdminController *)value;
+        Py_INCREF(controller);
+    }
+
+    Py_XDECREF(self->controller);
+    self->controller = controller;
+
+    return 0;
+}
+
+static PyObject *PyKAdminObject_get_expires(PyKAdminObject *self, void *closure) {
+
+    krb5_timestamp expiry = pykadmin_renewal_expiry(self->context, self->server_handle);
+
+    if (!expiry)
+        Py_RETURN_NONE;
+
+    return PyUnifiedLongInt_FromLong(expiry);
+}
+
+static PyObject *PyKAdminObject_get_servers(PyKAdminObject *self, void *closure) {
+
+    pykadmin_failover_member_t *member = NULL;
+    PyObject *servers = NULL;
+    PyObject *server  = NULL;
+    size_t index      = 0;
+
+    if (!self->failover)
+        Py_RETURN_NONE;
+
+    servers = PyList_New(self->failover->count);
+    if (!servers)
+        return NULL;
+
+    for (; index < self->failover->count; index++) {
+
+        member = &self->failover->members[index];
+
+        server = Py_BuildValue("{s:s,s:O,s:O,s:O,s:d,s:k,s:k}",
+                    "admin_server", member->admin_server,
+                    "active",       (index == self->failover->active) ? Py_True : Py_False,
+                    "primary",      (index == self->failover->primary) ? Py_True : Py_False,
+                    "healthy",      member->healthy ? Py_True : Py_False,
+                    "latency",      member->latency,
+                    "calls",        member->calls,
+                    "failures",     member->failures);
+
+        if (!server) {
+            Py_DECREF(servers);
+            return NULL;
+        }
+
+        PyList_SET_ITEM(servers, index, server);
+    }
+
+    return servers;
+}
+
+static PyObject *PyKAdminObject_get_replica(PyKAdminObject *self, void *closure) {
+
+    uint32_t serial = 0;
+    time_t updated  = 0;
+    int known       = 0;
+
+    if (!self->replica)
+        Py_RETURN_NONE;
+
+    known = pykadmin_replica_state(self->replica, &serial, &updated);
+
+    return Py_BuildValue("{s:O,s:N,s:N,s:n,s:k,s:k}",
+                "fresh",     pykadmin_replica_usable(self->replica) ? Py_True : Py_False,
+                "serial",    known ? PyLong_FromUnsignedLong(serial) : (Py_INCREF(Py_None), Py_None),
+                "updated",   known ? PyUnifiedLongInt_FromLong(updated) : (Py_INCREF(Py_None), Py_None),
+                "pending",   (Py_ssize_t)pykadmin_replica_pending(self->replica),
+                "reads",     self->replica->reads,
+                "fallbacks", self->replica->fallbacks);
+}
+
+static PyObject *PyKAdminObject_get_write_behind(PyKAdminObject *self, void *closure) {
+
+    if (!self->commits)
+        Py_RETURN_NONE;
+
+    return Py_BuildValue("{s:n,s:d,s:n,s:k,s:k,s:k}",
+                "pending",     (Py_ssize_t)self->commits->count,
+                "delay",       self->commits->delay,
+                "max_pending", (Py_ssize_t)self->commits->max_pending,
+                "commits",     self->commits->commits,
+                "writes",      self->commits->writes,
+                "errors",      self->commits->errors);
+}
+
+static PyGetSetDef PyKAdminObject_getters_setters[] = {
+    {"write_behind",(getter)PyKAdminObject_get_write_behind,NULL,                                     "queued commits and counters with write-behind enabled, None otherwise", NULL},
+    {"replica",     (getter)PyKAdminObject_get_replica,     NULL,                                     "state of the attached replica KDB, None when reads go to kadmind", NULL},
+    {"servers",     (getter)PyKAdminObject_get_servers,     NULL,                                     "state of each admin server of a failover handle, None otherwise", NULL},
+    {"expires",     (getter)PyKAdminObject_get_expires,     NULL,                                     "when the kadmin service ticket expires (epoch seconds), None if unknown", NULL},
+    {"controller",  (getter)PyKAdminObject_get_controller,  (setter)PyKAdminObject_set_controller,  "kadmin.Controller shared with other handles, or None", NULL},
+    {"time_format", (getter)PyKAdminObject_get_time_format, (setter)PyKAdminObject_set_time_format, "\"datetime\" (default) or \"epoch\": type returned by principal time getters", NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
 
 PyTypeObject PyKAdminObject_Type = {
     PyVarObject_HEAD_INIT(NULL, 0)
@@ -560,7 +2423,7 @@ PyTypeObject PyKAdminObject_Type = {
     0,                     /* tp_iternext */
     PyKAdminObject_methods,             /* tp_methods */
     0,             /* tp_members */
-    0,                         /* tp_getset */
+    PyKAdminObject_getters_setters,     /* tp_getset */
     0,                         /* tp_base */
     0,                         /* tp_dict */
     0,                         /* tp_descr_get */
@@ -577,6 +2440,164 @@ PyKAdminObject *PyKAdminObject_create(void) {
     return (PyKAdminObject *)PyKAdminObject_new(&PyKAdminObject_Type, NULL, NULL);
 }
 
+void PyKAdminObject_replace_handle(PyKAdminObject *self, krb5_context context, void *server_handle) {
+
+    void *previous = NULL;
+
+    // a controlled call may be using the old handle without the GIL
+    if (self->call_lock) {
+        Py_BEGIN_ALLOW_THREADS
+        PyThread_acquire_lock(self->call_lock, WAIT_LOCK);
+        Py_END_ALLOW_THREADS
+    }
+
+    if (self->failover) {
+
+        // only the active server's handle and context are replaced
+        pykadmin_failover_replace_active(self->failover, context, server_handle);
+        self->server_handle = server_handle;
+
+    } else {
+
+        previous = self->server_handle;
+        self->server_handle = server_handle;
+
+        if (previous)
+            kadm5_destroy(previous);
+
+        _pykadmin_context_release(self);
+
+        self->context        = context;
+        self->shared_context = 0;
+    }
+
+    if (self->call_lock)
+        PyThread_release_lock(self->call_lock);
+}
+
+kadm5_ret_t PyKAdminObject_relogin(PyKAdminObject *self) {
+
+    if (self->failover)
+        return _pykadmin_failover(self, NULL);
+
+    return pykadmin_session_reinit(self->context, self->session, &self->options, &self->server_handle);
+}
+
+kadm5_ret_t PyKAdminObject_reconnect(PyKAdminObject *self) {
+
+    kadm5_ret_t retval = KADM5_OK;
+#   ifdef KADMIN_LOCAL
+    krb5_context context = NULL;
+#   endif
+
+    if (self->generation != pykadmin_fork_generation)
+        _pykadmin_abandon(self);
+
+    if (self->replica && (self->replica->generation != pykadmin_fork_generation))
+        self->replica = pykadmin_replica_reopen(self->replica);
+
+    if (!self->session)
+        return KADM5_BAD_SERVER_HANDLE;
+
+    if (self->failover) {
+
+        // the active server only; standbys log in again when failed over to
+        retval = pykadmin_failover_select(self->failover, self->session, &self->options, pykadmin_failover_active(self->failover)->admin_server);
+        self->server_handle = pykadmin_failover_active(self->failover)->server_handle;
+
+    } else {
+
+#       ifdef KADMIN_LOCAL
+        // the inherited context has the parent's database open; it is left alone
+        retval = kadm5_init_krb5_context(&context);
+        if (retval != KADM5_OK)
+            return retval;
+
+        retval = pykadmin_session_login(context, self->session, &self->options, &self->server_handle);
+
+        if (retval == KADM5_OK)
+            self->context = context;
+        else
+            krb5_free_context(context);
+#       else
+        retval = pykadmin_session_login(self->context, self->session, &self->options, &self->server_handle);
+#       endif
+
+        if (retval != KADM5_OK)
+            self->server_handle = NULL;
+    }
+
+    if (retval != KADM5_OK)
+        return retval;
+
+    self->stale = 0;
+
+    // the renewal thread stayed behind in the parent
+    pykadmin_renewal_resume(self);
+
+    return KADM5_OK;
+}
+
+static void _pykadmin_fork_child(void) {
+    pykadmin_fork_generation++;
+}
+
+int PyKAdminObject_fork_init(void) {
+    return pthread_atfork(NULL, NULL, _pykadmin_fork_child);
+}
+
+double PyKAdminObject_call_enter(PyKAdminObject *self, PyKAdminController *controller, krb5_const_principal written, long long *serial, kadm5_ret_t *retval) {
+
+    uint32_t current = 0;
+    time_t updated   = 0;
+
+    *retval = KADM5_OK;
+
+    // writes wait for the primary, or the server promoted in its place
+    if (written && self->failover)
+        *retval = _pykadmin_failover_writer(self, 0, NULL);
+
+    // where the replica's log stood before the write; once per call, not per retry
+    if (written && (*serial < 0) && pykadmin_replica_state(self->replica, &current, &updated))
+        *serial = current;
+
+    if (controller)
+        return pykadmin_controller_enter(controller);
+
+    return pykadmin_monotonic();
+}
+
+void PyKAdminObject_call_handle(PyKAdminObject *self, int write) {
+
+    if (self->failover)
+        self->server_handle = (write ? pykadmin_failover_primary(self->failover) : pykadmin_failover_active(self->failover))->server_handle;
+}
+
+int PyKAdminObject_call_exit(PyKAdminObject *self, PyKAdminController *controller, double started, kadm5_ret_t retval, int retry, int attempt, krb5_const_principal written, long long serial) {
+
+    int moved = 0;
+
+    if (controller)
+        pykadmin_controller_exit(controller, started, retval);
+
+    if (written && (retval == KADM5_OK))
+        pykadmin_replica_wrote(self->replica, written, serial);
+
+    // a write that found no primary to go to was never made
+    if (self->failover && (!written || pykadmin_failover_primary(self->failover)->server_handle)
+        && pykadmin_failover_record(self->failover, pykadmin_monotonic() - started, retval, (written != NULL)))
+        moved = (_pykadmin_failover(self, NULL) == KADM5_OK);
+
+    if (!retry)
+        return 0;
+
+    // straight to the new server, once per server
+    if (moved && ((size_t)attempt < self->failover->count))
+        return 1;
+
+    return controller ? pykadmin_controller_retry(controller, retval, attempt) : 0;
+}
+
 void PyKAdminObject_destroy(PyKAdminObject *self) {
     PyKAdminObject_dealloc(self); 
 }
@@ -9,31 +9,193 @@
 #include <string.h>
 #include <structmember.h>
 
+#include "PyKAdminCache.h"
+#include "PyKAdminPolicyTable.h"
+#include "PyKAdminSession.h"
+#include "PyKAdminController.h"
+#include "PyKAdminFailover.h"
+#include "PyKAdminReplica.h"
+
 typedef struct {
 	PyObject *callback;
 	PyObject *data;
     PyObject *error;
+
+    // built-in sink filled directly in C (list, dict or kadmin.NameIndex)
+    PyObject *into;
+
+    long limit;
+    long count;
+    double deadline;
+
+    int lock_mode;
+    long chunk;
 } each_iteration_t; 
 
+/* how an each_* scan holds kadm5_lock against concurrent kadmind writes */
+enum {
+    kEACH_LOCK_FULL = 0,    // hold the lock for the whole scan
+    kEACH_LOCK_CHUNKED,     // release and retake the lock every `chunk` entries
+    kEACH_LOCK_NONE         // never take kadm5_lock; only the backend's own iteration lock applies
+};
+
+/* what principal getters return for timestamps and durations (kadm.time_format) */
+enum {
+    kTIME_FORMAT_DATETIME = 0,  // datetime.datetime / datetime.timedelta
+    kTIME_FORMAT_EPOCH          // int seconds, None for "never"
+};
+
 typedef struct {
     PyObject_HEAD
     
     uint8_t locked; 
 
+    int time_format;
+
     krb5_context context; 
+    // context is the process-wide shared one rather than owned by this handle
+    uint8_t shared_context;
     void *server_handle;
     char *realm;
+
+    // pykadmin_fork_generation server_handle was made in; stale until a login in this one succeeds
+    unsigned long generation;
+    uint8_t stale;
+
+    // credentials the handle authenticated with, to log in again in place
+    pykadmin_session_t *session;
+
+    // admin_server, kadmind_port, timeout, retries (kadm.set_option)
+    pykadmin_options_t options;
+
+    // admin_servers given to kadmin.connect; server_handle is then the active one's, the primary's during a write
+    pykadmin_failover_t *failover;
+
+    // local KDB of a replica KDC serving reads (kadm.attach_replica), NULL otherwise
+    pykadmin_replica_t *replica;
+
+    // kadm.controller, NULL unless set; call_lock serializes calls made without the GIL
+    PyKAdminController *controller;
+    PyThread_type_lock call_lock;
     
     each_iteration_t each_principal;
     each_iteration_t each_policy;
 
+    // opt-in getprinc cache, NULL unless enable_cache() was called
+    pykadmin_cache_t *cache;
+
+    // opt-in policy table, NULL unless enable_policy_cache() was called
+    pykadmin_policy_table_t *policies;
+
+    // principals in the realm as of this handle's last full listing, 0 if none (exists_many)
+    size_t realm_size;
+
+    // opt-in write-behind queue for principal commits, NULL unless enable_write_behind() was called
+    struct _pykadmin_commit_queue *commits;
+
     PyObject *_storage; 
     
 } PyKAdminObject;
 
 PyTypeObject PyKAdminObject_Type;
 
+// returned by an each_principal callback to end the scan early (kadmin.STOP)
+extern PyObject *pykadmin_each_stop;
+
+/*
+    new handles borrow one refcounted krb5 context (and default realm) instead of each
+    parsing krb5.conf/kdc.conf again; kadmin.set_option("shared_context", False) gives
+    later handles their own. always off in kadmin_local, where the context carries the
+    open database and kadm5_destroy closes it.
+*/
+extern int pykadmin_shared_context_enabled;
+
+/*
+    a handle inherited across fork shares its kadmind connection and GSS context (in
+    kadmin_local, the open database) with the parent. it is logged in again on first use
+    in the child; the inherited kadm5 handle is abandoned, never kadm5_destroy'ed, as that
+    would end the parent's session too. the krb5 context, caches and policy table carry over.
+*/
+#define PyKAdminObject_STALE(kadmin) (((kadmin)->generation != pykadmin_fork_generation) || (kadmin)->stale)
+
+/*
+    make a kadm5 call on kadmin, assigning its result to retval. with a controller
+    attached the call waits for a slot, reports its latency and outcome, and (when
+    retry is set, i.e. for reads) runs again after transient failures. with several
+    admin servers, a transient failure moves reads to another server and they are
+    retried there. PyKAdmin_WRITE makes a write of princ, never retried, on the primary
+    admin server; when there is none to take it the call is not made and retval says
+    why. replica reads of princ then go to kadmind until the replica has applied it.
+    handles with several admin servers, whose kadm5 handles each have a krb5 context
+    nothing else uses, make controlled calls without the GIL (holding call_lock) so
+    calls through different handles overlap. any other handle's context is also used
+    under the GIL alone (names, getters, caches), so its calls keep the GIL. an
+    inherited handle logs in first.
+*/
+#define _PyKAdmin_CALL(kadmin, retval, retry, written, call) do {                   \
+        PyKAdminController *_controller = (kadmin)->controller;                     \
+        double _started  = 0;                                                       \
+        long long _serial = -1;                                                     \
+        int _attempt     = 0;                                                       \
+        if (PyKAdminObject_STALE(kadmin) && ((retval = PyKAdminObject_reconnect(kadmin)) != KADM5_OK)) \
+            break;                                                                  \
+        if (!_controller && !(kadmin)->failover && !(kadmin)->replica) {           \
+            retval = (call);                                                        \
+            break;                                                                  \
+        }                                                                           \
+        Py_XINCREF(_controller);                                                    \
+        do {                                                                        \
+            _started = PyKAdminObject_call_enter((kadmin), _controller, (written), &_serial, &(retval)); \
+            if ((retval == KADM5_OK) && _controller && (kadmin)->call_lock) {       \
+                Py_BEGIN_ALLOW_THREADS                                              \
+                PyThread_acquire_lock((kadmin)->call_lock, WAIT_LOCK);              \
+                PyKAdminObject_call_handle((kadmin), ((written) != NULL));          \
+                retval = (call);                                                    \
+                PyKAdminObject_call_handle((kadmin), 0);                            \
+                PyThread_release_lock((kadmin)->call_lock);                         \
+                Py_END_ALLOW_THREADS                                                \
+            } else if (retval == KADM5_OK) {                                        \
+                PyKAdminObject_call_handle((kadmin), ((written) != NULL));          \
+                retval = (call);                                                    \
+                PyKAdminObject_call_handle((kadmin), 0);                            \
+            }                                                                       \
+        } while (PyKAdminObject_call_exit((kadmin), _controller, _started, retval, (retry), _attempt++, (written), _serial)); \
+        Py_XDECREF(_controller);                                                    \
+    } while (0)
+
+#define PyKAdmin_CALL(kadmin, retval, retry, call)    _PyKAdmin_CALL(kadmin, retval, retry, NULL, call)
+#define PyKAdmin_WRITE(kadmin, retval, princ, call)   _PyKAdmin_CALL(kadmin, retval, 0, princ, call)
+
 PyKAdminObject *PyKAdminObject_create(void);
+
+/* 
+    swap in a freshly authenticated server_handle (and the context it was made with,
+    which the handle then owns), destroying the old ones. call with the GIL held.
+*/
+void PyKAdminObject_replace_handle(PyKAdminObject *self, krb5_context context, void *server_handle);
+
+// log in again after the handle stopped answering (another server, when it has several)
+kadm5_ret_t PyKAdminObject_relogin(PyKAdminObject *self);
+
+// log an inherited (or not yet re-logged-in) handle in again in this process. GIL held.
+kadm5_ret_t PyKAdminObject_reconnect(PyKAdminObject *self);
+
+/*
+    load the realm's policies into self->policies through PyKAdmin_CALL (reconnecting an
+    inherited handle, pacing and failing over like any read). when force is not set, only
+    if the table was never loaded or has expired. GIL held.
+*/
+kadm5_ret_t PyKAdminObject_load_policies(PyKAdminObject *self, int force);
+
+// registers the fork handler; once, at module init
+int PyKAdminObject_fork_init(void);
+
+// PyKAdmin_CALL bookkeeping: call_exit returns whether to make the call again
+double PyKAdminObject_call_enter(PyKAdminObject *self, PyKAdminController *controller, krb5_const_principal written, long long *serial, kadm5_ret_t *retval);
+
+// point server_handle at the server a call goes to: the primary for a write, else the active one. call_lock or the GIL held.
+void PyKAdminObject_call_handle(PyKAdminObject *self, int write);
+int PyKAdminObject_call_exit(PyKAdminObject *self, PyKAdminController *controller, double started, kadm5_ret_t retval, int retry, int attempt, krb5_const_principal written, long long serial);
 void PyKAdminObject_destroy(PyKAdminObject *self);
 
 #endif
\ No newline at end of file
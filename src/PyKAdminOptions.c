@@ -0,0 +1,240 @@
+
+#include "PyKAdminOptions.h"
+#include "PyKAdminCommon.h"
+
+#include <kadm5/kadm_err.h>
+#include <errno.h>
+#include <sys/time.h>
+
+#define kOPTION_MAX_PORT 65535
+
+pykadmin_options_t pykadmin_default_options = {0, NULL, 0, 0, 1.0, 10.0, 60.0};
+
+#ifndef KADMIN_LOCAL
+
+// kadm5clnt's own per-call TIMEOUT
+#define kKADM5_DEFAULT_TIMEOUT 25
+
+#endif
+
+int pykadmin_options_copy(pykadmin_options_t *to, const pykadmin_options_t *from) {
+
+    char *admin_server = NULL;
+
+    if (from->admin_server) {
+        admin_server = strdup(from->admin_server);
+        if (!admin_server)
+            return -1;
+    }
+
+    if (to->admin_server && (to->admin_server != from->admin_server))
+        free(to->admin_server);
+
+    *to = *from;
+    to->admin_server = admin_server;
+
+    return 0;
+}
+
+void pykadmin_options_clear(pykadmin_options_t *options) {
+
+    if (options->admin_server) 
+        free(options->admin_server);
+
+    options->admin_server = NULL;
+}
+
+void pykadmin_options_params(const pykadmin_options_t *options, kadm5_config_params *params) {
+
+    if (options->admin_server) {
+        params->admin_server = options->admin_server;
+        params->mask |= KADM5_CONFIG_ADMIN_SERVER;
+    }
+
+    if (options->kadmind_port) {
+        params->kadmind_port = options->kadmind_port;
+        params->mask |= KADM5_CONFIG_KADMIND_PORT;
+    }
+}
+
+int pykadmin_options_retryable(kadm5_ret_t retval) {
+
+    switch (retval) {
+        case KADM5_RPC_ERROR:
+        case KRB5_KDC_UNREACH:
+        case ECONNREFUSED:
+        case ETIMEDOUT:
+        case EHOSTUNREACH:
+            return 1;
+    }
+
+    return 0;
+}
+
+kadm5_ret_t pykadmin_options_apply_timeout(void *server_handle, double timeout) {
+
+#ifndef KADMIN_LOCAL
+
+    pykadmin_client_handle_rec *handle = server_handle;
+    struct timeval tv;
+
+    if (!handle || (handle->magic_number != kKADM5_SERVER_HANDLE_MAGIC) || !handle->clnt)
+        return KADM5_BAD_SERVER_HANDLE;
+
+    // clnttcp only honours the timeout passed to each call until one is set, so "default" is explicit
+    if (timeout <= 0)
+        timeout = kKADM5_DEFAULT_TIMEOUT;
+
+    tv.tv_sec  = (long)timeout;
+    tv.tv_usec = (long)((timeout - (double)tv.tv_sec) * 1e6);
+
+    if (!clnt_control(handle->clnt, CLSET_TIMEOUT, (char *)&tv))
+        return KADM5_RPC_ERROR;
+
+#endif
+
+    return KADM5_OK;
+}
+
+static int _pykadmin_option_seconds(PyObject *value, double *seconds, const char *name) {
+
+    if (value == Py_None) {
+        *seconds = 0;
+        return 0;
+    }
+
+    if (PyNumber_Check(value) && !PyBool_Check(value)) {
+        *seconds = PyFloat_AsDouble(value);
+        if ((*seconds == -1.0) && PyErr_Occurred())
+            return -1;
+        if (*seconds >= 0)
+            return 0;
+    }
+
+    PyErr_Format(PyExc_ValueError, "%s must be a number of seconds >= 0 or None", name);
+    return -1;
+}
+
+static int _pykadmin_option_int(PyObject *value, long max, long *result, const char *name) {
+
+    if (value == Py_None) {
+        *result = 0;
+        return 0;
+    }
+
+    if (PyUnifiedLongInt_Check(value)) {
+        *result = PyUnifiedLongInt_AsLong(value);
+        if ((*result == -1) && PyErr_Occurred())
+            return -1;
+        if ((*result >= 0) && (*result <= max))
+            return 0;
+    }
+
+    PyErr_Format(PyExc_ValueError, "%s must be an int between 0 and %ld or None", name, max);
+    return -1;
+}
+
+PyObject *pykadmin_options_get(const pykadmin_options_t *options, const char *name) {
+
+    if (!strcmp(name, "timeout")) {
+        if (options->timeout > 0)
+            return PyFloat_FromDouble(options->timeout);
+        Py_RETURN_NONE;
+    }
+
+    if (!strcmp(name, "admin_server")) {
+        if (options->admin_server)
+            return PyUnicode_FromString(options->admin_server);
+        Py_RETURN_NONE;
+    }
+
+    if (!strcmp(name, "kadmind_port")) {
+        if (options->kadmind_port)
+            return PyUnifiedLongInt_FromLong(options->kadmind_port);
+        Py_RETURN_NONE;
+    }
+
+    if (!strcmp(name, "retries"))
+        return PyUnifiedLongInt_FromLong(options->retries);
+
+    if (!strcmp(name, "retry_delay"))
+        return PyFloat_FromDouble(options->retry_delay);
+
+    if (!strcmp(name, "failover_deadline"))
+        return PyFloat_FromDouble(options->failover_deadline);
+
+    if (!strcmp(name, "primary_deadline"))
+        return PyFloat_FromDouble(options->primary_deadline);
+
+    PyErr_Format(PyExc_ValueError, "unknown option \"%s\"", name);
+    return NULL;
+}
+
+int pykadmin_options_set(pykadmin_options_t *options, const char *name, PyObject *value) {
+
+    char *admin_server = NULL;
+    double seconds = 0;
+    long number    = 0;
+
+    if (!strcmp(name, "timeout")) {
+
+        if (_pykadmin_option_seconds(value, &seconds, name))
+            return -1;
+        options->timeout = seconds;
+
+    } else if (!strcmp(name, "admin_server")) {
+
+        if (value != Py_None) {
+
+            if (!PyUnicodeBytes_Check(value)) {
+                PyErr_SetString(PyExc_ValueError, "admin_server must be str or None");
+                return -1;
+            }
+
+            admin_server = PyUnicode_or_PyBytes_asCString(value);
+            if (!admin_server) {
+                if (!PyErr_Occurred())
+                    PyErr_NoMemory();
+                return -1;
+            }
+        }
+
+        pykadmin_options_clear(options);
+        options->admin_server = admin_server;
+
+    } else if (!strcmp(name, "kadmind_port")) {
+
+        if (_pykadmin_option_int(value, kOPTION_MAX_PORT, &number, name))
+            return -1;
+        options->kadmind_port = (int)number;
+
+    } else if (!strcmp(name, "retries")) {
+
+        if (_pykadmin_option_int(value, 100, &number, name))
+            return -1;
+        options->retries = (int)number;
+
+    } else if (!strcmp(name, "retry_delay")) {
+
+        if (_pykadmin_option_seconds(value, &seconds, name))
+            return -1;
+        options->retry_delay = seconds;
+
+    } else if (!strcmp(name, "failover_deadline")) {
+
+        if (_pykadmin_option_seconds(value, &seconds, name))
+            return -1;
+        options->failover_deadline = seconds;
+
+    } else if (!strcmp(name, "primary_deadline")) {
+
+        if (_pykadmin_option_seconds(value, &seconds, name))
+            return -1;
+        options->primary_deadline = seconds;
+
+    } else {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,53 @@
+
+#ifndef PYKADMINOPTIONS_H
+#define PYKADMINOPTIONS_H
+
+#include <Python.h>
+#include <kadm5/admin.h>
+#include <krb5/krb5.h>
+
+/*
+    connection tuning for kadm5 handles.
+
+    kadmin.set_option changes the defaults new handles copy; kadm.set_option changes one
+    handle. admin_server and kadmind_port go into the kadm5_config_params of every
+    (re)init; timeout bounds each RPC to kadmind once the handle is up (the client
+    library otherwise waits 25 seconds per call); retries and retry_delay cover init
+    failing to reach kadmind; failover_deadline bounds the switch to another of a
+    handle's admin_servers, and primary_deadline is how long the first of them may fail
+    before writes move to another. none of these affect kadmin_local.
+*/
+
+typedef struct {
+    double timeout;         // seconds per RPC, 0 for the library default
+    char *admin_server;     // host[:port], NULL for krb5.conf
+    int kadmind_port;       // 0 for krb5.conf
+    int retries;            // extra init attempts when kadmind can't be reached
+    double retry_delay;     // seconds before the first retry, doubled for each one after
+    double failover_deadline;   // seconds to find another admin server, 0 for no limit
+    double primary_deadline;    // seconds the primary may fail before writes move, 0 to wait for a promote
+} pykadmin_options_t;
+
+extern pykadmin_options_t pykadmin_default_options;
+
+// -1 when out of memory
+int pykadmin_options_copy(pykadmin_options_t *to, const pykadmin_options_t *from);
+void pykadmin_options_clear(pykadmin_options_t *options);
+
+// fill the mask and fields of params (which borrows admin_server)
+void pykadmin_options_params(const pykadmin_options_t *options, kadm5_config_params *params);
+
+// whether an init failure is worth retrying (kadmind unreachable rather than refused)
+int pykadmin_options_retryable(kadm5_ret_t retval);
+
+kadm5_ret_t pykadmin_options_apply_timeout(void *server_handle, double timeout);
+
+/*
+    python-level access by option name. get returns a new reference, or NULL with
+    ValueError for an unknown name. set returns 0, -1 with ValueError for a bad value, or
+    1 (no exception) for a name it doesn't know, so callers can handle their own.
+*/
+PyObject *pykadmin_options_get(const pykadmin_options_t *options, const char *name);
+int pykadmin_options_set(pykadmin_options_t *options, const char *name, PyObject *value);
+
+#endif
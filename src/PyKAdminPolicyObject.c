@@ -10,6 +10,9 @@
 static void PyKAdminPolicyObject_dealloc(PyKAdminPolicyObject *self) {
     
     if (self) {
+        // drop the policy table's borrowed reference to this shared object
+        pykadmin_policy_table_forget(self->kadmin->policies, (PyObject *)self);
+
         kadm5_free_policy_ent(self->kadmin->server_handle, &self->entry);  
 
         Py_XDECREF(self->kadmin);
@@ -38,7 +41,7 @@ static kadm5_ret_t _PyKAdminPolicyObject_load(PyKAdminPolicyObject *self, char *
 
     kadm5_ret_t retval = 0;
 
-    retval = kadm5_get_policy(self->kadmin->server_handle, policy_name, &self->entry);
+    PyKAdmin_CALL(self->kadmin, retval, 1, kadm5_get_policy(self->kadmin->server_handle, policy_name, &self->entry));
 
     return retval;
 }
@@ -155,10 +158,60 @@ PyTypeObject PyKAdminPolicyObject_Type = {
     PyKAdminPolicyObject_new,                 /* tp_new */
 };
 
+/* shared kadmin.Policy for a policy table slot, created on first use */
+static PyKAdminPolicyObject *_PyKAdminPolicyObject_policy_with_slot(PyKAdminObject *kadmin, pykadmin_policy_slot_t *slot) {
+
+    PyKAdminPolicyObject *policy = (PyKAdminPolicyObject *)slot->object;
+
+    if (policy) {
+        Py_INCREF(policy);
+        return policy;
+    }
+
+    policy = (PyKAdminPolicyObject *)PyKAdminPolicyObject_new(&PyKAdminPolicyObject_Type, NULL, NULL);
+
+    if (policy) {
+
+        Py_INCREF(kadmin);
+        policy->kadmin = kadmin;
+
+        // the handle uses KADM5_API_VERSION_2 so the name is the only allocated member
+        memcpy(&policy->entry, &slot->entry, sizeof(kadm5_policy_ent_rec));
+        policy->entry.policy = strdup(slot->entry.policy);
+
+        if (!policy->entry.policy) {
+            Py_DECREF(policy);
+            return (PyKAdminPolicyObject *)PyErr_NoMemory();
+        }
+
+        slot->object = (PyObject *)policy;
+    }
+
+    return policy;
+}
+
 PyKAdminPolicyObject *PyKAdminPolicyObject_policy_with_name(PyKAdminObject *kadmin, char *name) {
 
     kadm5_ret_t retval = 0;
     PyKAdminPolicyObject *policy = NULL; 
+    pykadmin_policy_slot_t *slot = NULL;
+
+    if (kadmin->policies) {
+
+        retval = PyKAdminObject_load_policies(kadmin, 0);
+        if (retval) {
+            PyKAdminError_raise_error(retval, "kadm5_get_policies");
+            return NULL;
+        }
+
+        slot = pykadmin_policy_table_lookup(kadmin->policies, name);
+        if (!slot) {
+            Py_INCREF(Py_None);
+            return (PyKAdminPolicyObject *)Py_None;
+        }
+
+        return _PyKAdminPolicyObject_policy_with_slot(kadmin, slot);
+    }
 
     policy = (PyKAdminPolicyObject *)PyKAdminPolicyObject_new(&PyKAdminPolicyObject_Type, NULL, NULL);
     
@@ -169,7 +222,15 @@ PyKAdminPolicyObject *PyKAdminPolicyObject_policy_with_name(PyKAdminObject *kadm
         retval = _PyKAdminPolicyObject_load(policy, name);
 
         if (retval) {
-            PyKAdminPolicyObject_dealloc(policy);
+            Py_DECREF(policy);
+            policy = NULL;
+
+            if (retval == KADM5_UNK_POLICY) {
+                Py_INCREF(Py_None);
+                policy = (PyKAdminPolicyObject *)Py_None;
+            } else {
+                PyKAdminError_raise_error(retval, "kadm5_get_policy");
+            }
         }
 
     }
@@ -0,0 +1,97 @@
+
+#include "PyKAdminPolicyTable.h"
+#include "PyKAdminCommon.h"
+
+struct _pykadmin_policy_table {
+
+    double ttl;
+    double expires;
+    int loaded;
+
+    // sorted by name
+    size_t count;
+    pykadmin_policy_slot_t *slots;
+};
+
+
+pykadmin_policy_table_t *pykadmin_policy_table_create(double ttl) {
+
+    pykadmin_policy_table_t *table = calloc(1, sizeof(pykadmin_policy_table_t));
+
+    if (table)
+        table->ttl = ttl;
+
+    return table;
+}
+
+void pykadmin_policy_table_release(void *server_handle, pykadmin_policy_slot_t *slots, size_t count) {
+
+    size_t index = 0;
+
+    for (; index < count; index++)
+        kadm5_free_policy_ent(server_handle, &slots[index].entry);
+
+    free(slots);
+}
+
+void pykadmin_policy_table_destroy(void *server_handle, pykadmin_policy_table_t *table) {
+
+    if (table) {
+        pykadmin_policy_table_release(server_handle, table->slots, table->count);
+        free(table);
+    }
+}
+
+static int _pykadmin_policy_slot_compare(const void *a, const void *b) {
+    return strcmp(((const pykadmin_policy_slot_t *)a)->name, ((const pykadmin_policy_slot_t *)b)->name);
+}
+
+int pykadmin_policy_table_expired(pykadmin_policy_table_t *table) {
+    return !table->loaded || ((table->ttl > 0) && (pykadmin_monotonic() >= table->expires));
+}
+
+void pykadmin_policy_table_replace(void *server_handle, pykadmin_policy_table_t *table, pykadmin_policy_slot_t *slots, size_t count) {
+
+    size_t index = 0;
+
+    for (; index < count; index++)
+        slots[index].name = slots[index].entry.policy;
+
+    qsort(slots, count, sizeof(pykadmin_policy_slot_t), _pykadmin_policy_slot_compare);
+
+    // objects handed out from the old load keep their own copies and simply stop being shared
+    pykadmin_policy_table_release(server_handle, table->slots, table->count);
+
+    table->slots   = slots;
+    table->count   = count;
+    table->loaded  = 1;
+    table->expires = pykadmin_monotonic() + table->ttl;
+}
+
+pykadmin_policy_slot_t *pykadmin_policy_table_lookup(pykadmin_policy_table_t *table, const char *name) {
+
+    pykadmin_policy_slot_t key;
+
+    if (!table || !name || !table->count)
+        return NULL;
+
+    key.name = (char *)name;
+
+    return bsearch(&key, table->slots, table->count, sizeof(pykadmin_policy_slot_t), _pykadmin_policy_slot_compare);
+}
+
+void pykadmin_policy_table_forget(pykadmin_policy_table_t *table, PyObject *object) {
+
+    size_t index = 0;
+
+    if (table) {
+        for (; index < table->count; index++) {
+            if (table->slots[index].object == object)
+                table->slots[index].object = NULL;
+        }
+    }
+}
+
+size_t pykadmin_policy_table_count(pykadmin_policy_table_t *table) {
+    return table ? table->count : 0;
+}
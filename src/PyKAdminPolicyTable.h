@@ -0,0 +1,44 @@
+
+#ifndef PYKADMINPOLICYTABLE_H
+#define PYKADMINPOLICYTABLE_H
+
+#include <Python.h>
+#include <kadm5/admin.h>
+#include <krb5/krb5.h>
+
+/*
+    per-handle table of every policy in the realm.
+
+    loaded with one kadm5_get_policies listing plus one kadm5_get_policy per name (made by
+    PyKAdminObject_load_policies, through PyKAdmin_CALL), then reloaded when older than ttl (ttl 0 keeps the first load until refreshed explicitly).
+    answers policy_exists and the principal policy setter, and lets getpol hand out one
+    shared kadmin.Policy per name: the table only borrows that object, which clears its
+    slot again when it is deallocated.
+*/
+
+typedef struct {
+    char *name;
+    kadm5_policy_ent_rec entry;
+
+    // borrowed PyKAdminPolicyObject sharing this entry, NULL while none is alive
+    PyObject *object;
+} pykadmin_policy_slot_t;
+
+typedef struct _pykadmin_policy_table pykadmin_policy_table_t;
+
+pykadmin_policy_table_t *pykadmin_policy_table_create(double ttl);
+void pykadmin_policy_table_destroy(void *server_handle, pykadmin_policy_table_t *table);
+
+/* never loaded, or older than ttl */
+int pykadmin_policy_table_expired(pykadmin_policy_table_t *table);
+
+/* take count fetched slots (entry filled in) as the table's contents */
+void pykadmin_policy_table_replace(void *server_handle, pykadmin_policy_table_t *table, pykadmin_policy_slot_t *slots, size_t count);
+void pykadmin_policy_table_release(void *server_handle, pykadmin_policy_slot_t *slots, size_t count);
+
+pykadmin_policy_slot_t *pykadmin_policy_table_lookup(pykadmin_policy_table_t *table, const char *name);
+void pykadmin_policy_table_forget(pykadmin_policy_table_t *table, PyObject *object);
+
+size_t pykadmin_policy_table_count(pykadmin_policy_table_t *table);
+
+#endif
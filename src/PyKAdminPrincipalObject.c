@@ -4,8 +4,10 @@
 #include "PyKAdminIterator.h"
 #include "PyKAdminPrincipalObject.h"
 #include "PyKAdminPolicyObject.h"
+#include "PyKAdminCommitQueue.h"
 
 #include "PyKAdminCommon.h"
+#include "PyKAdminDate.h"
 
 #include <bytesobject.h>
 #include <datetime.h>
@@ -15,8 +17,6 @@
 
 static PyObject *PyKAdminPrincipal_get_keys(PyKAdminPrincipalObject *self, void *closure);
 
-static char kNEVER[] = "never";
-
 static const unsigned int kFLAG_MAX =
     ( KRB5_KDB_DISALLOW_POSTDATED 
     | KRB5_KDB_DISALLOW_FORWARDABLE 
@@ -37,8 +37,45 @@ static const unsigned int kFLAG_MAX =
     | KRB5_KDB_NO_AUTH_DATA_REQUIRED );
 
 
+/* return the memoized value of slot, converting it with expression on first access */
+#define PyKAdminPrincipal_MEMOIZE(self, slot, expression)   \
+    do {                                                    \
+        if (!(self)->slots[slot])                           \
+            (self)->slots[slot] = (expression);             \
+        Py_XINCREF((self)->slots[slot]);                    \
+        return (self)->slots[slot];                         \
+    } while (0)
+
+static void _PyKAdminPrincipal_clear_slots(PyKAdminPrincipalObject *self) {
+
+    int slot = 0;
+
+    for (; slot < kPRINCIPAL_SLOT_COUNT; slot++)
+        Py_CLEAR(self->slots[slot]);
+}
+
+/* drop converted times built under a time_format the handle no longer uses */
+static void _PyKAdminPrincipal_sync_time_format(PyKAdminPrincipalObject *self) {
+
+    if (self->slots_time_format != self->kadmin->time_format) {
+
+        Py_CLEAR(self->slots[kPRINCIPAL_SLOT_MOD_DATE]);
+        Py_CLEAR(self->slots[kPRINCIPAL_SLOT_LAST_PWD_CHANGE]);
+        Py_CLEAR(self->slots[kPRINCIPAL_SLOT_LAST_SUCCESS]);
+        Py_CLEAR(self->slots[kPRINCIPAL_SLOT_LAST_FAILED]);
+        Py_CLEAR(self->slots[kPRINCIPAL_SLOT_EXPIRE]);
+        Py_CLEAR(self->slots[kPRINCIPAL_SLOT_PWEXPIRE]);
+        Py_CLEAR(self->slots[kPRINCIPAL_SLOT_MAXLIFE]);
+        Py_CLEAR(self->slots[kPRINCIPAL_SLOT_MAXRENEWLIFE]);
+
+        self->slots_time_format = self->kadmin->time_format;
+    }
+}
+
 static void PyKAdminPrincipal_dealloc(PyKAdminPrincipalObject *self) {
    
+    _PyKAdminPrincipal_clear_slots(self);
+
     kadm5_free_principal_ent(self->kadmin->server_handle, &self->entry);
 
     Py_XDECREF(self->kadmin);
@@ -220,14 +257,37 @@ static PyObject *PyKAdminPrincipal_unset_attributes(PyKAdminPrincipalObject *sel
 
 
 
+/* writes through this handle make any cached copy of the principal stale */
+static void _PyKAdminPrincipal_invalidate(PyKAdminPrincipalObject *self) {
+    pykadmin_cache_invalidate(self->kadmin->context, self->kadmin->cache, self->entry.principal);
+}
+
 static PyObject *PyKAdminPrincipal_commit(PyKAdminPrincipalObject *self) {
 
     PyObject *result = NULL;
     kadm5_ret_t retval = KADM5_OK; 
+    int queued = 0;
 
     if (self && self->mask) {
 
-        retval = kadm5_modify_principal(self->kadmin->server_handle, &self->entry, self->mask);
+        // write-behind: the queue writes (and invalidates the cache) later
+        if (self->kadmin->commits) {
+
+            queued = pykadmin_commit_queue_put(self->kadmin->commits, &self->entry, self->mask);
+
+            if (queued < 0)
+                goto cleanup;
+
+            if (queued) {
+                self->mask = 0;
+                result = Py_True;
+                goto cleanup;
+            }
+        }
+
+        PyKAdmin_WRITE(self->kadmin, retval, self->entry.principal, kadm5_modify_principal(self->kadmin->server_handle, &self->entry, self->mask));
+
+        _PyKAdminPrincipal_invalidate(self);
         
         if (retval == KADM5_OK) {
             result = Py_True;
@@ -263,13 +323,16 @@ static PyObject *PyKAdminPrincipal_reload(PyKAdminPrincipalObject *self) {
             goto cleanup;
         }
 
+        _PyKAdminPrincipal_clear_slots(self);
+
         retval = kadm5_free_principal_ent(self->kadmin->server_handle, &self->entry);
         if (retval != KADM5_OK) { 
             PyKAdminError_raise_error(retval, "kadm5_free_principal_ent"); 
             goto cleanup;
         } 
 
-        retval = kadm5_get_principal(self->kadmin->server_handle, temp, &self->entry, KADM5_PRINCIPAL_NORMAL_MASK);
+        if (!pykadmin_replica_get_principal(self->kadmin->replica, temp, &self->entry, KADM5_PRINCIPAL_NORMAL_MASK, &retval))
+            PyKAdmin_CALL(self->kadmin, retval, 1, kadm5_get_principal(self->kadmin->server_handle, temp, &self->entry, KADM5_PRINCIPAL_NORMAL_MASK));
         if (retval != KADM5_OK) { 
             PyKAdminError_raise_error(retval, "kadm5_get_principal"); 
             goto cleanup;
@@ -350,6 +413,8 @@ static PyObject *PyKAdminPrincipal_unlock(PyKAdminPrincipalObject *self) {
 
     self->mask |= KADM5_TL_DATA;
 
+    _PyKAdminPrincipal_invalidate(self);
+
     Py_RETURN_TRUE;
 }
 
@@ -363,7 +428,10 @@ static PyObject *PyKAdminPrincipal_change_password(PyKAdminPrincipalObject *self
     if (!PyArg_ParseTuple(args, "s", &password))
         return NULL; 
 
-    retval = kadm5_chpass_principal(self->kadmin->server_handle, self->entry.principal, password);
+    PyKAdmin_WRITE(self->kadmin, retval, self->entry.principal, kadm5_chpass_principal(self->kadmin->server_handle, self->entry.principal, password));
+
+    _PyKAdminPrincipal_invalidate(self);
+
     if (retval != KADM5_OK) {
         PyKAdminError_raise_error(retval, "kadm5_chpass_principal");
         result = NULL;
@@ -378,7 +446,10 @@ static PyObject *PyKAdminPrincipal_randomize_key(PyKAdminPrincipalObject *self)
     PyObject *result   = Py_True;
     kadm5_ret_t retval = KADM5_OK; 
 
-    retval = kadm5_randkey_principal(self->kadmin->server_handle, self->entry.principal, NULL, NULL);
+    PyKAdmin_WRITE(self->kadmin, retval, self->entry.principal, kadm5_randkey_principal(self->kadmin->server_handle, self->entry.principal, NULL, NULL));
+
+    _PyKAdminPrincipal_invalidate(self);
+
     if (retval != KADM5_OK)  {
         PyKAdminError_raise_error(retval, "kadm5_randkey_principal");
         result = NULL;
@@ -422,13 +493,13 @@ PyObject *PyKAdminPrincipal_RichCompare(PyObject *o1, PyObject *o2, int opid) {
  *  GETTERS
  */
 
-static PyObject *PyKAdminPrincipal_get_principal(PyKAdminPrincipalObject *self, void *closure) {
+static PyObject *_PyKAdminPrincipal_unparse(PyKAdminPrincipalObject *self, krb5_principal name) {
   
     krb5_error_code code = 0;
     PyObject *principal  = NULL;
     char *client_name    = NULL;
     
-    code = krb5_unparse_name(self->kadmin->context, self->entry.principal, &client_name);
+    code = krb5_unparse_name(self->kadmin->context, name, &client_name);
     if (code) {
         PyKAdminError_raise_error(code, "krb5_unparse_name");
         goto cleanup;
@@ -445,71 +516,79 @@ cleanup:
 }
 
 
-static PyObject *PyKAdminPrincipal_get_mod_name(PyKAdminPrincipalObject *self, void *closure) {
-  
-    krb5_error_code code = 0;
-    PyObject *principal  = NULL;
-    char *client_name    = NULL;
-    
-    code = krb5_unparse_name(self->kadmin->context, self->entry.mod_name, &client_name);
-    if (code) {
-        PyKAdminError_raise_error(code, "krb5_unparse_name");
-        goto cleanup;
-    }
+static PyObject *PyKAdminPrincipal_get_principal(PyKAdminPrincipalObject *self, void *closure) {
+    PyKAdminPrincipal_MEMOIZE(self, kPRINCIPAL_SLOT_PRINCIPAL, _PyKAdminPrincipal_unparse(self, self->entry.principal));
+}
 
-    principal = PyUnicode_FromString(client_name);
+static PyObject *PyKAdminPrincipal_get_mod_name(PyKAdminPrincipalObject *self, void *closure) {
+    PyKAdminPrincipal_MEMOIZE(self, kPRINCIPAL_SLOT_MOD_NAME, _PyKAdminPrincipal_unparse(self, self->entry.mod_name));
+}
 
-cleanup:
+static PyObject *_PyKAdminPrincipal_timestamp(PyKAdminPrincipalObject *self, krb5_timestamp timestamp) {
 
-    if (client_name)
-        free(client_name);
+    if (self->kadmin->time_format == kTIME_FORMAT_EPOCH) {
+        if (!timestamp)
+            Py_RETURN_NONE;
+        return PyUnifiedLongInt_FromLong(timestamp);
+    }
 
-    return principal;
+    return pykadmin_pydatetime_from_timestamp(timestamp);
 }
 
 static PyObject *PyKAdminPrincipal_get_last_pwd_change(PyKAdminPrincipalObject *self, void *closure) {
-    return pykadmin_pydatetime_from_timestamp(self->entry.last_pwd_change);
+    _PyKAdminPrincipal_sync_time_format(self);
+    PyKAdminPrincipal_MEMOIZE(self, kPRINCIPAL_SLOT_LAST_PWD_CHANGE, _PyKAdminPrincipal_timestamp(self, self->entry.last_pwd_change));
 }
 
 static PyObject *PyKAdminPrincipal_get_expire(PyKAdminPrincipalObject *self, void *closure) {
-    return pykadmin_pydatetime_from_timestamp(self->entry.princ_expire_time);
+    _PyKAdminPrincipal_sync_time_format(self);
+    PyKAdminPrincipal_MEMOIZE(self, kPRINCIPAL_SLOT_EXPIRE, _PyKAdminPrincipal_timestamp(self, self->entry.princ_expire_time));
 }
 
 static PyObject *PyKAdminPrincipal_get_pwexpire(PyKAdminPrincipalObject *self, void *closure) {
-    return pykadmin_pydatetime_from_timestamp(self->entry.pw_expiration);
+    _PyKAdminPrincipal_sync_time_format(self);
+    PyKAdminPrincipal_MEMOIZE(self, kPRINCIPAL_SLOT_PWEXPIRE, _PyKAdminPrincipal_timestamp(self, self->entry.pw_expiration));
 }
 
 static PyObject *PyKAdminPrincipal_get_mod_date(PyKAdminPrincipalObject *self, void *closure) {
-    return pykadmin_pydatetime_from_timestamp(self->entry.mod_date);
+    _PyKAdminPrincipal_sync_time_format(self);
+    PyKAdminPrincipal_MEMOIZE(self, kPRINCIPAL_SLOT_MOD_DATE, _PyKAdminPrincipal_timestamp(self, self->entry.mod_date));
 }
 
 static PyObject *PyKAdminPrincipal_get_last_success(PyKAdminPrincipalObject *self, void *closure) {
-    return pykadmin_pydatetime_from_timestamp(self->entry.last_success);
+    _PyKAdminPrincipal_sync_time_format(self);
+    PyKAdminPrincipal_MEMOIZE(self, kPRINCIPAL_SLOT_LAST_SUCCESS, _PyKAdminPrincipal_timestamp(self, self->entry.last_success));
 }
 
 static PyObject *PyKAdminPrincipal_get_last_failed(PyKAdminPrincipalObject *self, void *closure) {
-    return pykadmin_pydatetime_from_timestamp(self->entry.last_failed);
+    _PyKAdminPrincipal_sync_time_format(self);
+    PyKAdminPrincipal_MEMOIZE(self, kPRINCIPAL_SLOT_LAST_FAILED, _PyKAdminPrincipal_timestamp(self, self->entry.last_failed));
 }
 
-static PyObject *PyKAdminPrincipal_get_maxrenewlife(PyKAdminPrincipalObject *self, void *closure) {
+static PyObject *_PyKAdminPrincipal_delta(PyKAdminPrincipalObject *self, krb5_deltat seconds) {
 
-    PyDateTime_IMPORT;
+    PyObject *delta = NULL;
 
-    PyObject *delta = PyDelta_FromDSU(0, self->entry.max_renewable_life, 0);
+    if (self->kadmin->time_format == kTIME_FORMAT_EPOCH)
+        return PyUnifiedLongInt_FromLong(seconds);
+
+    if (!PyDateTimeAPI)
+        PyDateTime_IMPORT;
+
+    delta = PyDelta_FromDSU(0, seconds, 0);
     if (!delta) { PyErr_SetString(PyExc_AttributeError, NULL); }
 
     return delta;
 }
 
+static PyObject *PyKAdminPrincipal_get_maxrenewlife(PyKAdminPrincipalObject *self, void *closure) {
+    _PyKAdminPrincipal_sync_time_format(self);
+    PyKAdminPrincipal_MEMOIZE(self, kPRINCIPAL_SLOT_MAXRENEWLIFE, _PyKAdminPrincipal_delta(self, self->entry.max_renewable_life));
+}
 
 static PyObject *PyKAdminPrincipal_get_maxlife(PyKAdminPrincipalObject *self, void *closure) {
-
-    PyDateTime_IMPORT;
-
-    PyObject *delta = PyDelta_FromDSU(0, self->entry.max_life, 0);
-    if (!delta) { PyErr_SetString(PyExc_AttributeError, NULL); }
-
-    return delta;
+    _PyKAdminPrincipal_sync_time_format(self);
+    PyKAdminPrincipal_MEMOIZE(self, kPRINCIPAL_SLOT_MAXLIFE, _PyKAdminPrincipal_delta(self, self->entry.max_life));
 }
 
 static PyObject *PyKAdminPrincipal_get_attributes(PyKAdminPrincipalObject *self, void *closure) {
@@ -533,64 +612,103 @@ static PyObject *PyKAdminPrincipal_get_attributes(PyKAdminPrincipalObject *self,
 
 }
 
-static PyObject *PyKAdminPrincipal_get_policy(PyKAdminPrincipalObject *self, void *closure) {
+static PyObject *_PyKAdminPrincipal_policy(PyKAdminPrincipalObject *self) {
 
-    PyObject *result = Py_None;
-    
-    if (self) {
+    if (self->entry.policy)
+        return PyUnicode_FromString(self->entry.policy);
 
-        if (self->entry.policy) {
-            result = PyUnicode_FromString(self->entry.policy);
-        }
-    }
+    Py_RETURN_NONE;
+}
 
-    Py_XINCREF(result);
-    return result;
+static PyObject *PyKAdminPrincipal_get_policy(PyKAdminPrincipalObject *self, void *closure) {
+    PyKAdminPrincipal_MEMOIZE(self, kPRINCIPAL_SLOT_POLICY, _PyKAdminPrincipal_policy(self));
 }
 
 static PyObject *PyKAdminPrincipal_get_kvno(PyKAdminPrincipalObject *self, void *closure) {
+    PyKAdminPrincipal_MEMOIZE(self, kPRINCIPAL_SLOT_KVNO, PyUnifiedLongInt_FromLong(self->entry.kvno));
+}
 
-    PyObject *result = NULL;
-    
-    if (self) {
-        result = PyUnifiedLongInt_FromLong(self->entry.kvno);
-    }
 
-    Py_XINCREF(result);
-    return result;
+
+/*
+    prebuilt names for every enctype and salt type the library knows, so the keys getter
+    hands out shared (interned on python3) strings instead of formatting each key.
+    values outside the tables or unknown to the library are formatted on demand.
+*/
+
+#define kKEY_ENCTYPE_MAX  64
+#define kKEY_SALTTYPE_MAX 16
+
+static PyObject *pykadmin_enctype_names[kKEY_ENCTYPE_MAX];
+static PyObject *pykadmin_salttype_names[kKEY_SALTTYPE_MAX];
+
+static PyObject *_pykadmin_key_name(const char *name) {
+#ifdef PYTHON3
+    return PyUnicode_InternFromString(name);
+#else
+    return PyUnicode_FromString(name);
+#endif
 }
 
+int PyKAdminPrincipalObject_init_key_names(void) {
 
+    char buffer[256];
+    krb5_int16 type = 0;
 
-PyObject *pykadmin_key_enctype_name(krb5_key_data *key_data) {
+    for (type = 0; type < kKEY_ENCTYPE_MAX; type++) {
+        if (!pykadmin_enctype_names[type] && !krb5_enctype_to_name(type, FALSE, buffer, sizeof(buffer))) {
+            pykadmin_enctype_names[type] = _pykadmin_key_name(buffer);
+            if (!pykadmin_enctype_names[type])
+                return -1;
+        }
+    }
 
-    PyObject *enctype = NULL;
-    // make sure this is enough. 
-    char buffer[1024];
+    for (type = 0; type < kKEY_SALTTYPE_MAX; type++) {
+        if (!pykadmin_salttype_names[type] && !krb5_salttype_to_string(type, buffer, sizeof(buffer))) {
+            pykadmin_salttype_names[type] = _pykadmin_key_name(buffer);
+            if (!pykadmin_salttype_names[type])
+                return -1;
+        }
+    }
+
+    return 0;
+}
 
-    if (krb5_enctype_to_name(key_data->key_data_type[0], FALSE, buffer, sizeof(buffer)))
-        snprintf(buffer, sizeof(buffer), "<Encryption type 0x%x>", key_data->key_data_type[0]);
+/* new reference to the name of a key's enctype */
+static PyObject *pykadmin_key_enctype_name(krb5_key_data *key_data) {
 
-    enctype = PyUnicode_FromString(buffer);
+    krb5_int16 type = key_data->key_data_type[0];
+    char buffer[256];
 
-    return enctype;
+    if ((type >= 0) && (type < kKEY_ENCTYPE_MAX) && pykadmin_enctype_names[type]) {
+        Py_INCREF(pykadmin_enctype_names[type]);
+        return pykadmin_enctype_names[type];
+    }
+
+    if (krb5_enctype_to_name(type, FALSE, buffer, sizeof(buffer)))
+        snprintf(buffer, sizeof(buffer), "<Encryption type 0x%x>", type);
+
+    return PyUnicode_FromString(buffer);
 }
 
-PyObject *pykadmin_key_salttype_name(krb5_key_data *key_data) {
+/* new reference to the name of a key's salt type */
+static PyObject *pykadmin_key_salttype_name(krb5_key_data *key_data) {
 
-    PyObject *salttype = NULL;
-    // make sure this is enough. 
-    char buffer[1024];
+    krb5_int16 type = key_data->key_data_type[1];
+    char buffer[256];
 
-    if (krb5_salttype_to_string(key_data->key_data_type[1], buffer, sizeof(buffer)))
-        snprintf(buffer, sizeof(buffer), "<Salt type 0x%x>", key_data->key_data_type[0]);
+    if ((type >= 0) && (type < kKEY_SALTTYPE_MAX) && pykadmin_salttype_names[type]) {
+        Py_INCREF(pykadmin_salttype_names[type]);
+        return pykadmin_salttype_names[type];
+    }
 
-    salttype = PyUnicode_FromString(buffer);
+    if (krb5_salttype_to_string(type, buffer, sizeof(buffer)))
+        snprintf(buffer, sizeof(buffer), "<Salt type 0x%x>", type);
 
-    return salttype;
+    return PyUnicode_FromString(buffer);
 }
 
-static PyObject *PyKAdminPrincipal_get_keys(PyKAdminPrincipalObject *self, void *closure) { 
+static PyObject *_PyKAdminPrincipal_keys(PyKAdminPrincipalObject *self) { 
 
     /*
 
@@ -612,35 +730,156 @@ static PyObject *PyKAdminPrincipal_get_keys(PyKAdminPrincipalObject *self, void
     PyObject *keys = PyDict_New();
 
     ssize_t index = 0; 
+    Py_ssize_t position = 0;
+
+    if (!keys)
+        return NULL;
 
     for (; index < self->entry.n_key_data; index++) {
 
         krb5_key_data *key_data = &self->entry.key_data[index];
 
-        kvno = PyUnifiedLongInt_FromLong(key_data->key_data_kvno);
-
+        kvno     = PyUnifiedLongInt_FromLong(key_data->key_data_kvno);
         enctype  = pykadmin_key_enctype_name(key_data);
         salttype = pykadmin_key_salttype_name(key_data);
 
+        if (!kvno || !enctype || !salttype)
+            goto error;
+
         tuple = PyTuple_Pack(2, enctype, salttype);
+        if (!tuple)
+            goto error;
 
+        // borrowed
+        list = PyDict_GetItem(keys, kvno);
 
-        if (kvno) {
-            if (PyDict_Contains(keys, kvno)) {
-                list = PyDict_GetItem(keys, kvno);
-            } else {
-                list = PyList_New(0);
-                PyDict_SetItem(keys, kvno, list);
+        if (!list) {
+            list = PyList_New(0);
+            if (!list || PyDict_SetItem(keys, kvno, list)) {
+                Py_XDECREF(list);
+                goto error;
             }
+            Py_DECREF(list);
         }
 
-        if (list && tuple) {
-            PyList_Append(list, tuple);
+        if (PyList_Append(list, tuple))
+            goto error;
+
+        Py_CLEAR(tuple);
+        Py_CLEAR(kvno);
+        Py_CLEAR(enctype);
+        Py_CLEAR(salttype);
+    }
+
+    // frozen for the slot: replacing a key's value does not resize the dict mid-walk
+    while (PyDict_Next(keys, &position, &kvno, &list)) {
+
+        // kvno and list are borrowed here
+        tuple = PyList_AsTuple(list);
+        if (!tuple || PyDict_SetItem(keys, kvno, tuple)) {
+            Py_XDECREF(tuple);
+            Py_DECREF(keys);
+            return NULL;
         }
 
+        Py_CLEAR(tuple);
     }
 
     return keys;
+
+error:
+
+    Py_XDECREF(tuple);
+    Py_XDECREF(kvno);
+    Py_XDECREF(enctype);
+    Py_XDECREF(salttype);
+    Py_DECREF(keys);
+
+    return NULL;
+}
+
+/*
+    the keys structure is built once per object until reload, with tuples of keys per
+    kvno; every access gets its own dict of lists made from it, so a caller changing
+    what it got back can't change what later reads (or print) see.
+*/
+static PyObject *PyKAdminPrincipal_get_keys(PyKAdminPrincipalObject *self, void *closure) { 
+
+    PyObject *keys  = NULL;
+    PyObject *kvno  = NULL;
+    PyObject *value = NULL;
+    PyObject *list  = NULL;
+    Py_ssize_t position = 0;
+
+    if (!self->slots[kPRINCIPAL_SLOT_KEYS]) {
+        self->slots[kPRINCIPAL_SLOT_KEYS] = _PyKAdminPrincipal_keys(self);
+        if (!self->slots[kPRINCIPAL_SLOT_KEYS])
+            return NULL;
+    }
+
+    keys = PyDict_New();
+    if (!keys)
+        return NULL;
+
+    while (PyDict_Next(self->slots[kPRINCIPAL_SLOT_KEYS], &position, &kvno, &value)) {
+
+        list = PySequence_List(value);
+        if (!list || PyDict_SetItem(keys, kvno, list)) {
+            Py_XDECREF(list);
+            Py_DECREF(keys);
+            return NULL;
+        }
+
+        Py_DECREF(list);
+    }
+
+    return keys;
+}
+
+/*
+    flat array('i') of (kvno, enctype, salt) triples, one per key, for bulk analysis
+    without building a tuple or name per key.
+*/
+static PyObject *PyKAdminPrincipal_get_keys_raw(PyKAdminPrincipalObject *self, void *closure) {
+
+    static PyObject *array_type = NULL;
+
+    PyObject *module = NULL;
+    PyObject *bytes  = NULL;
+    PyObject *result = NULL;
+    int *raw         = NULL;
+    ssize_t index    = 0;
+    ssize_t count    = self->entry.n_key_data;
+
+    if (!array_type) {
+        module = PyImport_ImportModule("array");
+        if (!module)
+            return NULL;
+        array_type = PyObject_GetAttrString(module, "array");
+        Py_DECREF(module);
+        if (!array_type)
+            return NULL;
+    }
+
+    bytes = PyBytes_FromStringAndSize(NULL, count * 3 * sizeof(int));
+    if (!bytes)
+        return NULL;
+
+    raw = (int *)PyBytes_AS_STRING(bytes);
+
+    for (; index < count; index++) {
+        krb5_key_data *key_data = &self->entry.key_data[index];
+
+        raw[(index * 3) + 0] = key_data->key_data_kvno;
+        raw[(index * 3) + 1] = key_data->key_data_type[0];
+        raw[(index * 3) + 2] = key_data->key_data_type[1];
+    }
+
+    // array(typecode, bytes) copies the buffer in native byte order
+    result = PyObject_CallFunction(array_type, "sO", "i", bytes);
+    Py_DECREF(bytes);
+
+    return result;
 }
 
 
@@ -649,9 +888,10 @@ static PyObject *PyKAdminPrincipal_get_keys(PyKAdminPrincipalObject *self, void
  */
 
 
-static krb5_deltat _decode_timedelta_input(PyObject *timedelta) {
+krb5_deltat PyKAdminPrincipal_decode_timedelta(PyObject *timedelta) {
 
-    PyDateTime_IMPORT;
+    if (!PyDateTimeAPI)
+        PyDateTime_IMPORT;
 
     time_t now = 0; 
     krb5_deltat delta = TIME_NONE;  
@@ -662,32 +902,44 @@ static krb5_deltat _decode_timedelta_input(PyObject *timedelta) {
 
         if (PyDelta_CheckExact(timedelta)) {
             delta = pykadmin_seconds_from_pydatetime(timedelta);
+        } else if (PyUnifiedLongInt_Check(timedelta)) {
+            // seconds, as returned in time_format "epoch"
+            delta = PyUnifiedLongInt_AsLong(timedelta);
+            if ((delta == TIME_NONE) && PyErr_Occurred())
+                PyErr_Clear();
         } else if (PyUnicodeBytes_Check(timedelta)) {
             date_string = PyUnicode_or_PyBytes_asCString(timedelta);
         } else if (timedelta == Py_None) {
-            date_string = kNEVER;
+            delta = 0;
         }
         
         if (date_string) {
-            delta = get_date(date_string);
+
+            // get_date yields an absolute time, relative to now
+            if (!pykadmin_parse_duration(date_string, &delta)) {
+                delta = get_date(date_string);
+                if ((delta != TIME_NONE) && (delta != 0)) {
+                    time(&now);
+                    delta -= now;
+                }
+            }
+
+            free(date_string);
         }
 
     }
 
-    if (delta == TIME_NONE) {
+    if (delta == TIME_NONE)
         PyErr_SetString(PyExc_ValueError, "Invalid input");
-    } else if (delta != 0) {
-        time(&now);
-        delta -= now;
-    }
 
     return delta;
 
 }
 
-static krb5_timestamp _decode_timestamp_input(PyObject *date) {
+krb5_timestamp PyKAdminPrincipal_decode_timestamp(PyObject *date) {
 
-    PyDateTime_IMPORT;
+    if (!PyDateTimeAPI)
+        PyDateTime_IMPORT;
 
     krb5_timestamp timestamp = TIME_NONE;  
 
@@ -697,14 +949,23 @@ static krb5_timestamp _decode_timestamp_input(PyObject *date) {
 
         if (PyDate_CheckExact(date) || PyDateTime_CheckExact(date)) {
             timestamp = pykadmin_timestamp_from_pydatetime(date);
+        } else if (PyUnifiedLongInt_Check(date)) {
+            // epoch seconds, as returned in time_format "epoch"
+            timestamp = PyUnifiedLongInt_AsLong(date);
+            if ((timestamp == TIME_NONE) && PyErr_Occurred())
+                PyErr_Clear();
         } else if (PyUnicodeBytes_Check(date)) {
             date_string = PyUnicode_or_PyBytes_asCString(date);
         } else if (date == Py_None) {
-            date_string = kNEVER;
+            timestamp = 0;
         }
         
         if (date_string) {
-            timestamp = get_date(date_string);
+
+            if (!pykadmin_parse_timestamp(date_string, &timestamp))
+                timestamp = get_date(date_string);
+
+            free(date_string);
         }
 
     }
@@ -718,7 +979,7 @@ static krb5_timestamp _decode_timestamp_input(PyObject *date) {
 
 int PyKAdminPrincipal_set_expire(PyKAdminPrincipalObject *self, PyObject *value, void *closure) {
 
-    krb5_timestamp timestamp = _decode_timestamp_input(value);
+    krb5_timestamp timestamp = PyKAdminPrincipal_decode_timestamp(value);
 
     if (timestamp == TIME_NONE) {
         return 1; 
@@ -727,12 +988,14 @@ int PyKAdminPrincipal_set_expire(PyKAdminPrincipalObject *self, PyObject *value,
     self->entry.princ_expire_time = timestamp;
     self->mask |= KADM5_PRINC_EXPIRE_TIME;
 
+    Py_CLEAR(self->slots[kPRINCIPAL_SLOT_EXPIRE]);
+
     return 0;
 }
 
 int PyKAdminPrincipal_set_pwexpire(PyKAdminPrincipalObject *self, PyObject *value, void *closure) {
 
-    krb5_timestamp timestamp = _decode_timestamp_input(value);
+    krb5_timestamp timestamp = PyKAdminPrincipal_decode_timestamp(value);
 
     if (timestamp == TIME_NONE) {
         return 1; 
@@ -741,13 +1004,15 @@ int PyKAdminPrincipal_set_pwexpire(PyKAdminPrincipalObject *self, PyObject *valu
     self->entry.pw_expiration = timestamp;
     self->mask |= KADM5_PW_EXPIRATION;
 
+    Py_CLEAR(self->slots[kPRINCIPAL_SLOT_PWEXPIRE]);
+
     return 0;
 
 }
 
 int PyKAdminPrincipal_set_maxlife(PyKAdminPrincipalObject *self, PyObject *value, void *closure) {
 
-    krb5_timestamp timestamp = _decode_timedelta_input(value);
+    krb5_timestamp timestamp = PyKAdminPrincipal_decode_timedelta(value);
 
     if (timestamp == TIME_NONE) {
         return 1; 
@@ -756,13 +1021,15 @@ int PyKAdminPrincipal_set_maxlife(PyKAdminPrincipalObject *self, PyObject *value
     self->entry.max_life = timestamp;
     self->mask |= KADM5_MAX_LIFE;
 
+    Py_CLEAR(self->slots[kPRINCIPAL_SLOT_MAXLIFE]);
+
     return 0;
 
 }
 
 int PyKAdminPrincipal_set_maxrenewlife(PyKAdminPrincipalObject *self, PyObject *value, void *closure) {
 
-    krb5_timestamp timestamp = _decode_timedelta_input(value);
+    krb5_timestamp timestamp = PyKAdminPrincipal_decode_timedelta(value);
 
     if (timestamp == TIME_NONE) {
         return 1; 
@@ -771,6 +1038,8 @@ int PyKAdminPrincipal_set_maxrenewlife(PyKAdminPrincipalObject *self, PyObject *
     self->entry.max_renewable_life = timestamp;
     self->mask |= KADM5_MAX_RLIFE;
 
+    Py_CLEAR(self->slots[kPRINCIPAL_SLOT_MAXRENEWLIFE]);
+
     return 0;
 
 }
@@ -787,6 +1056,8 @@ int PyKAdminPrincipal_set_kvno(PyKAdminPrincipalObject *self, PyObject *value, v
     if (!PyErr_Occurred()) {
         self->entry.kvno = (unsigned int)kvno;
         self->mask |= KADM5_KVNO;
+
+        Py_CLEAR(self->slots[kPRINCIPAL_SLOT_KVNO]);
     }
 
     return 0;
@@ -802,6 +1073,8 @@ int PyKAdminPrincipal_set_policy(PyKAdminPrincipalObject *self, PyObject *value,
 
         if (value) {
 
+            Py_CLEAR(self->slots[kPRINCIPAL_SLOT_POLICY]);
+
             if (value == Py_None) {
                 self->mask &= ~KADM5_POLICY;
                 self->mask |= KADM5_POLICY_CLR; 
@@ -810,12 +1083,12 @@ int PyKAdminPrincipal_set_policy(PyKAdminPrincipalObject *self, PyObject *value,
             policy_string = PyUnicode_or_PyBytes_asCString(value);
 
             if (PyKAdminPolicyObject_CheckExact(value)) {
-                policy_string = PyKAdminPolicyObject_policy_name((PyKAdminPolicyObject *)value);
+                policy_string = strdup(PyKAdminPolicyObject_policy_name((PyKAdminPolicyObject *)value));
             }
 
             if (policy_string) {
                 
-                if (pykadmin_policy_exists(self->kadmin->server_handle, policy_string)) {
+                if (pykadmin_policy_exists(self->kadmin, policy_string)) {
 
                     if (self->entry.policy) {
                         free(self->entry.policy);
@@ -826,6 +1099,8 @@ int PyKAdminPrincipal_set_policy(PyKAdminPrincipalObject *self, PyObject *value,
                     self->mask |= KADM5_POLICY;
                     self->mask &= ~KADM5_POLICY_CLR;
                     result = 0; 
+                } else {
+                    free(policy_string);
                 }
             }
         }
@@ -983,6 +1258,7 @@ static PyGetSetDef PyKAdminPrincipal_getters_setters[] = {
     {"attributes",      (getter)PyKAdminPrincipal_get_attributes,      NULL, kDOCSTRING_ATTRIBUTES,      NULL},
 
     {"keys",            (getter)PyKAdminPrincipal_get_keys,            NULL, "",                         NULL},
+    {"keys_raw",        (getter)PyKAdminPrincipal_get_keys_raw,        NULL, "array('i') of (kvno, enctype, salt) per key", NULL},
 
     // setter attributes
 
@@ -1051,15 +1327,13 @@ PyTypeObject PyKAdminPrincipalObject_Type = {
 };
 
 
-PyKAdminPrincipalObject *PyKAdminPrincipalObject_principal_with_name(PyKAdminObject *kadmin, char *client_name) {
-        
-    krb5_error_code code;
+PyKAdminPrincipalObject *PyKAdminPrincipalObject_principal_with_principal(PyKAdminObject *kadmin, krb5_const_principal princ) {
+
     kadm5_ret_t retval = KADM5_OK;
 
     PyKAdminPrincipalObject *principal = (PyKAdminPrincipalObject *)Py_None;
-    krb5_principal temp = NULL;
 
-    if (kadmin && client_name) {
+    if (kadmin && princ) {
 
         principal = (PyKAdminPrincipalObject *)PyKAdminPrincipal_new(&PyKAdminPrincipalObject_Type, NULL, NULL);
 
@@ -1068,13 +1342,16 @@ PyKAdminPrincipalObject *PyKAdminPrincipalObject_principal_with_name(PyKAdminObj
             Py_INCREF(kadmin);
             principal->kadmin = kadmin;
 
-            code = krb5_parse_name(kadmin->context, client_name, &temp);
+            if (!pykadmin_cache_get(kadmin->context, kadmin->cache, princ, &principal->entry)) {
 
-            retval = kadm5_get_principal(kadmin->server_handle, temp, &principal->entry, (KADM5_PRINCIPAL_NORMAL_MASK | KADM5_KEY_DATA));
+                if (!pykadmin_replica_get_principal(kadmin->replica, princ, &principal->entry, (KADM5_PRINCIPAL_NORMAL_MASK | KADM5_KEY_DATA), &retval))
+                    PyKAdmin_CALL(kadmin, retval, 1, kadm5_get_principal(kadmin->server_handle, (krb5_principal)princ, &principal->entry, (KADM5_PRINCIPAL_NORMAL_MASK | KADM5_KEY_DATA)));
 
-            krb5_free_principal(kadmin->context, temp);
+                if (retval == KADM5_OK)
+                    pykadmin_cache_put(kadmin->context, kadmin->cache, &principal->entry);
+            }
 
-            if ((retval != KADM5_OK) || code) {
+            if (retval != KADM5_OK) {
                 PyKAdminPrincipal_dealloc(principal);
                 if (retval == KADM5_AUTH_GET)
                     PyKAdminError_raise_error(retval, "kadm5_get_principal");
@@ -1084,6 +1361,26 @@ PyKAdminPrincipalObject *PyKAdminPrincipalObject_principal_with_name(PyKAdminObj
         }
     }
 
+    if (principal == (PyKAdminPrincipalObject *)Py_None)
+        Py_INCREF(Py_None);
+
+    return principal;
+}
+
+PyKAdminPrincipalObject *PyKAdminPrincipalObject_principal_with_name(PyKAdminObject *kadmin, char *client_name) {
+        
+    PyKAdminPrincipalObject *principal = NULL;
+    krb5_principal temp = NULL;
+
+    if (!kadmin || !client_name || krb5_parse_name(kadmin->context, client_name, &temp)) {
+        Py_INCREF(Py_None);
+        return (PyKAdminPrincipalObject *)Py_None;
+    }
+
+    principal = PyKAdminPrincipalObject_principal_with_principal(kadmin, temp);
+
+    krb5_free_principal(kadmin->context, temp);
+
     return principal;
 }
 
@@ -1109,6 +1406,31 @@ PyKAdminPrincipalObject *PyKAdminPrincipalObject_principal_with_db_entry(PyKAdmi
     return principal;
 }
 
+/* takes ownership of the contents of entry, which is left zeroed; on failure they are freed */
+PyKAdminPrincipalObject *PyKAdminPrincipalObject_principal_with_kadm_entry(PyKAdminObject *kadmin, kadm5_principal_ent_rec *entry) {
+
+    PyKAdminPrincipalObject *principal = NULL;
+
+    if (kadmin && entry) {
+
+        principal = (PyKAdminPrincipalObject *)PyKAdminPrincipal_new(&PyKAdminPrincipalObject_Type, NULL, NULL);
+
+        if (principal) {
+
+            Py_INCREF(kadmin);
+            principal->kadmin = kadmin;
+
+            memcpy(&principal->entry, entry, sizeof(kadm5_principal_ent_rec));
+        } else {
+            kadm5_free_principal_ent(kadmin->server_handle, entry);
+        }
+
+        memset(entry, 0, sizeof(kadm5_principal_ent_rec));
+    }
+
+    return principal;
+}
+
 
 void PyKAdminPrincipalObject_destroy(PyKAdminPrincipalObject *self) {
     PyKAdminPrincipal_dealloc(self);
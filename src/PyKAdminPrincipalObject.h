@@ -12,6 +12,24 @@
 
 extern time_t get_date(char *);
 
+/* converted attribute values, built on first access and dropped by the matching setter or reload */
+enum {
+    kPRINCIPAL_SLOT_PRINCIPAL = 0,
+    kPRINCIPAL_SLOT_MOD_NAME,
+    kPRINCIPAL_SLOT_MOD_DATE,
+    kPRINCIPAL_SLOT_LAST_PWD_CHANGE,
+    kPRINCIPAL_SLOT_LAST_SUCCESS,
+    kPRINCIPAL_SLOT_LAST_FAILED,
+    kPRINCIPAL_SLOT_EXPIRE,
+    kPRINCIPAL_SLOT_PWEXPIRE,
+    kPRINCIPAL_SLOT_MAXLIFE,
+    kPRINCIPAL_SLOT_MAXRENEWLIFE,
+    kPRINCIPAL_SLOT_POLICY,
+    kPRINCIPAL_SLOT_KVNO,
+    kPRINCIPAL_SLOT_KEYS,
+    kPRINCIPAL_SLOT_COUNT
+};
+
 typedef struct {
     PyObject_HEAD
     PyKAdminObject *kadmin;
@@ -19,6 +37,11 @@ typedef struct {
 
     unsigned int mask; 
 
+    PyObject *slots[kPRINCIPAL_SLOT_COUNT];
+
+    // kadmin->time_format the time slots were built with
+    int slots_time_format;
+
 } PyKAdminPrincipalObject;
 
 PyTypeObject PyKAdminPrincipalObject_Type;
@@ -27,11 +50,18 @@ PyTypeObject PyKAdminPrincipalObject_Type;
 #define PyKAdminPrincipalObject_CheckExact(obj) (Py_TYPE(obj) == &PyKAdminPrincipalObject_Type)
 
 PyKAdminPrincipalObject *PyKAdminPrincipalObject_principal_with_name(PyKAdminObject *kadmin, char *client_name);
+PyKAdminPrincipalObject *PyKAdminPrincipalObject_principal_with_principal(PyKAdminObject *kadmin, krb5_const_principal princ);
 PyKAdminPrincipalObject *PyKAdminPrincipalObject_principal_with_db_entry(PyKAdminObject *kadmin, krb5_db_entry *kdb);
 PyKAdminPrincipalObject *PyKAdminPrincipalObject_principal_with_kadm_entry(PyKAdminObject *kadmin, kadm5_principal_ent_rec *entry);
 
+/* builds the enctype/salt name tables used by the keys getter, once at module init */
+int PyKAdminPrincipalObject_init_key_names(void);
 
 void PyKAdminPrincipalObject_destroy(PyKAdminPrincipalObject *self); 
 
+/* setter input (datetime/timedelta, str, int seconds or None) as stored; -1 with a ValueError set when invalid */
+krb5_timestamp PyKAdminPrincipal_decode_timestamp(PyObject *date);
+krb5_deltat PyKAdminPrincipal_decode_timedelta(PyObject *timedelta);
+
 
 #endif
\ No newline at end of file
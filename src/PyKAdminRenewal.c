@@ -0,0 +1,513 @@
+
+#include "PyKAdminRenewal.h"
+#include "PyKAdminCommon.h"
+
+#include <pthread.h>
+#include <time.h>
+
+// how soon to try again after a failed login, or look again when the expiry is unknown
+#define kRENEWAL_RETRY   30
+#define kRENEWAL_UNKNOWN 300
+#define kRENEWAL_IDLE    3600
+
+typedef struct {
+    PyKAdminObject *kadmin;     // borrowed: dealloc unregisters before the handle goes away
+    unsigned long id;           // tells a handle from a later one at the same address
+    double margin;
+    time_t renew_at;
+    int busy;
+} pykadmin_renewal_entry_t;
+
+/* 
+    lock order is GIL, then mutex: the thread never waits for the GIL while holding the
+    mutex, so dealloc (GIL held) can always unregister.
+*/
+static pthread_mutex_t pykadmin_renewal_mutex  = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pykadmin_renewal_changed = PTHREAD_COND_INITIALIZER;
+
+static pykadmin_renewal_entry_t *pykadmin_renewal_entries = NULL;
+static size_t pykadmin_renewal_count    = 0;
+static size_t pykadmin_renewal_capacity = 0;
+static unsigned long pykadmin_renewal_ids = 0;
+
+static int pykadmin_renewal_started   = 0;
+static int pykadmin_renewal_stopping  = 0;
+static int pykadmin_renewal_in_python = 0;
+
+
+krb5_timestamp pykadmin_renewal_expiry(krb5_context context, void *server_handle) {
+
+    krb5_timestamp expiry = 0;
+
+#ifndef KADMIN_LOCAL
+
+    pykadmin_client_handle_rec *handle = server_handle;
+    krb5_error_code code = 0;
+    krb5_ccache cc       = NULL;
+    krb5_cc_cursor cursor;
+    krb5_creds creds;
+
+    if (!handle || (handle->magic_number != kKADM5_SERVER_HANDLE_MAGIC) || !handle->cache_name)
+        return 0;
+
+    if (krb5_cc_resolve(context, handle->cache_name, &cc))
+        return 0;
+
+    if (!krb5_cc_start_seq_get(context, cc, &cursor)) {
+
+        while (!(code = krb5_cc_next_cred(context, cc, &cursor, &creds))) {
+
+            // the kadmin/<host> or kadmin/admin ticket the gss context was built from
+            if (!krb5_is_config_principal(context, creds.server) 
+                && (creds.server->length > 0)
+                && (creds.server->data[0].length == 6)
+                && !memcmp(creds.server->data[0].data, "kadmin", 6)) {
+
+                if (!expiry || (creds.times.endtime < expiry))
+                    expiry = creds.times.endtime;
+            }
+
+            krb5_free_cred_contents(context, &creds);
+        }
+
+        krb5_cc_end_seq_get(context, cc, &cursor);
+    }
+
+    krb5_cc_close(context, cc);
+
+#endif
+
+    return expiry;
+}
+
+static time_t _pykadmin_renewal_schedule(krb5_timestamp expiry, double margin, int failed) {
+
+    time_t now = time(NULL);
+    time_t at  = 0;
+
+    if (failed)
+        return now + kRENEWAL_RETRY;
+
+    if (!expiry)
+        return now + kRENEWAL_UNKNOWN;
+
+    at = expiry - (time_t)margin;
+
+    // tickets shorter lived than the margin: renew half way through what is left
+    if (at < now + kRENEWAL_RETRY)
+        at = now + ((expiry > now) ? ((expiry - now) / 2) : 0);
+
+    return at;
+}
+
+static pykadmin_renewal_entry_t *_pykadmin_renewal_find(PyKAdminObject *kadmin, unsigned long id) {
+
+    size_t index = 0;
+
+    for (; index < pykadmin_renewal_count; index++) {
+        if ((pykadmin_renewal_entries[index].kadmin == kadmin) && (!id || (pykadmin_renewal_entries[index].id == id)))
+            return &pykadmin_renewal_entries[index];
+    }
+
+    return NULL;
+}
+
+/* take the GIL unless the interpreter is going away; call with the mutex held */
+static int _pykadmin_renewal_enter_python(void) {
+
+    if (pykadmin_renewal_stopping)
+        return 0;
+
+    pykadmin_renewal_in_python++;
+    return 1;
+}
+
+static void _pykadmin_renewal_leave_python(void) {
+
+    pthread_mutex_lock(&pykadmin_renewal_mutex);
+    pykadmin_renewal_in_python--;
+    pthread_cond_broadcast(&pykadmin_renewal_changed);
+    pthread_mutex_unlock(&pykadmin_renewal_mutex);
+}
+
+/* renew the TGT in a ccache in place, as kinit -R does; best effort */
+static void _pykadmin_renewal_renew_ccache(krb5_context context, const char *ccache_name) {
+
+    krb5_ccache cc         = NULL;
+    krb5_principal client  = NULL;
+    krb5_creds creds;
+
+    memset(&creds, 0, sizeof(creds));
+
+    if (ccache_name ? krb5_cc_resolve(context, ccache_name, &cc) : krb5_cc_default(context, &cc))
+        return;
+
+    if (krb5_cc_get_principal(context, cc, &client))
+        goto cleanup;
+
+    if (krb5_get_renewed_creds(context, &creds, client, cc, NULL))
+        goto cleanup;
+
+    if (!krb5_cc_initialize(context, cc, client))
+        krb5_cc_store_cred(context, cc, &creds);
+
+    krb5_free_cred_contents(context, &creds);
+
+cleanup:
+
+    if (client)
+        krb5_free_principal(context, client);
+
+    krb5_cc_close(context, cc);
+}
+
+/* log one handle in again; called without the GIL or the mutex */
+static void _pykadmin_renewal_renew(PyKAdminObject *kadmin, unsigned long id, pykadmin_session_t *session, pykadmin_options_t *options, double margin) {
+
+    PyGILState_STATE gil;
+    pykadmin_renewal_entry_t *entry = NULL;
+
+    krb5_context context = NULL;
+    void *server_handle  = NULL;
+    krb5_timestamp expiry = 0;
+    kadm5_ret_t retval   = KADM5_OK;
+    int entered          = 0;
+
+    retval = kadm5_init_krb5_context(&context);
+
+    if (retval == KADM5_OK) {
+
+        if (session->kind == kSESSION_CCACHE)
+            _pykadmin_renewal_renew_ccache(context, session->source);
+
+        retval = pykadmin_session_login(context, session, options, &server_handle);
+
+        if (retval == KADM5_OK)
+            expiry = pykadmin_renewal_expiry(context, server_handle);
+    } else {
+        context = NULL;
+    }
+
+    pthread_mutex_lock(&pykadmin_renewal_mutex);
+    entered = _pykadmin_renewal_enter_python();
+    pthread_mutex_unlock(&pykadmin_renewal_mutex);
+
+    if (entered) {
+
+        gil = PyGILState_Ensure();
+
+        pthread_mutex_lock(&pykadmin_renewal_mutex);
+        entry = _pykadmin_renewal_find(kadmin, id);
+        pthread_mutex_unlock(&pykadmin_renewal_mutex);
+
+        // still registered, so still alive: hold it while the swap may drop the GIL
+        if (entry && (retval == KADM5_OK)) {
+
+            Py_INCREF(kadmin);
+            PyKAdminObject_replace_handle(kadmin, context, server_handle);
+
+            context       = NULL;
+            server_handle = NULL;
+
+            Py_DECREF(kadmin);
+        }
+
+        pthread_mutex_lock(&pykadmin_renewal_mutex);
+
+        entry = _pykadmin_renewal_find(kadmin, id);
+        if (entry) {
+            entry->busy     = 0;
+            entry->renew_at = _pykadmin_renewal_schedule(expiry, margin, (retval != KADM5_OK));
+        }
+
+        pthread_mutex_unlock(&pykadmin_renewal_mutex);
+
+        PyGILState_Release(gil);
+
+        _pykadmin_renewal_leave_python();
+    }
+
+    if (server_handle)
+        kadm5_destroy(server_handle);
+
+    if (context)
+        krb5_free_context(context);
+}
+
+static void *_pykadmin_renewal_main(void *unused) {
+
+    pykadmin_renewal_entry_t *entry = NULL;
+    pykadmin_session_t *session     = NULL;
+    pykadmin_options_t options;
+    PyKAdminObject *kadmin = NULL;
+    PyGILState_STATE gil;
+
+    struct timespec until;
+    time_t now       = 0;
+    time_t next      = 0;
+    unsigned long id = 0;
+    double margin    = 0;
+    size_t index     = 0;
+
+    pthread_mutex_lock(&pykadmin_renewal_mutex);
+
+    while (!pykadmin_renewal_stopping) {
+
+        now   = time(NULL);
+        next  = now + kRENEWAL_IDLE;
+        entry = NULL;
+
+        for (index = 0; index < pykadmin_renewal_count; index++) {
+
+            if (pykadmin_renewal_entries[index].busy)
+                continue;
+
+            if (pykadmin_renewal_entries[index].renew_at <= now) {
+                entry = &pykadmin_renewal_entries[index];
+                break;
+            }
+
+            if (pykadmin_renewal_entries[index].renew_at < next)
+                next = pykadmin_renewal_entries[index].renew_at;
+        }
+
+        if (!entry) {
+            until.tv_sec  = next;
+            until.tv_nsec = 0;
+            pthread_cond_timedwait(&pykadmin_renewal_changed, &pykadmin_renewal_mutex, &until);
+            continue;
+        }
+
+        entry->busy = 1;
+
+        kadmin = entry->kadmin;
+        id     = entry->id;
+        margin = entry->margin;
+
+        if (!_pykadmin_renewal_enter_python())
+            break;
+
+        pthread_mutex_unlock(&pykadmin_renewal_mutex);
+
+        // snapshot how the handle logs in; its options may change under the GIL
+        memset(&options, 0, sizeof(options));
+        session = NULL;
+
+        gil = PyGILState_Ensure();
+
+        pthread_mutex_lock(&pykadmin_renewal_mutex);
+        entry = _pykadmin_renewal_find(kadmin, id);
+        pthread_mutex_unlock(&pykadmin_renewal_mutex);
+
+        if (entry && kadmin->session && !pykadmin_options_copy(&options, &kadmin->options))
+            session = pykadmin_session_copy(kadmin->session);
+
+        // a failover handle renews its active server's login only
+        if (session && kadmin->failover) {
+            free(options.admin_server);
+            options.admin_server = strdup(pykadmin_failover_active(kadmin->failover)->admin_server);
+            options.kadmind_port = 0;
+            if (!options.admin_server) {
+                pykadmin_session_destroy(session);
+                session = NULL;
+            }
+        }
+
+        PyGILState_Release(gil);
+
+        _pykadmin_renewal_leave_python();
+
+        if (session)
+            _pykadmin_renewal_renew(kadmin, id, session, &options, margin);
+
+        pykadmin_session_destroy(session);
+        pykadmin_options_clear(&options);
+
+        pthread_mutex_lock(&pykadmin_renewal_mutex);
+
+        // nothing was attempted (out of memory, or unregistered meanwhile)
+        if (!session && (entry = _pykadmin_renewal_find(kadmin, id))) {
+            entry->busy     = 0;
+            entry->renew_at = time(NULL) + kRENEWAL_RETRY;
+        }
+    }
+
+    pthread_mutex_unlock(&pykadmin_renewal_mutex);
+
+    return NULL;
+}
+
+int pykadmin_renewal_register(PyKAdminObject *kadmin, double margin) {
+
+    pykadmin_renewal_entry_t *entry   = NULL;
+    pykadmin_renewal_entry_t *entries = NULL;
+    krb5_timestamp expiry = 0;
+    pthread_t thread;
+    int result = 0;
+
+    if (!kadmin->session || !kadmin->server_handle) {
+        PyErr_SetString(PyExc_ValueError, "handle has no credentials to renew");
+        return -1;
+    }
+
+    expiry = pykadmin_renewal_expiry(kadmin->context, kadmin->server_handle);
+
+    pthread_mutex_lock(&pykadmin_renewal_mutex);
+
+    entry = _pykadmin_renewal_find(kadmin, 0);
+
+    if (!entry) {
+
+        if (pykadmin_renewal_count == pykadmin_renewal_capacity) {
+
+            entries = realloc(pykadmin_renewal_entries, sizeof(pykadmin_renewal_entry_t) * (pykadmin_renewal_capacity ? pykadmin_renewal_capacity * 2 : 8));
+            if (!entries) {
+                result = -1;
+                goto cleanup;
+            }
+
+            pykadmin_renewal_entries   = entries;
+            pykadmin_renewal_capacity  = pykadmin_renewal_capacity ? pykadmin_renewal_capacity * 2 : 8;
+        }
+
+        entry = &pykadmin_renewal_entries[pykadmin_renewal_count++];
+        memset(entry, 0, sizeof(pykadmin_renewal_entry_t));
+
+        entry->kadmin = kadmin;
+        entry->id     = ++pykadmin_renewal_ids;
+    }
+
+    entry->margin = margin;
+
+    if (!entry->busy)
+        entry->renew_at = _pykadmin_renewal_schedule(expiry, margin, 0);
+
+    if (!pykadmin_renewal_started) {
+
+#       if PY_VERSION_HEX < 0x03070000
+        PyEval_InitThreads();
+#       endif
+
+        if (pthread_create(&thread, NULL, _pykadmin_renewal_main, NULL)) {
+            pykadmin_renewal_count--;
+            result = -1;
+            goto cleanup;
+        }
+
+        pthread_detach(thread);
+        pykadmin_renewal_started = 1;
+    }
+
+    pthread_cond_broadcast(&pykadmin_renewal_changed);
+
+cleanup:
+
+    pthread_mutex_unlock(&pykadmin_renewal_mutex);
+
+    if (result)
+        PyErr_NoMemory();
+
+    return result;
+}
+
+void pykadmin_renewal_unregister(PyKAdminObject *kadmin) {
+
+    pykadmin_renewal_entry_t *entry = NULL;
+
+    pthread_mutex_lock(&pykadmin_renewal_mutex);
+
+    entry = _pykadmin_renewal_find(kadmin, 0);
+
+    if (entry)
+        *entry = pykadmin_renewal_entries[--pykadmin_renewal_count];
+
+    pthread_mutex_unlock(&pykadmin_renewal_mutex);
+}
+
+void pykadmin_renewal_resume(PyKAdminObject *kadmin) {
+
+    pykadmin_renewal_entry_t *entry = NULL;
+    double margin = 0;
+
+    pthread_mutex_lock(&pykadmin_renewal_mutex);
+
+    entry = _pykadmin_renewal_find(kadmin, 0);
+    if (entry)
+        margin = entry->margin;
+
+    pthread_mutex_unlock(&pykadmin_renewal_mutex);
+
+    // the handle works; renewal is retried by the next resume or enable_renewal
+    if (entry && pykadmin_renewal_register(kadmin, margin))
+        PyErr_Clear();
+}
+
+/* the mutex is held across fork so the child gets it in a known state */
+static void _pykadmin_renewal_fork_prepare(void) {
+    pthread_mutex_lock(&pykadmin_renewal_mutex);
+}
+
+static void _pykadmin_renewal_fork_parent(void) {
+    pthread_mutex_unlock(&pykadmin_renewal_mutex);
+}
+
+static void _pykadmin_renewal_fork_child(void) {
+
+    size_t index = 0;
+
+    // the thread, and any renewal it was in the middle of, stayed in the parent
+    pykadmin_renewal_started   = 0;
+    pykadmin_renewal_in_python = 0;
+
+    for (; index < pykadmin_renewal_count; index++)
+        pykadmin_renewal_entries[index].busy = 0;
+
+    pthread_cond_init(&pykadmin_renewal_changed, NULL);
+    pthread_mutex_unlock(&pykadmin_renewal_mutex);
+}
+
+
+static PyObject *_pykadmin_renewal_stop(PyObject *self, PyObject *unused) {
+
+    // without the GIL, so a swap that is waiting for it can finish
+    Py_BEGIN_ALLOW_THREADS
+    pthread_mutex_lock(&pykadmin_renewal_mutex);
+
+    pykadmin_renewal_stopping = 1;
+    pthread_cond_broadcast(&pykadmin_renewal_changed);
+
+    while (pykadmin_renewal_in_python)
+        pthread_cond_wait(&pykadmin_renewal_changed, &pykadmin_renewal_mutex);
+
+    pthread_mutex_unlock(&pykadmin_renewal_mutex);
+    Py_END_ALLOW_THREADS
+
+    Py_RETURN_NONE;
+}
+
+static PyMethodDef pykadmin_renewal_stop_def = {"_stop_renewal", (PyCFunction)_pykadmin_renewal_stop, METH_NOARGS, ""};
+
+int pykadmin_renewal_init(PyObject *module) {
+
+    PyObject *atexit = NULL;
+    PyObject *stop   = NULL;
+    PyObject *result = NULL;
+
+    if (pthread_atfork(_pykadmin_renewal_fork_prepare, _pykadmin_renewal_fork_parent, _pykadmin_renewal_fork_child))
+        return -1;
+
+    stop = PyCFunction_New(&pykadmin_renewal_stop_def, NULL);
+    if (!stop)
+        return -1;
+
+    atexit = PyImport_ImportModule("atexit");
+    if (atexit) {
+        result = PyObject_CallMethod(atexit, "register", "O", stop);
+        Py_DECREF(atexit);
+    }
+
+    Py_DECREF(stop);
+    Py_XDECREF(result);
+
+    return result ? 0 : -1;
+}
@@ -0,0 +1,35 @@
+
+#ifndef PYKADMINRENEWAL_H
+#define PYKADMINRENEWAL_H
+
+#include <Python.h>
+#include <kadm5/admin.h>
+#include <krb5/krb5.h>
+
+#include "pykadmin.h"
+#include "PyKAdminObject.h"
+
+/*
+    background credential renewal (kadm.enable_renewal).
+
+    one thread, started with the first registration, logs registered handles in again
+    margin seconds before their kadmin service ticket expires: from the keytab or
+    password, or after renewing the TGT in the ccache. the handshake runs on a fresh
+    krb5 context without the GIL; only the swap of (context, server_handle) into the
+    handle takes it, so calls never wait on a login. kadm5clnt only.
+*/
+
+// earliest end time of the kadmin service tickets behind server_handle, 0 if unknown
+krb5_timestamp pykadmin_renewal_expiry(krb5_context context, void *server_handle);
+
+// returns 0, or -1 with an exception set. registering again updates the margin.
+int pykadmin_renewal_register(PyKAdminObject *kadmin, double margin);
+void pykadmin_renewal_unregister(PyKAdminObject *kadmin);
+
+// after kadmin logged in again in a forked child: reschedule it (when registered) and restart the thread
+void pykadmin_renewal_resume(PyKAdminObject *kadmin);
+
+// stops the thread from entering python again before the interpreter finalizes
+int pykadmin_renewal_init(PyObject *module);
+
+#endif
@@ -0,0 +1,736 @@
+
+#include "PyKAdminReplica.h"
+#include "PyKAdminCommon.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <profile.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+    head of the iprop update log and of its entries; mirror kdb_hlog_t and
+    kdb_ent_header_t from kdb_log.h, which is not installed. the log is a plain mmap of
+    the header followed by block-sized slots, entry sno in slot (sno - 1) % ulogsize.
+*/
+
+#define kULOG_HDR_MAGIC 0x6662323
+#define kULOG_MAGIC     0x6661212
+#define kULOG_STABLE    1
+#define kULOG_ENTRIES   1000        // DEF_ULOGENTRIES, when kdc.conf sets no iprop_master_ulogsize
+
+// where kadm5srv looks for kdc.conf unless KRB5_KDC_PROFILE says otherwise
+#ifndef PYKADMIN_KDC_PROFILE
+#   define PYKADMIN_KDC_PROFILE "/etc/krb5kdc/kdc.conf", "/var/kerberos/krb5kdc/kdc.conf", "/usr/local/var/krb5kdc/kdc.conf"
+#endif
+
+typedef struct {
+    uint32_t seconds;
+    uint32_t useconds;
+} pykadmin_ulog_time_t;
+
+typedef struct {
+    uint32_t hmagic;
+    uint16_t db_version_num;
+    uint32_t num;
+    pykadmin_ulog_time_t first_time;
+    pykadmin_ulog_time_t last_time;
+    uint32_t first_sno;
+    uint32_t last_sno;
+    uint16_t state;
+    uint16_t block;
+} pykadmin_ulog_header_t;
+
+/* followed by the XDR kdb_incr_update_t, which starts with the principal's unparsed name */
+typedef struct {
+    uint32_t umagic;
+    uint32_t entry_sno;
+    pykadmin_ulog_time_t time;
+    int32_t commit;
+    uint32_t entry_size;
+} pykadmin_ulog_entry_t;
+
+typedef struct {
+    krb5_context context;
+    char *match;
+    char **names;
+    int count;
+    int size;
+    krb5_error_code code;
+} pykadmin_replica_listing_t;
+
+static void _pykadmin_replica_forget_all(pykadmin_replica_t *replica);
+
+/*
+    a context on the KDC's profile: the krb5.conf files with kdc.conf in front, as
+    kadm5srv builds it. kadm5clnt's kadm5_init_krb5_context reads krb5.conf alone, which
+    leaves krb5_db_open without the [dbmodules] kept in kdc.conf.
+*/
+static krb5_error_code _pykadmin_replica_context(krb5_context *context) {
+
+    static const char *kdc_profiles[] = {PYKADMIN_KDC_PROFILE, NULL};
+
+    krb5_error_code code = 0;
+    const char **paths   = NULL;
+    const char *kdc_profile = getenv("KRB5_KDC_PROFILE");
+    char **files      = NULL;
+    profile_t profile = NULL;
+    size_t count = 0;
+    size_t index = 0;
+
+    *context = NULL;
+
+    for (index = 0; !kdc_profile && kdc_profiles[index]; index++) {
+        if (!access(kdc_profiles[index], R_OK))
+            kdc_profile = kdc_profiles[index];
+    }
+
+    if ((code = krb5_get_default_config_files(&files)))
+        return code;
+
+    for (count = 0; files[count]; count++);
+
+    paths = calloc(count + 2, sizeof(char *));
+    if (!paths) {
+        code = ENOMEM;
+        goto cleanup;
+    }
+
+    count = 0;
+
+    if (kdc_profile)
+        paths[count++] = kdc_profile;
+
+    for (index = 0; files[index]; index++)
+        paths[count++] = files[index];
+
+    if ((code = profile_init((const_profile_filespec_t *)paths, &profile)))
+        goto cleanup;
+
+    code = krb5_init_context_profile(profile, 0, context);
+    if (code)
+        *context = NULL;
+
+cleanup:
+
+    if (profile)
+        profile_release(profile);
+
+    free(paths);
+    krb5_free_config_files(files);
+
+    return code;
+}
+
+
+krb5_error_code pykadmin_replica_open(const char *realm, char **db_args, double max_staleness, pykadmin_replica_t **out) {
+
+    pykadmin_replica_t *replica = NULL;
+    kadm5_config_params params_in;
+    kadm5_config_params params;
+    krb5_error_code code = 0;
+
+    *out = NULL;
+
+    replica = calloc(1, sizeof(pykadmin_replica_t));
+    if (!replica) {
+        pykadmin_free_db_args(db_args);
+        return ENOMEM;
+    }
+
+    replica->max_staleness = max_staleness;
+    replica->db_args       = db_args;
+    replica->generation    = pykadmin_fork_generation;
+    replica->sweep_at      = 64;
+    replica->ulog_entries  = kULOG_ENTRIES;
+
+    if ((code = _pykadmin_replica_context(&replica->context)))
+        goto error;
+
+    if (realm && (code = krb5_set_default_realm(replica->context, realm)))
+        goto error;
+
+    if ((code = krb5_get_default_realm(replica->context, &replica->realm)))
+        goto error;
+
+    code = krb5_db_open(replica->context, db_args, (KRB5_KDB_OPEN_RO | KRB5_KDB_SRV_TYPE_OTHER));
+    if (code)
+        goto error;
+
+    memset(&params_in, 0, sizeof(params_in));
+    memset(&params, 0, sizeof(params));
+
+    params_in.mask  = KADM5_CONFIG_REALM;
+    params_in.realm = replica->realm;
+
+    // without iprop there is no log to judge freshness by
+    if (!kadm5_get_config_params(replica->context, 1, &params_in, &params)) {
+
+        if ((params.mask & KADM5_CONFIG_IPROP_ENABLED) && params.iprop_enabled
+            && (params.mask & KADM5_CONFIG_IPROP_LOGFILE) && params.iprop_logfile)
+            replica->ulog = strdup(params.iprop_logfile);
+
+        if ((params.mask & KADM5_CONFIG_ULOG_SIZE) && params.iprop_ulogsize)
+            replica->ulog_entries = params.iprop_ulogsize;
+
+        kadm5_free_config_params(replica->context, &params);
+    }
+
+    *out = replica;
+
+    return 0;
+
+error:
+
+    if (replica->context) {
+        if (replica->realm)
+            krb5_free_default_realm(replica->context, replica->realm);
+        krb5_free_context(replica->context);
+    }
+
+    pykadmin_free_db_args(replica->db_args);
+    free(replica);
+
+    return code;
+}
+
+void pykadmin_replica_close(pykadmin_replica_t *replica) {
+
+    if (!replica || (replica->generation != pykadmin_fork_generation))
+        return;
+
+    krb5_db_fini(replica->context);
+
+    if (replica->realm)
+        krb5_free_default_realm(replica->context, replica->realm);
+
+    _pykadmin_replica_forget_all(replica);
+
+    krb5_free_context(replica->context);
+
+    pykadmin_free_db_args(replica->db_args);
+    free(replica->ulog);
+    free(replica);
+}
+
+pykadmin_replica_t *pykadmin_replica_reopen(pykadmin_replica_t *replica) {
+
+    pykadmin_replica_t *reopened = NULL;
+    char **db_args = replica->db_args;
+
+    // handed over; the inherited instance is never freed
+    replica->db_args = NULL;
+
+    if (pykadmin_replica_open(replica->realm, db_args, replica->max_staleness, &reopened))
+        return NULL;
+
+    // the child's writes went through the same handle; its reads of them still wait
+    reopened->written         = replica->written;
+    reopened->written_buckets = replica->written_buckets;
+    reopened->written_count   = replica->written_count;
+    reopened->sweep_at        = replica->sweep_at;
+
+    replica->written         = NULL;
+    replica->written_buckets = 0;
+    replica->written_count   = 0;
+
+    return reopened;
+}
+
+/* the update log, open, with its header read; -1 unless readable and stable */
+static int _pykadmin_replica_log(pykadmin_replica_t *replica, pykadmin_ulog_header_t *header) {
+
+    int fd = -1;
+
+    if (!replica || !replica->ulog)
+        return -1;
+
+    fd = open(replica->ulog, O_RDONLY);
+    if (fd < 0)
+        return -1;
+
+    if ((pread(fd, header, sizeof(*header), 0) != sizeof(*header)) || (header->hmagic != kULOG_HDR_MAGIC)
+        || (header->state != kULOG_STABLE) || !header->block) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+int pykadmin_replica_state(pykadmin_replica_t *replica, uint32_t *serial, time_t *updated) {
+
+    pykadmin_ulog_header_t header;
+    int fd = _pykadmin_replica_log(replica, &header);
+
+    if (fd < 0)
+        return 0;
+
+    close(fd);
+
+    *serial  = header.last_sno;
+    *updated = (time_t)header.last_time.seconds;
+
+    return 1;
+}
+
+int pykadmin_replica_usable(pykadmin_replica_t *replica) {
+
+    uint32_t serial = 0;
+    time_t updated  = 0;
+    int known       = 0;
+
+    if (!replica || (replica->generation != pykadmin_fork_generation))
+        return 0;
+
+    // max_staleness 0 (the only choice without iprop) takes the replica as it is
+    if (replica->max_staleness <= 0)
+        return 1;
+
+    known = pykadmin_replica_state(replica, &serial, &updated);
+
+    return known && (difftime(time(NULL), updated) <= replica->max_staleness);
+}
+
+/*
+    the handle's writes the local KDB does not show yet, in a table of unparsed names.
+    a record goes once a lookup finds the write applied; all of them are looked up again
+    whenever the table has doubled, so writes to principals never read back do not pile up.
+*/
+
+static size_t _pykadmin_replica_hash(const char *name) {
+
+    size_t hash = 5381;
+
+    while (*name)
+        hash = (hash * 33) ^ (unsigned char)*name++;
+
+    return hash;
+}
+
+static pykadmin_replica_write_t **_pykadmin_replica_find(pykadmin_replica_t *replica, const char *name) {
+
+    pykadmin_replica_write_t **link = NULL;
+
+    if (!replica->written_buckets)
+        return NULL;
+
+    link = &replica->written[_pykadmin_replica_hash(name) % replica->written_buckets];
+
+    for (; *link; link = &(*link)->next) {
+        if (!strcmp((*link)->name, name))
+            return link;
+    }
+
+    return NULL;
+}
+
+static void _pykadmin_replica_forget(pykadmin_replica_t *replica, pykadmin_replica_write_t **link) {
+
+    pykadmin_replica_write_t *write = *link;
+
+    *link = write->next;
+    replica->written_count--;
+
+    free(write->name);
+    free(write);
+}
+
+static void _pykadmin_replica_forget_all(pykadmin_replica_t *replica) {
+
+    size_t bucket = 0;
+
+    for (bucket = 0; bucket < replica->written_buckets; bucket++) {
+        while (replica->written[bucket])
+            _pykadmin_replica_forget(replica, &replica->written[bucket]);
+    }
+
+    free(replica->written);
+
+    replica->written         = NULL;
+    replica->written_buckets = 0;
+}
+
+static int _pykadmin_replica_grow(pykadmin_replica_t *replica) {
+
+    pykadmin_replica_write_t **buckets = NULL;
+    pykadmin_replica_write_t *write    = NULL;
+    size_t count  = replica->written_buckets ? replica->written_buckets * 2 : 64;
+    size_t bucket = 0;
+    size_t index  = 0;
+
+    buckets = calloc(count, sizeof(pykadmin_replica_write_t *));
+    if (!buckets)
+        return 0;
+
+    for (bucket = 0; bucket < replica->written_buckets; bucket++) {
+        while ((write = replica->written[bucket])) {
+            replica->written[bucket] = write->next;
+            index = _pykadmin_replica_hash(write->name) % count;
+            write->next    = buckets[index];
+            buckets[index] = write;
+        }
+    }
+
+    free(replica->written);
+
+    replica->written         = buckets;
+    replica->written_buckets = count;
+
+    return 1;
+}
+
+/*
+    whether the replica has applied write: its update log holds, past the serial it had
+    reached when the write was made, as many updates of the principal as writes were made
+    since. the entries scanned are not looked at again. entries that have rolled off the
+    log mean a whole log's worth has been applied since the write, which then counts too.
+    updates made elsewhere to the same principal in the meantime count as well.
+*/
+static int _pykadmin_replica_applied(pykadmin_replica_t *replica, int fd, pykadmin_ulog_header_t *header, pykadmin_replica_write_t *write) {
+
+    pykadmin_ulog_entry_t entry;
+    uint64_t sno    = 0;
+    uint32_t first  = 0;
+    uint32_t length = 0;
+    size_t size     = strlen(write->name);
+    char *name      = NULL;
+    off_t offset    = 0;
+    int applied     = 0;
+
+    // no log when it was made: only kadmind can tell
+    if (!write->tracked)
+        return 0;
+
+    // the log was reset (a full resync): nothing left to compare against
+    if (header->last_sno < write->after)
+        return 1;
+
+    first = header->num ? header->first_sno : (header->last_sno + 1);
+
+    if (first > (write->after + 1))
+        return 1;
+
+    name = malloc(size);
+    if (!name)
+        return 0;
+
+    for (sno = (uint64_t)write->after + 1; sno <= header->last_sno; sno++) {
+
+        offset = (off_t)sizeof(pykadmin_ulog_header_t) + (off_t)((sno - 1) % replica->ulog_entries) * header->block;
+
+        if ((pread(fd, &entry, sizeof(entry), offset) != sizeof(entry))
+            || (entry.umagic != kULOG_MAGIC) || (entry.entry_sno != sno) || !entry.commit
+            || (pread(fd, &length, sizeof(length), offset + sizeof(entry)) != sizeof(length)))
+            break;
+
+        if ((ntohl(length) == size) && (pread(fd, name, size, offset + sizeof(entry) + sizeof(length)) == (ssize_t)size)
+            && !memcmp(name, write->name, size) && !--write->count) {
+            applied = 1;
+            break;
+        }
+
+        write->after = (uint32_t)sno;
+    }
+
+    free(name);
+
+    return applied;
+}
+
+/* 1 when the write recorded at link has been applied locally; its record is then dropped */
+static int _pykadmin_replica_settle(pykadmin_replica_t *replica, int fd, pykadmin_ulog_header_t *header, pykadmin_replica_write_t **link) {
+
+    if (!_pykadmin_replica_applied(replica, fd, header, *link))
+        return 0;
+
+    _pykadmin_replica_forget(replica, link);
+
+    return 1;
+}
+
+static void _pykadmin_replica_sweep(pykadmin_replica_t *replica) {
+
+    pykadmin_replica_write_t **link = NULL;
+    pykadmin_ulog_header_t header;
+    size_t bucket = 0;
+    int fd = _pykadmin_replica_log(replica, &header);
+
+    if (fd < 0)
+        return;
+
+    for (bucket = 0; bucket < replica->written_buckets; bucket++) {
+        link = &replica->written[bucket];
+        while (*link) {
+            if (!_pykadmin_replica_settle(replica, fd, &header, link))
+                link = &(*link)->next;
+        }
+    }
+
+    close(fd);
+}
+
+void pykadmin_replica_wrote(pykadmin_replica_t *replica, krb5_const_principal princ, long long serial) {
+
+    pykadmin_replica_write_t **link = NULL;
+    pykadmin_replica_write_t *write = NULL;
+    uint32_t current = 0;
+    time_t updated   = 0;
+    char *name   = NULL;
+    size_t index = 0;
+
+    if (!replica || !princ || (replica->generation != pykadmin_fork_generation))
+        return;
+
+    // not known from before the call: the serial now may already include the write, but is the best left
+    if ((serial < 0) && pykadmin_replica_state(replica, &current, &updated))
+        serial = current;
+
+    if (krb5_unparse_name(replica->context, princ, &name))
+        return;
+
+    link = _pykadmin_replica_find(replica, name);
+
+    if (link) {
+        write = *link;
+    } else {
+
+        if ((replica->written_count >= replica->written_buckets) && !_pykadmin_replica_grow(replica))
+            goto cleanup;
+
+        write = calloc(1, sizeof(pykadmin_replica_write_t));
+        if (write && !(write->name = strdup(name))) {
+            free(write);
+            write = NULL;
+        }
+
+        if (!write)
+            goto cleanup;
+
+        index = _pykadmin_replica_hash(name) % replica->written_buckets;
+        write->next = replica->written[index];
+        replica->written[index] = write;
+        replica->written_count++;
+
+        write->tracked = (serial >= 0);
+        write->after   = write->tracked ? (uint32_t)serial : 0;
+    }
+
+    // an earlier write still outstanding keeps its starting point; this one adds an update to wait for
+    write->count++;
+
+    if (replica->written_count >= replica->sweep_at) {
+        _pykadmin_replica_sweep(replica);
+        replica->sweep_at = (replica->written_count > 32) ? (replica->written_count * 2) : 64;
+    }
+
+cleanup:
+
+    krb5_free_unparsed_name(replica->context, name);
+}
+
+size_t pykadmin_replica_pending(pykadmin_replica_t *replica) {
+
+    return replica ? replica->written_count : 0;
+}
+
+/* what kadmind hands a client: key metadata without the (encrypted) contents */
+static void _pykadmin_replica_strip_keys(kadm5_principal_ent_rec *entry) {
+
+    int i, j;
+
+    for (i = 0; entry->key_data && (i < entry->n_key_data); i++) {
+        for (j = 0; j < 2; j++) {
+            if (entry->key_data[i].key_data_contents[j]) {
+                memset(entry->key_data[i].key_data_contents[j], 0, entry->key_data[i].key_data_length[j]);
+                free(entry->key_data[i].key_data_contents[j]);
+            }
+            entry->key_data[i].key_data_contents[j] = NULL;
+            entry->key_data[i].key_data_length[j]   = 0;
+        }
+    }
+}
+
+/* 1 unless princ has a recorded write the replica has not applied yet */
+static int _pykadmin_replica_caught_up(pykadmin_replica_t *replica, krb5_const_principal princ) {
+
+    pykadmin_replica_write_t **link = NULL;
+    pykadmin_ulog_header_t header;
+    char *name = NULL;
+    int settled = 0;
+    int fd = -1;
+
+    if (krb5_unparse_name(replica->context, princ, &name))
+        return 0;
+
+    link = _pykadmin_replica_find(replica, name);
+    krb5_free_unparsed_name(replica->context, name);
+
+    if (!link)
+        return 1;
+
+    fd = _pykadmin_replica_log(replica, &header);
+    if (fd < 0)
+        return 0;
+
+    settled = _pykadmin_replica_settle(replica, fd, &header, link);
+    close(fd);
+
+    return settled;
+}
+
+int pykadmin_replica_get_principal(pykadmin_replica_t *replica, krb5_const_principal princ, kadm5_principal_ent_rec *entry, long mask, kadm5_ret_t *retval) {
+
+    krb5_error_code code = 0;
+    krb5_db_entry *kdb   = NULL;
+
+    if (!pykadmin_replica_usable(replica))
+        goto fallback;
+
+    // read your own writes: until the replica has applied the handle's write, kadmind answers
+    if (replica->written_count && !_pykadmin_replica_caught_up(replica, princ))
+        goto fallback;
+
+    code = krb5_db_get_principal(replica->context, princ, 0, &kdb);
+
+    if (code == KRB5_KDB_NOENTRY) {
+        replica->reads++;
+        *retval = KADM5_UNK_PRINC;
+        return 1;
+    }
+
+    if (code)
+        goto fallback;
+
+    code = pykadmin_kadm_from_kdb_context(replica->context, kdb, entry, mask);
+    krb5_db_free_principal(replica->context, kdb);
+
+    if (code) {
+        pykadmin_free_kadm_ent_rec(replica->context, entry);
+        goto fallback;
+    }
+
+    _pykadmin_replica_strip_keys(entry);
+
+    replica->reads++;
+    *retval = KADM5_OK;
+
+    return 1;
+
+fallback:
+
+    if (replica)
+        replica->fallbacks++;
+
+    return 0;
+}
+
+static int _pykadmin_replica_list_step(void *data, krb5_db_entry *kdb) {
+
+    pykadmin_replica_listing_t *listing = (pykadmin_replica_listing_t *)data;
+    char **names = NULL;
+    char *name   = NULL;
+
+    if ((listing->code = krb5_unparse_name(listing->context, kdb->princ, &name)))
+        return 1;
+
+    if (fnmatch(listing->match, name, 0)) {
+        krb5_free_unparsed_name(listing->context, name);
+        return 0;
+    }
+
+    if (listing->count == listing->size) {
+
+        names = realloc(listing->names, (listing->size ? listing->size * 2 : 64) * sizeof(char *));
+        if (!names) {
+            krb5_free_unparsed_name(listing->context, name);
+            listing->code = ENOMEM;
+            return 1;
+        }
+
+        listing->names = names;
+        listing->size  = listing->size ? listing->size * 2 : 64;
+    }
+
+    // kadm5_free_name_list releases with free()
+    listing->names[listing->count] = strdup(name);
+    krb5_free_unparsed_name(listing->context, name);
+
+    if (!listing->names[listing->count]) {
+        listing->code = ENOMEM;
+        return 1;
+    }
+
+    listing->count++;
+
+    return 0;
+}
+
+int pykadmin_replica_get_principals(pykadmin_replica_t *replica, const char *match, char ***names, int *count) {
+
+    pykadmin_replica_listing_t listing;
+    krb5_error_code code = 0;
+    size_t length = 0;
+    int index = 0;
+
+    if (!pykadmin_replica_usable(replica))
+        goto fallback;
+
+    // a listing could miss (or still show) any principal written through the handle
+    if (replica->written_count)
+        _pykadmin_replica_sweep(replica);
+
+    if (replica->written_count)
+        goto fallback;
+
+    memset(&listing, 0, sizeof(listing));
+    listing.context = replica->context;
+
+    // like kadmind, a pattern without a realm matches within the handle's realm
+    if (!match)
+        match = "*";
+
+    length = strlen(match) + strlen(replica->realm) + 2;
+
+    listing.match = malloc(length);
+    if (listing.match) {
+        if (strchr(match, '@'))
+            strcpy(listing.match, match);
+        else
+            snprintf(listing.match, length, "%s@%s", match, replica->realm);
+    }
+
+    if (!listing.match)
+        goto fallback;
+
+    code = krb5_db_iterate(replica->context, NULL, _pykadmin_replica_list_step, (void *)&listing
+#if (KRB5_KDB_API_VERSION >= 8)
+        , 0 /* flags */
+#endif
+    );
+
+    free(listing.match);
+
+    if (code || listing.code) {
+        for (index = 0; index < listing.count; index++)
+            free(listing.names[index]);
+        free(listing.names);
+        goto fallback;
+    }
+
+    replica->reads++;
+
+    *names = listing.names;
+    *count = listing.count;
+
+    return 1;
+
+fallback:
+
+    if (replica)
+        replica->fallbacks++;
+
+    return 0;
+}
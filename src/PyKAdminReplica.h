@@ -0,0 +1,91 @@
+
+#ifndef PYKADMINREPLICA_H
+#define PYKADMINREPLICA_H
+
+#include <kdb.h>
+#include <kadm5/admin.h>
+#include <krb5/krb5.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+    read-only view of the propagated KDB on a replica KDC, attached to a client handle
+    (kadm.attach_replica). principal reads are answered from it through the same
+    krb5_db_* calls kadmin_local uses; writes still go to kadmind.
+
+    a read is only served locally when the replica is fresh enough:
+
+        - the iprop update log must be stable (no update half applied) and, when
+          max_staleness is set, its newest update no older than max_staleness seconds
+        - a principal written through the handle is read from kadmind until the update
+          log shows the replica has applied an update of it past the serial it had
+          reached when the write was made (no clocks involved). listings go to kadmind
+          while any write is outstanding.
+
+    without iprop there is no log to date the replica by: max_staleness must then be 0
+    and the replica is read whatever its age, i.e. changes made elsewhere show up only
+    once kprop has run. with no log to tell when they arrive, principals written through
+    the handle are then always read from kadmind.
+
+    any other local failure falls back to kadmind as well. an instance inherited across
+    fork is never read (nor closed: the database belongs to the parent) until reopened.
+    callers hold the GIL.
+*/
+
+typedef struct _pykadmin_replica_write {
+    char *name;
+    uint32_t after;             // log serial the replica had reached when the first write was made
+    unsigned long count;        // updates of the principal still to show up past it
+    int tracked;                // 0: no readable log then
+    struct _pykadmin_replica_write *next;
+} pykadmin_replica_write_t;
+
+typedef struct {
+    krb5_context context;       // the KDB is opened on this context alone
+    char *realm;
+    char *ulog;                 // iprop update log, NULL when iprop is off
+    uint32_t ulog_entries;      // slots in it
+    char **db_args;
+    unsigned long generation;   // pykadmin_fork_generation it was opened in
+    double max_staleness;       // seconds; 0 accepts any age
+
+    // principals written through the handle whose write the local KDB does not show yet
+    struct _pykadmin_replica_write **written;
+    size_t written_buckets;
+    size_t written_count;
+    size_t sweep_at;            // look the outstanding writes up again at this many
+
+    unsigned long reads;
+    unsigned long fallbacks;
+} pykadmin_replica_t;
+
+// takes ownership of db_args
+krb5_error_code pykadmin_replica_open(const char *realm, char **db_args, double max_staleness, pykadmin_replica_t **replica);
+void pykadmin_replica_close(pykadmin_replica_t *replica);
+
+/*
+    in a forked child: the same replica opened again, NULL if that failed. the outstanding
+    writes move over; replica is otherwise left to the parent.
+*/
+pykadmin_replica_t *pykadmin_replica_reopen(pykadmin_replica_t *replica);
+
+// 1 with serial and time of the newest update when the update log is readable and stable
+int pykadmin_replica_state(pykadmin_replica_t *replica, uint32_t *serial, time_t *updated);
+
+int pykadmin_replica_usable(pykadmin_replica_t *replica);
+
+// a write of princ through the handle succeeded; serial is the log's from before the call (-1: unknown)
+void pykadmin_replica_wrote(pykadmin_replica_t *replica, krb5_const_principal princ, long long serial);
+
+// number of writes the local KDB does not show yet
+size_t pykadmin_replica_pending(pykadmin_replica_t *replica);
+
+/*
+    both return 1 when the replica answered (*retval KADM5_OK or KADM5_UNK_PRINC), 0 when
+    the caller should ask kadmind instead. key contents are dropped, as kadmind does.
+    names are malloc'd, for kadm5_free_name_list.
+*/
+int pykadmin_replica_get_principal(pykadmin_replica_t *replica, krb5_const_principal princ, kadm5_principal_ent_rec *entry, long mask, kadm5_ret_t *retval);
+int pykadmin_replica_get_principals(pykadmin_replica_t *replica, const char *match, char ***names, int *count);
+
+#endif
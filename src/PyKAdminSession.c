@@ -0,0 +1,207 @@
+
+#include "PyKAdminSession.h"
+#include "PyKAdminCommon.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+extern char *service_name;
+extern krb5_ui_4 struct_version;
+extern krb5_ui_4 api_version;
+
+static const char *kSESSION_CALLERS[kSESSION_KIND_COUNT] = {
+    "kadm5_init_with_creds",
+    "kadm5_init_with_skey",
+    "kadm5_init_with_password"
+};
+
+pykadmin_session_t *pykadmin_session_create(int kind, const char *client, const char *source, char **db_args) {
+
+    pykadmin_session_t *session = calloc(1, sizeof(pykadmin_session_t));
+
+    if (!session)
+        goto error;
+
+    session->kind    = kind;
+    session->db_args = db_args;
+
+    if (client) {
+        session->client = strdup(client);
+        if (!session->client)
+            goto error;
+    }
+
+    if (source) {
+        session->source = strdup(source);
+        if (!session->source)
+            goto error;
+    }
+
+    return session;
+
+error:
+    if (session)
+        pykadmin_session_destroy(session);
+    else
+        pykadmin_free_db_args(db_args);
+    return NULL;
+}
+
+pykadmin_session_t *pykadmin_session_copy(const pykadmin_session_t *session) {
+
+    char **db_args = NULL;
+    size_t count   = 0;
+    size_t index   = 0;
+
+    if (session->db_args) {
+
+        while (session->db_args[count])
+            count++;
+
+        db_args = calloc(count + 1, sizeof(char *));
+        if (!db_args)
+            return NULL;
+
+        for (index = 0; index < count; index++) {
+            db_args[index] = strdup(session->db_args[index]);
+            if (!db_args[index]) {
+                pykadmin_free_db_args(db_args);
+                return NULL;
+            }
+        }
+    }
+
+    return pykadmin_session_create(session->kind, session->client, session->source, db_args);
+}
+
+void pykadmin_session_destroy(pykadmin_session_t *session) {
+
+    if (!session)
+        return;
+
+    free(session->client);
+
+    if (session->source) {
+        // don't leave a password behind in freed memory
+        if (session->kind == kSESSION_PASSWORD)
+            memset(session->source, 0, strlen(session->source));
+        free(session->source);
+    }
+
+    pykadmin_free_db_args(session->db_args);
+
+    free(session);
+}
+
+const char *pykadmin_session_caller(pykadmin_session_t *session) {
+    return kSESSION_CALLERS[session->kind];
+}
+
+static kadm5_ret_t _pykadmin_session_init_once(krb5_context context, pykadmin_session_t *session, kadm5_config_params *params, void **server_handle) {
+
+    kadm5_ret_t retval = KADM5_OK;
+    krb5_ccache cc     = NULL;
+
+    switch (session->kind) {
+
+        case kSESSION_CCACHE:
+
+            if (session->source)
+                retval = krb5_cc_resolve(context, session->source, &cc);
+            else
+                retval = krb5_cc_default(context, &cc);
+
+            if (retval)
+                break;
+
+            retval = kadm5_init_with_creds(context, session->client, cc, service_name, params,
+                        struct_version, api_version, session->db_args, server_handle);
+
+            krb5_cc_close(context, cc);
+            break;
+
+        case kSESSION_KEYTAB:
+
+            retval = kadm5_init_with_skey(context, session->client, session->source, service_name, params,
+                        struct_version, api_version, session->db_args, server_handle);
+            break;
+
+        case kSESSION_PASSWORD:
+
+            retval = kadm5_init_with_password(context, session->client, session->source, service_name, params,
+                        struct_version, api_version, session->db_args, server_handle);
+            break;
+    }
+
+    if (retval != KADM5_OK)
+        *server_handle = NULL;
+
+    return retval;
+}
+
+kadm5_ret_t pykadmin_session_login(krb5_context context, pykadmin_session_t *session, const pykadmin_options_t *options, void **server_handle) {
+
+    kadm5_ret_t retval = KADM5_OK;
+    kadm5_config_params params;
+
+    memset(&params, 0, sizeof(params));
+    pykadmin_options_params(options, &params);
+
+    retval = _pykadmin_session_init_once(context, session, &params, server_handle);
+
+    if ((retval == KADM5_OK) && (options->timeout > 0))
+        pykadmin_options_apply_timeout(*server_handle, options->timeout);
+
+    return retval;
+}
+
+kadm5_ret_t pykadmin_session_init(krb5_context context, pykadmin_session_t *session, const pykadmin_options_t *options, void **server_handle) {
+
+    kadm5_ret_t retval = KADM5_OK;
+    double delay       = options->retry_delay;
+    int attempt        = 0;
+    struct timespec pause;
+
+    for (attempt = 0; ; attempt++) {
+
+        retval = pykadmin_session_login(context, session, options, server_handle);
+
+        if ((retval == KADM5_OK) || (attempt >= options->retries) || !pykadmin_options_retryable(retval))
+            break;
+
+        if (delay > 0) {
+
+            pause.tv_sec  = (time_t)delay;
+            pause.tv_nsec = (long)((delay - (double)pause.tv_sec) * 1e9);
+
+            Py_BEGIN_ALLOW_THREADS
+            nanosleep(&pause, NULL);
+            Py_END_ALLOW_THREADS
+
+            delay *= 2;
+        }
+    }
+
+    return retval;
+}
+
+kadm5_ret_t pykadmin_session_check(void *server_handle) {
+
+    long privs = 0;
+
+    if (!server_handle)
+        return KADM5_BAD_SERVER_HANDLE;
+
+    return kadm5_get_privs(server_handle, &privs);
+}
+
+kadm5_ret_t pykadmin_session_reinit(krb5_context context, pykadmin_session_t *session, const pykadmin_options_t *options, void **server_handle) {
+
+    if (*server_handle) {
+        kadm5_destroy(*server_handle);
+        *server_handle = NULL;
+    }
+
+    return pykadmin_session_init(context, session, options, server_handle);
+}
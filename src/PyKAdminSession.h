@@ -0,0 +1,52 @@
+
+#ifndef PYKADMINSESSION_H
+#define PYKADMINSESSION_H
+
+#include <kadm5/admin.h>
+#include <krb5/krb5.h>
+
+#include "PyKAdminOptions.h"
+
+/*
+    how a handle authenticated: enough to run the same kadm5_init_* again in place when
+    kadmind has dropped the connection.
+*/
+
+enum {
+    kSESSION_CCACHE = 0,
+    kSESSION_KEYTAB,
+    kSESSION_PASSWORD,
+    kSESSION_KIND_COUNT
+};
+
+typedef struct {
+    int kind;
+    char *client;       // resolved client principal
+    char *source;       // ccache name, keytab name or password; NULL for the default ccache (or no password)
+    char **db_args;     // owned, as returned by pykadmin_parse_db_args
+} pykadmin_session_t;
+
+// copies client and source (either may be NULL), takes ownership of db_args. NULL when out of memory.
+pykadmin_session_t *pykadmin_session_create(int kind, const char *client, const char *source, char **db_args);
+pykadmin_session_t *pykadmin_session_copy(const pykadmin_session_t *session);
+void pykadmin_session_destroy(pykadmin_session_t *session);
+
+// name of the kadm5 call pykadmin_session_init makes, for error reporting
+const char *pykadmin_session_caller(pykadmin_session_t *session);
+
+// one kadm5_init_* attempt plus the RPC timeout; touches no python state, so is safe without the GIL
+kadm5_ret_t pykadmin_session_login(krb5_context context, pykadmin_session_t *session, const pykadmin_options_t *options, void **server_handle);
+
+/*
+    kadm5_init_* with the admin_server/kadmind_port of options, retrying unreachable
+    kadmind options->retries times (sleeping without the GIL), then applying the RPC timeout.
+*/
+kadm5_ret_t pykadmin_session_init(krb5_context context, pykadmin_session_t *session, const pykadmin_options_t *options, void **server_handle);
+
+// one cheap round trip (kadm5_get_privs) to see whether the handle still works
+kadm5_ret_t pykadmin_session_check(void *server_handle);
+
+// destroy the current server handle (if any) and authenticate again
+kadm5_ret_t pykadmin_session_reinit(krb5_context context, pykadmin_session_t *session, const pykadmin_options_t *options, void **server_handle);
+
+#endif
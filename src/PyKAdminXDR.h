@@ -27,6 +27,27 @@ typedef struct _osa_princ_ent_t {
     osa_pw_hist_ent             *old_keys;
 } osa_princ_ent_rec, *osa_princ_ent_t;
 
+#ifndef KADMIN_LOCAL
+
+/* 
+    leading fields of the kadm5clnt server handle (kadm5_server_handle_rec in
+    lib/kadm5/clnt/client_internal.h): the ccache holding the kadmin service ticket
+    and the gssrpc CLIENT the kadm5 calls go through. check the magic before use.
+*/
+
+#define kKADM5_SERVER_HANDLE_MAGIC 0x12345800
+
+typedef struct {
+    krb5_ui_4 magic_number;
+    krb5_ui_4 struct_version;
+    krb5_ui_4 api_version;
+    char *cache_name;
+    int destroy_cache;
+    CLIENT *clnt;
+} pykadmin_client_handle_rec;
+
+#endif
+
 int pykadmin_xdr_nullstring(XDR *xdrs, char **string);
 int pykadmin_xdr_osa_pw_hist_ent(XDR *xdrs, osa_pw_hist_ent *objp);
 int pykadmin_xdr_osa_princ_ent_rec(XDR *xdrs, osa_princ_ent_rec *entry);
@@ -107,15 +107,11 @@ struct my_timeb {
 #define bcopy(from, to, len) memcpy ((to), (from), (len))
 #endif
 
-extern struct tm	*gmtime();
-extern struct tm	*localtime();
 
 #define yyparse getdate_yyparse
 #define yylex getdate_yylex
 #define yyerror getdate_yyerror
 
-static int getdate_yylex (void);
-static int getdate_yyerror (char *);
 
 
 #define EPOCH		1970
@@ -150,38 +146,48 @@ typedef enum _MERIDIAN {
 
 
 /*
-**  Global variables.  We could get rid of most of these by using a good
-**  union as the yacc stack.  (This routine was originally written before
-**  yacc had the %union construct.)  Maybe someday; right now we only use
-**  the %union very rarely.
+**  Parser state.  Everything the grammar actions and the lexer share lives
+**  here rather than in globals, so get_date is reentrant and may run on
+**  several threads at once (without the GIL).
 */
-static char	*yyInput;
-static DSTMODE	yyDSTmode;
-static time_t	yyDayOrdinal;
-static time_t	yyDayNumber;
-static int	yyHaveDate;
-static int	yyHaveDay;
-static int	yyHaveRel;
-static int	yyHaveTime;
-static int	yyHaveZone;
-static time_t	yyTimezone;
-static time_t	yyDay;
-static time_t	yyHour;
-static time_t	yyMinutes;
-static time_t	yyMonth;
-static time_t	yySeconds;
-static time_t	yyYear;
-static MERIDIAN	yyMeridian;
-static time_t	yyRelMonth;
-static time_t	yyRelSeconds;
+typedef struct _DATECONTEXT {
+    char	*yyInput;
+    DSTMODE	yyDSTmode;
+    time_t	yyDayOrdinal;
+    time_t	yyDayNumber;
+    int		yyHaveDate;
+    int		yyHaveDay;
+    int		yyHaveRel;
+    int		yyHaveTime;
+    int		yyHaveZone;
+    time_t	yyTimezone;
+    time_t	yyDay;
+    time_t	yyHour;
+    time_t	yyMinutes;
+    time_t	yyMonth;
+    time_t	yySeconds;
+    time_t	yyYear;
+    MERIDIAN	yyMeridian;
+    time_t	yyRelMonth;
+    time_t	yyRelSeconds;
+} DATECONTEXT;
 
 %}
 
+%define api.pure full
+%parse-param	{ DATECONTEXT *ctx }
+%lex-param	{ DATECONTEXT *ctx }
+
 %union {
     time_t		Number;
     enum _MERIDIAN	Meridian;
 }
 
+%code {
+static int getdate_yylex (YYSTYPE *, DATECONTEXT *);
+static int getdate_yyerror (DATECONTEXT *, char *);
+}
+
 %token	tAGO tDAY tDAYZONE tID tMERIDIAN tMINUTE_UNIT tMONTH tMONTH_UNIT
 %token	tSEC_UNIT tSNUMBER tUNUMBER tZONE tDST tNEVER
 
@@ -194,171 +200,171 @@ static time_t	yyRelSeconds;
 spec	: /* NULL */
 	| spec item
         | tNEVER {
-	    yyYear = 1970;
-	    yyMonth = 1;
-	    yyDay = 1;
-	    yyHour = yyMinutes = yySeconds = 0;
-	    yyDSTmode = DSToff;
-	    yyTimezone = 0; /* gmt */
-	    yyHaveDate++;
+	    ctx->yyYear = 1970;
+	    ctx->yyMonth = 1;
+	    ctx->yyDay = 1;
+	    ctx->yyHour = ctx->yyMinutes = ctx->yySeconds = 0;
+	    ctx->yyDSTmode = DSToff;
+	    ctx->yyTimezone = 0; /* gmt */
+	    ctx->yyHaveDate++;
         }
 	;
 
 item	: time {
-	    yyHaveTime++;
+	    ctx->yyHaveTime++;
 	}
 	| zone {
-	    yyHaveZone++;
+	    ctx->yyHaveZone++;
 	}
 	| date {
-	    yyHaveDate++;
+	    ctx->yyHaveDate++;
 	}
 	| day {
-	    yyHaveDay++;
+	    ctx->yyHaveDay++;
 	}
 	| rel {
-	    yyHaveRel++;
+	    ctx->yyHaveRel++;
 	}
 	;
 
 time	: tUNUMBER tMERIDIAN {
-	    yyHour = $1;
-	    yyMinutes = 0;
-	    yySeconds = 0;
-	    yyMeridian = $2;
+	    ctx->yyHour = $1;
+	    ctx->yyMinutes = 0;
+	    ctx->yySeconds = 0;
+	    ctx->yyMeridian = $2;
 	}
 	| tUNUMBER ':' tUNUMBER o_merid {
-	    yyHour = $1;
-	    yyMinutes = $3;
-	    yySeconds = 0;
-	    yyMeridian = $4;
+	    ctx->yyHour = $1;
+	    ctx->yyMinutes = $3;
+	    ctx->yySeconds = 0;
+	    ctx->yyMeridian = $4;
 	}
 	| tUNUMBER ':' tUNUMBER tSNUMBER {
-	    yyHour = $1;
-	    yyMinutes = $3;
-	    yyMeridian = MER24;
-	    yyDSTmode = DSToff;
-	    yyTimezone = - ($4 % 100 + ($4 / 100) * 60);
+	    ctx->yyHour = $1;
+	    ctx->yyMinutes = $3;
+	    ctx->yyMeridian = MER24;
+	    ctx->yyDSTmode = DSToff;
+	    ctx->yyTimezone = - ($4 % 100 + ($4 / 100) * 60);
 	}
 	| tUNUMBER ':' tUNUMBER ':' tUNUMBER o_merid {
-	    yyHour = $1;
-	    yyMinutes = $3;
-	    yySeconds = $5;
-	    yyMeridian = $6;
+	    ctx->yyHour = $1;
+	    ctx->yyMinutes = $3;
+	    ctx->yySeconds = $5;
+	    ctx->yyMeridian = $6;
 	}
 	| tUNUMBER ':' tUNUMBER ':' tUNUMBER tSNUMBER {
-	    yyHour = $1;
-	    yyMinutes = $3;
-	    yySeconds = $5;
-	    yyMeridian = MER24;
-	    yyDSTmode = DSToff;
-	    yyTimezone = - ($6 % 100 + ($6 / 100) * 60);
+	    ctx->yyHour = $1;
+	    ctx->yyMinutes = $3;
+	    ctx->yySeconds = $5;
+	    ctx->yyMeridian = MER24;
+	    ctx->yyDSTmode = DSToff;
+	    ctx->yyTimezone = - ($6 % 100 + ($6 / 100) * 60);
 	}
 	;
 
 zone	: tZONE {
-	    yyTimezone = $1;
-	    yyDSTmode = DSToff;
+	    ctx->yyTimezone = $1;
+	    ctx->yyDSTmode = DSToff;
 	}
 	| tDAYZONE {
-	    yyTimezone = $1;
-	    yyDSTmode = DSTon;
+	    ctx->yyTimezone = $1;
+	    ctx->yyDSTmode = DSTon;
 	}
 	|
 	  tZONE tDST {
-	    yyTimezone = $1;
-	    yyDSTmode = DSTon;
+	    ctx->yyTimezone = $1;
+	    ctx->yyDSTmode = DSTon;
 	}
 	;
 
 day	: tDAY {
-	    yyDayOrdinal = 1;
-	    yyDayNumber = $1;
+	    ctx->yyDayOrdinal = 1;
+	    ctx->yyDayNumber = $1;
 	}
 	| tDAY ',' {
-	    yyDayOrdinal = 1;
-	    yyDayNumber = $1;
+	    ctx->yyDayOrdinal = 1;
+	    ctx->yyDayNumber = $1;
 	}
 	| tUNUMBER tDAY {
-	    yyDayOrdinal = $1;
-	    yyDayNumber = $2;
+	    ctx->yyDayOrdinal = $1;
+	    ctx->yyDayNumber = $2;
 	}
 	;
 
 date	: tUNUMBER '/' tUNUMBER {
-	    yyMonth = $1;
-	    yyDay = $3;
+	    ctx->yyMonth = $1;
+	    ctx->yyDay = $3;
 	}
 	| tUNUMBER '/' tUNUMBER '/' tUNUMBER {
-	    yyMonth = $1;
-	    yyDay = $3;
-	    yyYear = $5;
+	    ctx->yyMonth = $1;
+	    ctx->yyDay = $3;
+	    ctx->yyYear = $5;
 	}
 	| tUNUMBER tSNUMBER tSNUMBER {
 	    /* ISO 8601 format.  yyyy-mm-dd.  */
-	    yyYear = $1;
-	    yyMonth = -$2;
-	    yyDay = -$3;
+	    ctx->yyYear = $1;
+	    ctx->yyMonth = -$2;
+	    ctx->yyDay = -$3;
 	}
 	| tUNUMBER tMONTH tSNUMBER {
 	    /* e.g. 17-JUN-1992.  */
-	    yyDay = $1;
-	    yyMonth = $2;
-	    yyYear = -$3;
+	    ctx->yyDay = $1;
+	    ctx->yyMonth = $2;
+	    ctx->yyYear = -$3;
 	}
 	| tMONTH tUNUMBER {
-	    yyMonth = $1;
-	    yyDay = $2;
+	    ctx->yyMonth = $1;
+	    ctx->yyDay = $2;
 	}
 	| tMONTH tUNUMBER ',' tUNUMBER {
-	    yyMonth = $1;
-	    yyDay = $2;
-	    yyYear = $4;
+	    ctx->yyMonth = $1;
+	    ctx->yyDay = $2;
+	    ctx->yyYear = $4;
 	}
 	| tUNUMBER tMONTH {
-	    yyMonth = $2;
-	    yyDay = $1;
+	    ctx->yyMonth = $2;
+	    ctx->yyDay = $1;
 	}
 	| tUNUMBER tMONTH tUNUMBER {
-	    yyMonth = $2;
-	    yyDay = $1;
-	    yyYear = $3;
+	    ctx->yyMonth = $2;
+	    ctx->yyDay = $1;
+	    ctx->yyYear = $3;
 	}
 	;
 
 rel	: relunit tAGO {
-	    yyRelSeconds = -yyRelSeconds;
-	    yyRelMonth = -yyRelMonth;
+	    ctx->yyRelSeconds = -ctx->yyRelSeconds;
+	    ctx->yyRelMonth = -ctx->yyRelMonth;
 	}
 	| relunit
 	;
 
 relunit	: tUNUMBER tMINUTE_UNIT {
-	    yyRelSeconds += $1 * $2 * 60L;
+	    ctx->yyRelSeconds += $1 * $2 * 60L;
 	}
 	| tSNUMBER tMINUTE_UNIT {
-	    yyRelSeconds += $1 * $2 * 60L;
+	    ctx->yyRelSeconds += $1 * $2 * 60L;
 	}
 	| tMINUTE_UNIT {
-	    yyRelSeconds += $1 * 60L;
+	    ctx->yyRelSeconds += $1 * 60L;
 	}
 	| tSNUMBER tSEC_UNIT {
-	    yyRelSeconds += $1;
+	    ctx->yyRelSeconds += $1;
 	}
 	| tUNUMBER tSEC_UNIT {
-	    yyRelSeconds += $1;
+	    ctx->yyRelSeconds += $1;
 	}
 	| tSEC_UNIT {
-	    yyRelSeconds++;
+	    ctx->yyRelSeconds++;
 	}
 	| tSNUMBER tMONTH_UNIT {
-	    yyRelMonth += $1 * $2;
+	    ctx->yyRelMonth += $1 * $2;
 	}
 	| tUNUMBER tMONTH_UNIT {
-	    yyRelMonth += $1 * $2;
+	    ctx->yyRelMonth += $1 * $2;
 	}
 	| tMONTH_UNIT {
-	    yyRelMonth += $1;
+	    ctx->yyRelMonth += $1;
 	}
 	;
 
@@ -531,7 +537,7 @@ static TABLE const TimezoneTable[] = {
 
 /* ARGSUSED */
 static int
-yyerror(char *s)
+yyerror(DATECONTEXT *ctx, char *s)
 {
   return 0;
 }
@@ -566,16 +572,16 @@ ToSeconds(time_t Hours, time_t Minutes, time_t Seconds, MERIDIAN Meridian)
  * of seconds since 00:00:00 1/1/70 GMT.
  */
 static time_t
-Convert(time_t Month, time_t Day, time_t Year, time_t Hours, time_t Minutes,
-	time_t Seconds, MERIDIAN Meridian, DSTMODE DSTmode)
+Convert(DATECONTEXT *ctx, time_t Month, time_t Day, time_t Year, time_t Hours,
+	time_t Minutes, time_t Seconds, MERIDIAN Meridian, DSTMODE DSTmode)
 {
-    static int DaysInMonth[12] = {
+    int DaysInMonth[12] = {
 	31, 0, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31
     };
     time_t	tod;
     time_t	Julian;
     int		i;
-    struct tm	*tm;
+    struct tm	*tm, tmbuf;
 
     if (Year < 0)
 	Year = -Year;
@@ -596,14 +602,14 @@ Convert(time_t Month, time_t Day, time_t Year, time_t Hours, time_t Minutes,
 	 Julian += 365 + ((i % 4 == 0) && ((Year % 100 != 0) ||
 					   (Year % 400 == 0)));
     Julian *= SECSPERDAY;
-    Julian += yyTimezone * 60L;
+    Julian += ctx->yyTimezone * 60L;
     if ((tod = ToSeconds(Hours, Minutes, Seconds, Meridian)) < 0)
 	return -1;
     Julian += tod;
     if (DSTmode == DSTon)
 	Julian -= 60 * 60;
     else if (DSTmode == DSTmaybe) {
-	tm = localtime(&Julian);
+	tm = localtime_r(&Julian, &tmbuf);
 	if (tm == NULL)
 	    return -1;
 	else if (tm->tm_isdst)
@@ -618,15 +624,15 @@ DSTcorrect(time_t Start, time_t Future, int *error)
 {
     time_t	StartDay;
     time_t	FutureDay;
-    struct tm	*tm;
+    struct tm	*tm, tmbuf;
 
-    tm = localtime(&Start);
+    tm = localtime_r(&Start, &tmbuf);
     if (tm == NULL) {
 	*error = 1;
 	return -1;
     }
     StartDay = (tm->tm_hour + 1) % 24;
-    tm = localtime(&Future);
+    tm = localtime_r(&Future, &tmbuf);
     if (tm == NULL) {
 	*error = 1;
 	return -1;
@@ -640,11 +646,11 @@ DSTcorrect(time_t Start, time_t Future, int *error)
 static time_t
 RelativeDate(time_t Start, time_t DayOrdinal, time_t DayNumber, int *error)
 {
-    struct tm	*tm;
+    struct tm	*tm, tmbuf;
     time_t	now;
 
     now = Start;
-    tm = localtime(&now);
+    tm = localtime_r(&now, &tmbuf);
     if (tm == NULL) {
 	*error = 1;
 	return -1;
@@ -656,9 +662,9 @@ RelativeDate(time_t Start, time_t DayOrdinal, time_t DayNumber, int *error)
 
 
 static time_t
-RelativeMonth(time_t Start, time_t RelMonth)
+RelativeMonth(DATECONTEXT *ctx, time_t Start, time_t RelMonth)
 {
-    struct tm	*tm;
+    struct tm	*tm, tmbuf;
     time_t	Month;
     time_t	Year;
     time_t	ret;
@@ -666,13 +672,13 @@ RelativeMonth(time_t Start, time_t RelMonth)
 
     if (RelMonth == 0)
 	return 0;
-    tm = localtime(&Start);
+    tm = localtime_r(&Start, &tmbuf);
     if (tm == NULL)
 	return -1;
     Month = 12 * tm->tm_year + tm->tm_mon + RelMonth;
     Year = Month / 12;
     Month = Month % 12 + 1;
-    ret = Convert(Month, (time_t)tm->tm_mday, Year,
+    ret = Convert(ctx, Month, (time_t)tm->tm_mday, Year,
 		  (time_t)tm->tm_hour, (time_t)tm->tm_min, (time_t)tm->tm_sec,
 		  MER24, DSTmaybe);
     if (ret == -1)
@@ -685,7 +691,7 @@ RelativeMonth(time_t Start, time_t RelMonth)
 
 
 static int
-LookupWord(char *buff)
+LookupWord(YYSTYPE *lvalp, char *buff)
 {
     register char	*p;
     register char	*q;
@@ -699,11 +705,11 @@ LookupWord(char *buff)
 	    *p = tolower((int) *p);
 
     if (strcmp(buff, "am") == 0 || strcmp(buff, "a.m.") == 0) {
-	yylval.Meridian = MERam;
+	lvalp->Meridian = MERam;
 	return tMERIDIAN;
     }
     if (strcmp(buff, "pm") == 0 || strcmp(buff, "p.m.") == 0) {
-	yylval.Meridian = MERpm;
+	lvalp->Meridian = MERpm;
 	return tMERIDIAN;
     }
 
@@ -720,19 +726,19 @@ LookupWord(char *buff)
     for (tp = MonthDayTable; tp->name; tp++) {
 	if (abbrev) {
 	    if (strncmp(buff, tp->name, 3) == 0) {
-		yylval.Number = tp->value;
+		lvalp->Number = tp->value;
 		return tp->type;
 	    }
 	}
 	else if (strcmp(buff, tp->name) == 0) {
-	    yylval.Number = tp->value;
+	    lvalp->Number = tp->value;
 	    return tp->type;
 	}
     }
 
     for (tp = TimezoneTable; tp->name; tp++)
 	if (strcmp(buff, tp->name) == 0) {
-	    yylval.Number = tp->value;
+	    lvalp->Number = tp->value;
 	    return tp->type;
 	}
 
@@ -741,7 +747,7 @@ LookupWord(char *buff)
 
     for (tp = UnitsTable; tp->name; tp++)
 	if (strcmp(buff, tp->name) == 0) {
-	    yylval.Number = tp->value;
+	    lvalp->Number = tp->value;
 	    return tp->type;
 	}
 
@@ -751,7 +757,7 @@ LookupWord(char *buff)
 	buff[i] = '\0';
 	for (tp = UnitsTable; tp->name; tp++)
 	    if (strcmp(buff, tp->name) == 0) {
-		yylval.Number = tp->value;
+		lvalp->Number = tp->value;
 		return tp->type;
 	    }
 	buff[i] = 's';		/* Put back for "this" in OtherTable. */
@@ -759,7 +765,7 @@ LookupWord(char *buff)
 
     for (tp = OtherTable; tp->name; tp++)
 	if (strcmp(buff, tp->name) == 0) {
-	    yylval.Number = tp->value;
+	    lvalp->Number = tp->value;
 	    return tp->type;
 	}
 
@@ -773,7 +779,7 @@ LookupWord(char *buff)
     if (i)
 	for (tp = TimezoneTable; tp->name; tp++)
 	    if (strcmp(buff, tp->name) == 0) {
-		yylval.Number = tp->value;
+		lvalp->Number = tp->value;
 		return tp->type;
 	    }
 
@@ -782,7 +788,7 @@ LookupWord(char *buff)
 
 
 static int
-yylex()
+yylex(YYSTYPE *lvalp, DATECONTEXT *ctx)
 {
     register char	c;
     register char	*p;
@@ -791,39 +797,39 @@ yylex()
     int			sign;
 
     for ( ; ; ) {
-	while (isspace((int) *yyInput))
-	    yyInput++;
+	while (isspace((int) *ctx->yyInput))
+	    ctx->yyInput++;
 
-	c = *yyInput;
+	c = *ctx->yyInput;
 	if (isdigit((int) c) || c == '-' || c == '+') {
 	    if (c == '-' || c == '+') {
 		sign = c == '-' ? -1 : 1;
-		if (!isdigit((int) (*++yyInput)))
+		if (!isdigit((int) (*++ctx->yyInput)))
 		    /* skip the '-' sign */
 		    continue;
 	    }
 	    else
 		sign = 0;
-	    for (yylval.Number = 0; isdigit((int) (c = *yyInput++)); )
-		yylval.Number = 10 * yylval.Number + c - '0';
-	    yyInput--;
+	    for (lvalp->Number = 0; isdigit((int) (c = *ctx->yyInput++)); )
+		lvalp->Number = 10 * lvalp->Number + c - '0';
+	    ctx->yyInput--;
 	    if (sign < 0)
-		yylval.Number = -yylval.Number;
+		lvalp->Number = -lvalp->Number;
 	    return sign ? tSNUMBER : tUNUMBER;
 	}
 	if (isalpha((int) c)) {
-	    for (p = buff; isalpha((int) (c = *yyInput++)) || c == '.'; )
+	    for (p = buff; isalpha((int) (c = *ctx->yyInput++)) || c == '.'; )
 		if (p < &buff[sizeof buff - 1])
 		    *p++ = c;
 	    *p = '\0';
-	    yyInput--;
-	    return LookupWord(buff);
+	    ctx->yyInput--;
+	    return LookupWord(lvalp, buff);
 	}
 	if (c != '(')
-	    return *yyInput++;
+	    return *ctx->yyInput++;
 	Count = 0;
 	do {
-	    c = *yyInput++;
+	    c = *ctx->yyInput++;
 	    if (c == '\0')
 		return c;
 	    if (c == '(')
@@ -862,55 +868,57 @@ difftm(struct tm *a, struct tm *b)
 
 /* For get_date extern declaration compatibility check... yuck.  */
 #include <krb5.h>
-int yyparse(void);
 
 time_t get_date(char *);
 
 time_t
 get_date(char *p)
 {
+    DATECONTEXT		context;
+    DATECONTEXT		*ctx = &context;
     struct my_timeb	*now = NULL;
-    struct tm		*tm, gmt;
+    struct tm		*tm, gmt, tmbuf;
     struct my_timeb	ftz;
     time_t		Start;
     time_t		tod;
     time_t		delta;
     int			error;
 
-    yyInput = p;
+    memset(ctx, 0, sizeof(*ctx));
+
+    ctx->yyInput = p;
     if (now == NULL) {
         now = &ftz;
 
 	ftz.time = time((time_t *) 0);
 
-	if (! (tm = gmtime (&ftz.time)))
+	if (! (tm = gmtime_r (&ftz.time, &gmt)))
 	    return -1;
-	gmt = *tm;	/* Make a copy, in case localtime modifies *tm.  */
-	tm = localtime(&ftz.time);
+	tm = localtime_r(&ftz.time, &tmbuf);
 	if (tm == NULL)
 	    return -1;
 	ftz.timezone = difftm (&gmt, tm) / 60;
     }
 
-    tm = localtime(&now->time);
+    tm = localtime_r(&now->time, &tmbuf);
     if (tm == NULL)
 	return -1;
-    yyYear = tm->tm_year;
-    yyMonth = tm->tm_mon + 1;
-    yyDay = tm->tm_mday;
-    yyTimezone = now->timezone;
-    yyDSTmode = DSTmaybe;
-    yyHour = 0;
-    yyMinutes = 0;
-    yySeconds = 0;
-    yyMeridian = MER24;
-    yyRelSeconds = 0;
-    yyRelMonth = 0;
-    yyHaveDate = 0;
-    yyHaveDay = 0;
-    yyHaveRel = 0;
-    yyHaveTime = 0;
-    yyHaveZone = 0;
+    ctx->yyYear = tm->tm_year;
+    ctx->yyMonth = tm->tm_mon + 1;
+    ctx->yyDay = tm->tm_mday;
+    ctx->yyTimezone = now->timezone;
+    ctx->yyDSTmode = DSTmaybe;
+    ctx->yyHour = 0;
+    ctx->yyMinutes = 0;
+    ctx->yySeconds = 0;
+    ctx->yyMeridian = MER24;
+    ctx->yyRelSeconds = 0;
+    ctx->yyRelMonth = 0;
+    ctx->yyHaveDate = 0;
+    ctx->yyHaveDay = 0;
+    ctx->yyHaveRel = 0;
+    ctx->yyHaveTime = 0;
+    ctx->yyHaveZone = 0;
 
     /*
      * When yyparse returns, zero or more of yyHave{Time,Zone,Date,Day,Rel} 
@@ -920,61 +928,61 @@ get_date(char *p)
      *
      * For each yyHave indicator, the following values are set:
      *
-     * yyHaveTime:
-     *	yyHour, yyMinutes, yySeconds: hh:mm:ss specified, initialized
+     * ctx->yyHaveTime:
+     *	ctx->yyHour, ctx->yyMinutes, ctx->yySeconds: hh:mm:ss specified, initialized
      *				      to zeros above
-     *	yyMeridian: MERam, MERpm, or MER24
+     *	ctx->yyMeridian: MERam, MERpm, or MER24
      *	yyTimeZone: time zone specified in minutes
-     *  yyDSTmode: DSToff if yyTimeZone is set, otherwise unchanged
+     *  ctx->yyDSTmode: DSToff if yyTimeZone is set, otherwise unchanged
      *		   (initialized above to DSTmaybe)
      *
-     * yyHaveZone:
-     *  yyTimezone: as above
-     *  yyDSTmode: DSToff if a non-DST zone is specified, otherwise DSTon
-     *	XXX don't understand interaction with yyHaveTime zone info
+     * ctx->yyHaveZone:
+     *  ctx->yyTimezone: as above
+     *  ctx->yyDSTmode: DSToff if a non-DST zone is specified, otherwise DSTon
+     *	XXX don't understand interaction with ctx->yyHaveTime zone info
      *
-     * yyHaveDay:
-     *	yyDayNumber: 0-6 for Sunday-Saturday
-     *  yyDayOrdinal: val specified with day ("second monday",
+     * ctx->yyHaveDay:
+     *	ctx->yyDayNumber: 0-6 for Sunday-Saturday
+     *  ctx->yyDayOrdinal: val specified with day ("second monday",
      *		      Ordinal=2), otherwise 1
      *
-     * yyHaveDate:
-     *	yyMonth, yyDay, yyYear: mm/dd/yy specified, initialized to
+     * ctx->yyHaveDate:
+     *	ctx->yyMonth, ctx->yyDay, ctx->yyYear: mm/dd/yy specified, initialized to
      *				today above
      *
-     * yyHaveRel:
-     *	yyRelSeconds: seconds specified with MINUTE_UNITs ("3 hours") or
+     * ctx->yyHaveRel:
+     *	ctx->yyRelSeconds: seconds specified with MINUTE_UNITs ("3 hours") or
      *		      SEC_UNITs ("30 seconds")
-     *  yyRelMonth: months specified with MONTH_UNITs ("3 months", "1
+     *  ctx->yyRelMonth: months specified with MONTH_UNITs ("3 months", "1
      *		     year")
      *
      * The code following yyparse turns these values into a single
      * date stamp.
      */
-    if (yyparse()
-     || yyHaveTime > 1 || yyHaveZone > 1 || yyHaveDate > 1 || yyHaveDay > 1)
+    if (yyparse(ctx)
+     || ctx->yyHaveTime > 1 || ctx->yyHaveZone > 1 || ctx->yyHaveDate > 1 || ctx->yyHaveDay > 1)
 	return -1;
 
     /*
      * If an absolute time specified, set Start to the equivalent Unix
      * timestamp.  Otherwise, set Start to now, and if we do not have
-     * a relatime time (ie: only yyHaveZone), decrement Start to the
+     * a relatime time (ie: only ctx->yyHaveZone), decrement Start to the
      * beginning of today.
      *
-     * By having yyHaveDay in the "absolute" list, "next Monday" means
+     * By having ctx->yyHaveDay in the "absolute" list, "next Monday" means
      * midnight next Monday.  Otherwise, "next Monday" would mean the
      * time right now, next Monday.  It's not clear to me why the
      * current behavior is preferred.
      */
-    if (yyHaveDate || yyHaveTime || yyHaveDay) {
-	Start = Convert(yyMonth, yyDay, yyYear, yyHour, yyMinutes, yySeconds,
-			yyMeridian, yyDSTmode);
+    if (ctx->yyHaveDate || ctx->yyHaveTime || ctx->yyHaveDay) {
+	Start = Convert(ctx, ctx->yyMonth, ctx->yyDay, ctx->yyYear, ctx->yyHour, ctx->yyMinutes, ctx->yySeconds,
+			ctx->yyMeridian, ctx->yyDSTmode);
 	if (Start < 0)
 	    return -1;
     }
     else {
 	Start = now->time;
-	if (!yyHaveRel)
+	if (!ctx->yyHaveRel)
 	    Start -= ((tm->tm_hour * 60L + tm->tm_min) * 60L) + tm->tm_sec;
     }
 
@@ -988,11 +996,11 @@ get_date(char *p)
      * from 10:00am today, or even "1/1/99 two days" which means two
      * days after 1/1/99.
      *
-     * XXX Shouldn't this only be done if yyHaveRel, just for
+     * XXX Shouldn't this only be done if ctx->yyHaveRel, just for
      * thoroughness?
      */
-    Start += yyRelSeconds;
-    delta = RelativeMonth(Start, yyRelMonth);
+    Start += ctx->yyRelSeconds;
+    delta = RelativeMonth(ctx, Start, ctx->yyRelMonth);
     if (delta == (time_t) -1)
       return -1;
     Start += delta;
@@ -1002,11 +1010,11 @@ get_date(char *p)
      * disallowing Date but allowing Time, you can say "5pm next
      * monday".
      *
-     * XXX The yyHaveDay && !yyHaveDate restriction should be enforced
+     * XXX The ctx->yyHaveDay && !ctx->yyHaveDate restriction should be enforced
      * above and be able to cause failure.
      */
-    if (yyHaveDay && !yyHaveDate) {
-	tod = RelativeDate(Start, yyDayOrdinal, yyDayNumber, &error);
+    if (ctx->yyHaveDay && !ctx->yyHaveDate) {
+	tod = RelativeDate(Start, ctx->yyDayOrdinal, ctx->yyDayNumber, &error);
 	if (error != 0)
 	    return -1;
 	Start += tod;
@@ -6,6 +6,11 @@
 #include "PyKAdminIterator.h"
 #include "PyKAdminPrincipalObject.h"
 #include "PyKAdminPolicyObject.h"
+#include "PyKAdminNameIndex.h"
+#include "PyKAdminName.h"
+#include "PyKAdminRenewal.h"
+#include "PyKAdminGateway.h"
+#include "PyKAdminCommitQueue.h"
 
 #ifdef KADMIN_LOCAL
 static PyKAdminObject *_kadmin_local(PyObject *self, PyObject *args); 
@@ -15,6 +20,13 @@ static PyKAdminObject *_kadmin_init_with_ccache(PyObject *self, PyObject *args);
 static PyKAdminObject *_kadmin_init_with_keytab(PyObject *self, PyObject *args); 
 static PyKAdminObject *_kadmin_init_with_password(PyObject *self, PyObject *args); 
 
+static PyObject *_kadmin_connect(PyObject *self, PyObject *args, PyObject *kwds);
+static PyObject *_kadmin_disconnect(PyObject *self, PyObject *args);
+
+#ifndef KADMIN_LOCAL
+static PyObject *_kadmin_gateway(PyObject *self, PyObject *args, PyObject *kwds);
+#endif
+
 static PyObject *_kadmin_get_option(PyObject *self, PyObject *args, PyObject *kwds);
 static PyObject *_kadmin_set_option(PyObject *self, PyObject *args, PyObject *kwds);
 
@@ -34,12 +46,24 @@ static struct PyMethodDef module_methods[] = {
     {"init_with_keytab",   (PyCFunction)_kadmin_init_with_keytab,   METH_VARARGS, "init_with_keytab(principal, keytab)"},
     {"init_with_password", (PyCFunction)_kadmin_init_with_password, METH_VARARGS, "init_with_password(principal, password)"},
 
+    {"connect",            (PyCFunction)_kadmin_connect,            (METH_VARARGS | METH_KEYWORDS), "connect(principal=None, keytab=None, ccache=None, password=None, db_args=None, check=True, admin_servers=None)"},
+    {"disconnect",         (PyCFunction)_kadmin_disconnect,         METH_VARARGS, "disconnect(kadm=None)"},
+
+    #ifndef KADMIN_LOCAL
+    {"gateway",            (PyCFunction)_kadmin_gateway,            (METH_VARARGS | METH_KEYWORDS), "gateway(path, kadm, pool=4, mode=0o600)"},
+    #endif
+
     /* todo: these should permit the user to set/get the 
         service, struct, api version, default realm, ... 
     */
     {"get_option",         (PyCFunction)_kadmin_get_option, METH_VARARGS,  "get_option(option)"},
     {"set_option",         (PyCFunction)_kadmin_set_option, METH_VARARGS,  "set_option(option, value)"},
 
+#if PY_VERSION_HEX >= 0x03070000
+    {"__getattr__",        (PyCFunction)PyKAdminError_getattr, METH_O,      "per-code exception classes, built on first use"},
+    {"__dir__",            (PyCFunction)PyKAdminError_dir,     METH_NOARGS, ""},
+#endif
+
     {NULL, NULL, 0, NULL}
 };
 
@@ -62,6 +86,14 @@ void PyKAdminConstant_init(PyObject *module) {
     PyModule_AddIntConstant(module, "OK_AS_DELEGATE",         KRB5_KDB_OK_AS_DELEGATE);
     PyModule_AddIntConstant(module, "OK_TO_AUTH_AS_DELEGATE", KRB5_KDB_OK_TO_AUTH_AS_DELEGATE);
     PyModule_AddIntConstant(module, "NO_AUTH_DATA_REQUIRED",  KRB5_KDB_NO_AUTH_DATA_REQUIRED);
+
+    // sentinel an each_principal callback returns to end the scan early
+    pykadmin_each_stop = PyObject_CallObject((PyObject *)&PyBaseObject_Type, NULL);
+
+    if (pykadmin_each_stop) {
+        Py_INCREF(pykadmin_each_stop);
+        PyModule_AddObject(module, "STOP", pykadmin_each_stop);
+    }
     
 }
 
@@ -128,6 +160,20 @@ PyKADMIN_INIT_FUNC {
     if (PyType_Ready(&PyKAdminIterator_Type) < 0)
         PyModule_RETURN_ERROR;
 
+    if (PyType_Ready(&PyKAdminNameIndex_Type) < 0)
+        PyModule_RETURN_ERROR;
+
+    if (PyType_Ready(&PyKAdminName_Type) < 0)
+        PyModule_RETURN_ERROR;
+
+    if (PyType_Ready(&PyKAdminController_Type) < 0)
+        PyModule_RETURN_ERROR;
+
+#   ifndef KADMIN_LOCAL
+    if (PyType_Ready(&PyKAdminGatewayClient_Type) < 0)
+        PyModule_RETURN_ERROR;
+#   endif
+
     // initialize the module
 
 #   ifdef PYTHON3
@@ -143,6 +189,18 @@ PyKADMIN_INIT_FUNC {
     Py_INCREF(&PyKAdminObject_Type);
     Py_INCREF(&PyKAdminPrincipalObject_Type);
     Py_INCREF(&PyKAdminPolicyObject_Type);
+    Py_INCREF(&PyKAdminNameIndex_Type);
+    Py_INCREF(&PyKAdminName_Type);
+    Py_INCREF(&PyKAdminController_Type);
+
+    PyModule_AddObject(module, "NameIndex", (PyObject *)&PyKAdminNameIndex_Type);
+    PyModule_AddObject(module, "Name", (PyObject *)&PyKAdminName_Type);
+    PyModule_AddObject(module, "Controller", (PyObject *)&PyKAdminController_Type);
+
+#   ifndef KADMIN_LOCAL
+    Py_INCREF(&PyKAdminGatewayClient_Type);
+    PyModule_AddObject(module, "GatewayClient", (PyObject *)&PyKAdminGatewayClient_Type);
+#   endif
             
     // initialize the errors 
 
@@ -157,6 +215,28 @@ PyKADMIN_INIT_FUNC {
     // initialize constant
     PyKAdminConstant_init(module);
 
+    if (PyKAdminPrincipalObject_init_key_names()) {
+        Py_DECREF(module);
+        PyModule_RETURN_ERROR;
+    }
+
+    if (pykadmin_renewal_init(module)) {
+        Py_DECREF(module);
+        PyModule_RETURN_ERROR;
+    }
+
+    // handles inherited by a forked child log in again there
+    if (PyKAdminObject_fork_init()) {
+        Py_DECREF(module);
+        PyModule_RETURN_ERROR;
+    }
+
+    // write-behind queues are written out before the interpreter finalizes
+    if (pykadmin_commit_queue_init(module)) {
+        Py_DECREF(module);
+        PyModule_RETURN_ERROR;
+    }
+
 #ifdef PYTHON3
     return module;
 #endif
@@ -166,14 +246,156 @@ PyKADMIN_INIT_FUNC {
 
 static PyObject *_kadmin_get_option(PyObject *self, PyObject *args, PyObject *kwds) {
 
-    // todo
-    return NULL;
+    char *option = NULL;
+    PyObject *result = NULL;
+
+    if (!PyArg_ParseTuple(args, "s", &option))
+        return NULL;
+
+    if (!strcmp(option, "shared_context")) {
+        result = pykadmin_shared_context_enabled ? Py_True : Py_False;
+        Py_INCREF(result);
+    } else {
+        result = pykadmin_options_get(&pykadmin_default_options, option);
+    }
+
+    return result;
 }
 
 static PyObject *_kadmin_set_option(PyObject *self, PyObject *args, PyObject *kwds) {
 
-    // todo
-    return NULL;
+    char *option = NULL;
+    PyObject *value = NULL;
+    int enabled = 0;
+    int result  = 0;
+
+    if (!PyArg_ParseTuple(args, "sO", &option, &value))
+        return NULL;
+
+    if (!strcmp(option, "shared_context")) {
+
+        enabled = PyObject_IsTrue(value);
+        if (enabled < 0)
+            return NULL;
+
+#       ifdef KADMIN_LOCAL
+        if (enabled) {
+            PyErr_SetString(PyExc_ValueError, "kadmin_local handles can not share a context");
+            return NULL;
+        }
+#       endif
+
+        // only affects handles created from now on
+        pykadmin_shared_context_enabled = enabled;
+
+    } else {
+
+        // defaults for handles created from now on; existing ones keep their own copy
+        result = pykadmin_options_set(&pykadmin_default_options, option, value);
+
+        if (result > 0)
+            PyErr_Format(PyExc_ValueError, "unknown option \"%s\"", option);
+        if (result)
+            return NULL;
+    }
+
+    Py_RETURN_NONE;
+}
+
+
+/* client principal init_with_keytab/init_with_ccache would pick when none is given */
+static char *_kadmin_default_client(PyKAdminObject *kadmin, int kind, char *ccache_name) {
+
+    krb5_error_code code = 0;
+    krb5_principal princ = NULL;
+    krb5_ccache cc       = NULL;
+    char *client_name    = NULL;
+
+    if (kind == kSESSION_KEYTAB) {
+
+        code = krb5_sname_to_principal(kadmin->context, NULL, "host", KRB5_NT_SRV_HST, &princ);
+        if (code) { 
+            PyKAdminError_raise_error(code, "krb5_sname_to_principal");
+            goto cleanup;
+        }
+
+    } else {
+
+        if (ccache_name)
+            code = krb5_cc_resolve(kadmin->context, ccache_name, &cc);
+        else
+            code = krb5_cc_default(kadmin->context, &cc);
+
+        if (code) { 
+            PyKAdminError_raise_error(code, ccache_name ? "krb5_cc_resolve" : "krb5_cc_default");
+            goto cleanup;
+        }
+
+        code = krb5_cc_get_principal(kadmin->context, cc, &princ);
+        if (code) { 
+            PyKAdminError_raise_error(code, "krb5_cc_get_principal");
+            goto cleanup;
+        }
+    }
+
+    code = krb5_unparse_name(kadmin->context, princ, &client_name);
+    if (code) { 
+        PyKAdminError_raise_error(code, "krb5_unparse_name");
+        client_name = NULL;
+    }
+
+cleanup:
+
+    if (princ)
+        krb5_free_principal(kadmin->context, princ);
+
+    if (cc)
+        krb5_cc_close(kadmin->context, cc);
+
+    return client_name;
+}
+
+/*
+    record how kadmin authenticates (the session takes ownership of db_args) and log it
+    in with the handle's options. returns 0, or -1 with an exception set.
+*/
+static int _kadmin_login(PyKAdminObject *kadmin, int kind, char *client_name, char *source, char **db_args, char *caller) {
+
+    kadm5_ret_t retval = KADM5_OK;
+
+    if (!kadmin->session) {
+        kadmin->session = pykadmin_session_create(kind, client_name, source, db_args);
+        if (!kadmin->session) {
+            PyErr_NoMemory();
+            return -1;
+        }
+    }
+
+    retval = pykadmin_session_init(kadmin->context, kadmin->session, &kadmin->options, &kadmin->server_handle);
+
+    if (retval != KADM5_OK) {
+        PyKAdminError_raise_error(retval, caller ? caller : (char *)pykadmin_session_caller(kadmin->session));
+        return -1;
+    }
+
+    return 0;
+}
+
+static char **_kadmin_db_args(PyObject *py_db_args) {
+
+    char **db_args = NULL;
+
+    if (py_db_args == Py_None)
+        return NULL;
+
+    db_args = pykadmin_parse_db_args(py_db_args);
+
+    if (PyErr_Occurred()) {
+        pykadmin_free_db_args(db_args);
+        db_args = NULL;
+    }
+
+    return db_args;
 }
 
 
@@ -186,56 +408,34 @@ static PyKAdminObject *_kadmin_local(PyObject *self, PyObject *args) {
     PyObject *py_db_args   = NULL;
     char **db_args         = NULL;
     char *client_name      = NULL;
-    kadm5_config_params *params = NULL;
-
-    kadm5_ret_t retval     = KADM5_OK; 
     int result             = 0;
 
     if (!PyArg_ParseTuple(args, "|O", &py_db_args))
         return NULL; 
 
     kadmin = PyKAdminObject_create();
+    if (!kadmin)
+        return NULL;
 
-    params = calloc(0x1, sizeof(kadm5_config_params));
-
-    db_args = pykadmin_parse_db_args(py_db_args);
-
-    result = asprintf(&client_name, "%s@%s", kROOT_ADMIN, kadmin->realm);
-
-    if (result == -1) {
-        client_name = (char *)kROOT_ADMIN;
-    }
-
-    retval = kadm5_init_with_password(
-                kadmin->context, 
-                client_name, 
-                NULL, 
-                service_name, 
-                params, 
-                struct_version, 
-                api_version, 
-                db_args, 
-                &kadmin->server_handle);
-
-    if (retval != KADM5_OK) {
-
-        Py_XDECREF(kadmin);
-        kadmin = NULL;
+    db_args = _kadmin_db_args(py_db_args);
+    if (PyErr_Occurred())
+        goto error;
 
-        PyKAdminError_raise_error(retval, "kadm5_init_with_password.local");
+    if (asprintf(&client_name, "%s@%s", kROOT_ADMIN, kadmin->realm) == -1)
+        client_name = NULL;
 
-    }
-    
-    if (client_name)
-        free(client_name);
+    result = _kadmin_login(kadmin, kSESSION_PASSWORD, client_name ? client_name : (char *)kROOT_ADMIN, NULL, db_args, "kadm5_init_with_password.local");
 
-    if (params)
-        free(params);
+    free(client_name);
 
-    pykadmin_free_db_args(db_args);
+    if (result)
+        goto error;
 
     return kadmin;
 
+error:
+    Py_DECREF(kadmin);
+    return NULL;
 }
 #endif
 
@@ -244,95 +444,46 @@ static PyKAdminObject *_kadmin_init_with_ccache(PyObject *self, PyObject *args)
     
     PyKAdminObject *kadmin = NULL;
     PyObject *py_db_args   = NULL;
-    kadm5_ret_t retval     = KADM5_OK;
-    krb5_error_code code   = 0;
 
-    krb5_principal princ   = NULL;
     char *ccache_name      = NULL;
     char *client_name      = NULL;
     char *_resolved_client = NULL;
     char **db_args         = NULL;
+    int result             = -1;
 
-    kadm5_config_params *params = NULL;
-
-    krb5_ccache cc;             
-
-    memset(&cc, 0, sizeof(krb5_ccache));
-
-    // TODO : unpack database args as an optional third parameter (will be a dict or array)
     if (!PyArg_ParseTuple(args, "|zzO", &client_name, &ccache_name, &py_db_args))
         return NULL; 
 
     kadmin = PyKAdminObject_create();
-    params = calloc(0x1, sizeof(kadm5_config_params));
-
-    db_args = pykadmin_parse_db_args(py_db_args);
-
-    if (!ccache_name) {
-        code = krb5_cc_default(kadmin->context, &cc);
-        if (code) { 
-            PyKAdminError_raise_error(code, "krb5_cc_default");
-            goto cleanup;
-        }
-    } else {
-        code = krb5_cc_resolve(kadmin->context, ccache_name, &cc);
-        if (code) { 
-            PyKAdminError_raise_error(code, "krb5_cc_resolve");
-            goto cleanup;
-        }
-    } 
+    if (!kadmin)
+        return NULL;
 
     _resolved_client = client_name;
 
     if (!_resolved_client) {
-        code = krb5_cc_get_principal(kadmin->context, cc, &princ);
-        if (code) { 
-            PyKAdminError_raise_error(code, "krb5_cc_get_principal");
+        _resolved_client = _kadmin_default_client(kadmin, kSESSION_CCACHE, ccache_name);
+        if (!_resolved_client)
             goto cleanup;
-        }
-
-        code = krb5_unparse_name(kadmin->context, princ, &_resolved_client);
-        if (code) { 
-            PyKAdminError_raise_error(code, "krb5_unparse_name");
-            goto cleanup;
-        }
     }
-    
-    retval = kadm5_init_with_creds(
-                kadmin->context, 
-                _resolved_client, 
-                cc, 
-                service_name, 
-                params,
-                struct_version, 
-                api_version, 
-                db_args, 
-                &kadmin->server_handle);
 
+    db_args = _kadmin_db_args(py_db_args);
+    if (PyErr_Occurred())
+        goto cleanup;
+
+    result = _kadmin_login(kadmin, kSESSION_CCACHE, _resolved_client, ccache_name, db_args, NULL);
 
 cleanup:
     
     // we only clean up _resolved_client if we calculated it, otherwise it is 
     //  an internal pointer of a python object and freeing it will be illegal.
     if ((client_name == NULL) && _resolved_client)
-        free(_resolved_client);
+        krb5_free_unparsed_name(kadmin->context, _resolved_client);
 
-    krb5_free_principal(kadmin->context, princ);
-    krb5_cc_close(kadmin->context, cc);
-
-    if (retval != KADM5_OK) {
-
-        Py_XDECREF(kadmin);
+    if (result) {
+        Py_DECREF(kadmin);
         kadmin = NULL;
-
-        PyKAdminError_raise_error(retval, "kadm5_init_with_creds");
     }
 
-    if (params)
-        free(params);  
-
-    pykadmin_free_db_args(db_args);
-
     return kadmin;
 }
 
@@ -341,73 +492,48 @@ cleanup:
 static PyKAdminObject *_kadmin_init_with_keytab(PyObject *self, PyObject *args) {
 
     PyKAdminObject *kadmin = NULL;
+    PyObject *py_db_args   = NULL;
 
-    PyObject *py_db_args = NULL;
-    kadm5_ret_t retval   = KADM5_OK;
-    krb5_error_code code = 0;
-
-    krb5_principal princ = NULL;
-    char *client_name    = NULL;
-    char *keytab_name    = NULL;
-    char **db_args       = NULL;
-
-    kadm5_config_params *params = NULL;
+    char *client_name      = NULL;
+    char *keytab_name      = NULL;
+    char *_resolved_client = NULL;
+    char **db_args         = NULL;
+    int result             = -1;
 
     if (!PyArg_ParseTuple(args, "|zzO", &client_name, &keytab_name, &py_db_args))
         return NULL; 
 
     kadmin = PyKAdminObject_create();
-    params = calloc(0x1, sizeof(kadm5_config_params));
-
-    db_args = pykadmin_parse_db_args(py_db_args);
+    if (!kadmin)
+        return NULL;
 
     if (keytab_name == NULL) {
         keytab_name = "/etc/krb5.keytab";
     }
+
+    _resolved_client = client_name;
   
-    if (client_name == NULL) {
-        
-        code = krb5_sname_to_principal(kadmin->context, NULL, "host", KRB5_NT_SRV_HST, &princ);
-        if (code) { 
-            PyKAdminError_raise_error(code, "krb5_sname_to_principal");
-            goto cleanup;
-        }
-        
-        code = krb5_unparse_name(kadmin->context, princ, &client_name);
-        if (code) { 
-            PyKAdminError_raise_error(code, "krb5_unparse_name");
+    if (!_resolved_client) {
+        _resolved_client = _kadmin_default_client(kadmin, kSESSION_KEYTAB, NULL);
+        if (!_resolved_client)
             goto cleanup;
-        }
     }
 
-    retval = kadm5_init_with_skey(
-                kadmin->context, 
-                client_name, 
-                keytab_name, 
-                service_name, 
-                params,
-                struct_version, 
-                api_version, 
-                db_args, 
-                &kadmin->server_handle);
-
-    if (retval != KADM5_OK) {
-
-        Py_XDECREF(kadmin);
-        kadmin = NULL;
+    db_args = _kadmin_db_args(py_db_args);
+    if (PyErr_Occurred())
+        goto cleanup;
 
-        PyKAdminError_raise_error(retval, "kadm5_init_with_skey");
-    }
+    result = _kadmin_login(kadmin, kSESSION_KEYTAB, _resolved_client, keytab_name, db_args, NULL);
 
 cleanup:
     
-    if (princ)
-        krb5_free_principal(kadmin->context, princ);
-
-    if (params)
-        free(params);
+    if ((client_name == NULL) && _resolved_client)
+        krb5_free_unparsed_name(kadmin->context, _resolved_client);
 
-    pykadmin_free_db_args(db_args);
+    if (result) {
+        Py_DECREF(kadmin);
+        kadmin = NULL;
+    }
 
     return kadmin;
 }
@@ -417,47 +543,360 @@ static PyKAdminObject *_kadmin_init_with_password(PyObject *self, PyObject *args
 
     PyKAdminObject *kadmin = NULL;
     PyObject *py_db_args   = NULL;
-    kadm5_ret_t retval     = KADM5_OK;
     
     char *client_name = NULL;
     char *password    = NULL;
     char **db_args    = NULL;
-     
-    kadm5_config_params *params = NULL;
 
     if (!PyArg_ParseTuple(args, "zz|O", &client_name, &password, &py_db_args))
         return NULL;
 
     kadmin = PyKAdminObject_create();
-    params = calloc(0x1, sizeof(kadm5_config_params));
+    if (!kadmin)
+        return NULL;
 
-    db_args = pykadmin_parse_db_args(py_db_args);
+    db_args = _kadmin_db_args(py_db_args);
 
-    retval = kadm5_init_with_password(
-                kadmin->context, 
-                client_name, 
-                password, 
-                service_name, 
-                params, 
-                struct_version, 
-                api_version, 
-                db_args, 
-                &kadmin->server_handle);
+    if (PyErr_Occurred() || _kadmin_login(kadmin, kSESSION_PASSWORD, client_name, password, db_args, NULL)) {
+        Py_DECREF(kadmin);
+        kadmin = NULL;
+    }
 
-    if (retval != KADM5_OK) { 
+    return kadmin;
 
-        Py_XDECREF(kadmin);
-        kadmin = NULL;
+}
+
+
+/*
+    kadmin.connect keeps every handle it authenticates, keyed by
+    (credential kind, client principal, keytab/ccache name, db_args, admin_server,
+    kadmind_port), and hands the same
+    handle back to later calls with that key instead of running kadm5_init_* again.
+    passwords never go into the key; a handle is only reused for the password it was
+    made with.
+*/
+
+static PyObject *pykadmin_connections = NULL;
+
+static PyObject *_kadmin_connection_key(pykadmin_session_t *session, pykadmin_options_t *options, PyObject *admin_servers) {
 
-        PyKAdminError_raise_error(retval, "kadm5_init_with_password");
+    PyObject *db_args  = NULL;
+    PyObject *argument = NULL;
+    Py_ssize_t count   = 0;
+    Py_ssize_t index   = 0;
+
+    if (session->db_args) {
+        while (session->db_args[count])
+            count++;
     }
 
-    if (params)
-        free(params);
+    db_args = PyTuple_New(count);
+    if (!db_args)
+        return NULL;
 
-    pykadmin_free_db_args(db_args);
+    for (index = 0; index < count; index++) {
 
-    return kadmin;
+        argument = PyUnicode_FromString(session->db_args[index]);
+        if (!argument) {
+            Py_DECREF(db_args);
+            return NULL;
+        }
+
+        PyTuple_SET_ITEM(db_args, index, argument);
+    }
+
+    return Py_BuildValue("(iszNziO)", 
+                session->kind, 
+                session->client, 
+                (session->kind == kSESSION_PASSWORD) ? NULL : session->source, 
+                db_args,
+                options->admin_server,
+                options->kadmind_port,
+                admin_servers ? admin_servers : Py_None);
+}
+
+static PyObject *_kadmin_connect(PyObject *self, PyObject *args, PyObject *kwds) {
+
+    static char *kwlist[] = {"principal", "keytab", "ccache", "password", "db_args", "check", "admin_servers", NULL};
+
+    PyKAdminObject *kadmin   = NULL;
+    PyKAdminObject *existing = NULL;
+    PyObject *py_db_args     = NULL;
+    PyObject *py_check       = NULL;
+    PyObject *py_servers     = NULL;
+    PyObject *servers        = NULL;
+    PyObject *key            = NULL;
+    PyObject *result         = NULL;
+    kadm5_ret_t retval       = KADM5_OK;
+
+    char *client_name   = NULL;
+    char *keytab_name   = NULL;
+    char *ccache_name   = NULL;
+    char *password      = NULL;
+    char *default_name  = NULL;
+    char *source        = NULL;
+    const char *caller  = NULL;
+    char **db_args      = NULL;
+    char **admin_servers = NULL;
+    Py_ssize_t count    = 0;
+    Py_ssize_t index    = 0;
+    int kind            = kSESSION_CCACHE;
+    int check           = 1;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|zzzzOOO", kwlist, 
+            &client_name, &keytab_name, &ccache_name, &password, &py_db_args, &py_check, &py_servers))
+        return NULL;
+
+    if ((keytab_name != NULL) + (ccache_name != NULL) + (password != NULL) > 1) {
+        PyErr_SetString(PyExc_ValueError, "connect takes only one of keytab, ccache or password");
+        return NULL;
+    }
+
+    if (password) {
+        kind   = kSESSION_PASSWORD;
+        source = password;
+    } else if (keytab_name) {
+        kind   = kSESSION_KEYTAB;
+        source = keytab_name;
+    } else {
+        source = ccache_name;
+    }
+
+    if ((kind == kSESSION_PASSWORD) && !client_name) {
+        PyErr_SetString(PyExc_ValueError, "connect with a password requires a principal");
+        return NULL;
+    }
+
+    if (py_check) {
+        check = PyObject_IsTrue(py_check);
+        if (check < 0)
+            return NULL;
+    }
+
+    if (py_servers && (py_servers != Py_None)) {
+
+#       ifdef KADMIN_LOCAL
+        PyErr_SetString(PyExc_ValueError, "kadmin_local has no admin servers to fail over between");
+        return NULL;
+#       else
+        // a tuple of str, which also serves as part of the key
+        servers = PySequence_Tuple(py_servers);
+        if (!servers)
+            return NULL;
+
+        count = PyTuple_GET_SIZE(servers);
+
+        for (index = 0; index < count; index++) {
+            if (!PyUnicodeBytes_Check(PyTuple_GET_ITEM(servers, index))) {
+                PyErr_SetString(PyExc_TypeError, "admin_servers must be a sequence of str");
+                goto cleanup;
+            }
+        }
+
+        if (count == 0) {
+            PyErr_SetString(PyExc_ValueError, "admin_servers must not be empty");
+            goto cleanup;
+        }
+#       endif
+    }
 
+    kadmin = PyKAdminObject_create();
+    if (!kadmin)
+        goto cleanup;
+
+    // the key must name the principal actually used, not the absence of one
+    if (!client_name) {
+        default_name = _kadmin_default_client(kadmin, kind, ccache_name);
+        if (!default_name)
+            goto cleanup;
+    }
+
+    db_args = _kadmin_db_args(py_db_args);
+    if (PyErr_Occurred())
+        goto cleanup;
+
+    // the session owns db_args from here on
+    kadmin->session = pykadmin_session_create(kind, default_name ? default_name : client_name, source, db_args);
+
+    if (default_name) {
+        krb5_free_unparsed_name(kadmin->context, default_name);
+        default_name = NULL;
+    }
+
+    if (!kadmin->session) {
+        PyErr_NoMemory();
+        goto cleanup;
+    }
+
+    key = _kadmin_connection_key(kadmin->session, &kadmin->options, servers);
+    if (!key)
+        goto cleanup;
+
+    if (!pykadmin_connections) {
+        pykadmin_connections = PyDict_New();
+        if (!pykadmin_connections)
+            goto cleanup;
+    }
+
+    existing = (PyKAdminObject *)PyDict_GetItem(pykadmin_connections, key);
+
+    if (existing && (kind == kSESSION_PASSWORD) && strcmp(existing->session->source, password))
+        existing = NULL;
+
+    if (existing) {
+
+        // made before a fork: the connection is the parent's, so don't even probe it
+        if (PyKAdminObject_STALE(existing)) {
+            retval = PyKAdminObject_reconnect(existing);
+        } else {
+
+            if (check)
+                retval = pykadmin_session_check(existing->server_handle);
+
+            // kadmind dropped the connection (restart, idle timeout, expired ticket): log in again
+            if (retval != KADM5_OK)
+                retval = PyKAdminObject_relogin(existing);
+        }
+
+        if (retval == KADM5_OK) {
+            Py_INCREF(existing);
+            result = (PyObject *)existing;
+        } else {
+            caller = pykadmin_session_caller(existing->session);
+            PyDict_DelItem(pykadmin_connections, key);
+            PyKAdminError_raise_error(retval, (char *)caller);
+        }
+
+        goto cleanup;
+    }
+
+    if (servers) {
+
+        admin_servers = calloc(count, sizeof(char *));
+        if (!admin_servers) {
+            PyErr_NoMemory();
+            goto cleanup;
+        }
+
+        for (index = 0; index < count; index++) {
+            admin_servers[index] = PyUnicode_or_PyBytes_asCString(PyTuple_GET_ITEM(servers, index));
+            if (!admin_servers[index]) {
+                if (!PyErr_Occurred())
+                    PyErr_NoMemory();
+                goto cleanup;
+            }
+        }
+
+        kadmin->failover = pykadmin_failover_create(admin_servers, count);
+        if (!kadmin->failover) {
+            PyErr_NoMemory();
+            goto cleanup;
+        }
+
+        retval = pykadmin_failover_start(kadmin->failover, kadmin->session, &kadmin->options);
+        if (retval != KADM5_OK) {
+            PyKAdminError_raise_error(retval, (char *)pykadmin_session_caller(kadmin->session));
+            goto cleanup;
+        }
+
+        kadmin->server_handle = pykadmin_failover_active(kadmin->failover)->server_handle;
+
+    } else if (_kadmin_login(kadmin, kind, NULL, NULL, NULL, NULL)) {
+        goto cleanup;
+    }
+
+    if (PyDict_SetItem(pykadmin_connections, key, (PyObject *)kadmin))
+        goto cleanup;
+
+    result = (PyObject *)kadmin;
+    kadmin = NULL;
+
+cleanup:
+
+    if (default_name)
+        krb5_free_unparsed_name(kadmin->context, default_name);
+
+    if (admin_servers) {
+        for (index = 0; index < count; index++)
+            free(admin_servers[index]);
+        free(admin_servers);
+    }
+
+    Py_XDECREF(servers);
+    Py_XDECREF(key);
+    Py_XDECREF(kadmin);
+
+    return result;
 }
 
+/*
+    drop kadm (every handle when omitted) from the connect registry, returning how many
+    entries went. the handle, with its renewal entry and write-behind queue, is released
+    once the caller lets go of it too; a later connect logs in afresh.
+*/
+static PyObject *_kadmin_disconnect(PyObject *self, PyObject *args) {
+
+    PyObject *kadm   = NULL;
+    PyObject *keys   = NULL;
+    PyObject *key    = NULL;
+    Py_ssize_t count = 0;
+    Py_ssize_t index = 0;
+
+    if (!PyArg_ParseTuple(args, "|O!", &PyKAdminObject_Type, &kadm))
+        return NULL;
+
+    if (!pykadmin_connections)
+        return PyUnifiedLongInt_FromLong(0);
+
+    if (!kadm) {
+        count = PyDict_Size(pykadmin_connections);
+        PyDict_Clear(pykadmin_connections);
+        return PyUnifiedLongInt_FromLong((long)count);
+    }
+
+    keys = PyDict_Keys(pykadmin_connections);
+    if (!keys)
+        return NULL;
+
+    for (index = 0; index < PyList_GET_SIZE(keys); index++) {
+
+        key = PyList_GET_ITEM(keys, index);
+
+        if (PyDict_GetItem(pykadmin_connections, key) != kadm)
+            continue;
+
+        if (PyDict_DelItem(pykadmin_connections, key)) {
+            Py_DECREF(keys);
+            return NULL;
+        }
+
+        count++;
+    }
+
+    Py_DECREF(keys);
+
+    return PyUnifiedLongInt_FromLong((long)count);
+}
+
+
+#ifndef KADMIN_LOCAL
+static PyObject *_kadmin_gateway(PyObject *self, PyObject *args, PyObject *kwds) {
+
+    static char *kwlist[] = {"path", "kadm", "pool", "mode", NULL};
+
+    PyKAdminObject *kadm = NULL;
+    char *path = NULL;
+    int pool   = 4;
+    int mode   = 0600;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "sO!|ii", kwlist, &path, &PyKAdminObject_Type, &kadm, &pool, &mode))
+        return NULL;
+
+    if (pool < 1) {
+        PyErr_SetString(PyExc_ValueError, "pool must be at least 1");
+        return NULL;
+    }
+
+    return pykadmin_gateway_serve(path, kadm, pool, mode);
+}
+#endif
@@ -25,17 +25,33 @@ struct module_state {
 # 	define PyUnifiedLongInt_FromLong(from) PyLong_FromLong((long) from)
 #	define PyUnifiedLongInt_AsUnsignedLong(ob) PyLong_AsUnsignedLong((PyObject *)ob)
 #	define PyUnifiedLongInt_AsLong(ob) PyLong_AsLong((PyObject *)ob)
+#	define PyUnifiedLongInt_Check(ob) (PyLong_Check(ob) && !PyBool_Check(ob))
 #else 
 #   define GETSTATE(m) (&_state)    
 # 	define PyUnifiedLongInt_FromLong(from) PyInt_FromLong((long) from)
 #	define PyUnifiedLongInt_AsUnsignedLong(ob) PyInt_AsUnsignedLongMask((PyObject *)ob)
 #	define PyUnifiedLongInt_AsLong(ob) PyInt_AsLong((PyObject *)ob)
+#	define PyUnifiedLongInt_Check(ob) ((PyInt_Check(ob) || PyLong_Check(ob)) && !PyBool_Check(ob))
+#endif
+
+#if PY_VERSION_HEX < 0x03020000
+typedef long Py_hash_t;
 #endif
 
 #ifndef Py_TYPE
 #	define Py_TYPE(ob) (((PyObject*)(ob))->ob_type)
 #endif
 
+/* bumped in the child after every fork (pthread_atfork); state set up before it is inherited */
+extern unsigned long pykadmin_fork_generation;
+
 #define PyUnicodeBytes_Check(obj) (PyUnicode_CheckExact(obj) || PyBytes_CheckExact(obj))
 
+/* call a callback with two positional arguments, through vectorcall where available */
+#if PY_VERSION_HEX >= 0x03090000
+#	define PyKAdmin_CallTwoArgs(callable, a, b) PyObject_Vectorcall(callable, (PyObject *[]){a, b}, 2, NULL)
+#else
+#	define PyKAdmin_CallTwoArgs(callable, a, b) PyObject_CallFunctionObjArgs(callable, a, b, NULL)
+#endif
+
 #endif
\ No newline at end of file
@@ -1,6 +1,10 @@
 
 import gc
+import functools
+import datetime
 import time
+import threading
+import signal
 import sys
 import kadmin
 import kadmin_local
@@ -162,6 +166,228 @@ class KAdminUnitTests(unittest.TestCase):
             self.fail("kadmin.init_with_password failed")
      
         self.assertIsNotNone(kadm, "kadmin handle is None")
+
+    def test_shared_context(self):
+
+        self.assertTrue(kadmin.get_option("shared_context"))
+
+        handles = [kadmin.init_with_keytab(TEST_PRINCIPAL, TEST_KEYTAB) for _ in range(4)]
+        self.assertTrue(all(kadm.principal_exists(TEST_PRINCIPAL) for kadm in handles))
+
+        kadmin.set_option("shared_context", False)
+        try:
+            kadm = kadmin.init_with_keytab(TEST_PRINCIPAL, TEST_KEYTAB)
+            self.assertTrue(kadm.principal_exists(TEST_PRINCIPAL))
+        finally:
+            kadmin.set_option("shared_context", True)
+
+        self.assertRaises(ValueError, kadmin.get_option, "no_such_option")
+
+
+    def test_connect(self):
+
+        kadm = kadmin.connect(TEST_PRINCIPAL, keytab=TEST_KEYTAB)
+        self.assertTrue(kadm.principal_exists(TEST_PRINCIPAL))
+
+        # same principal and keytab: the live handle comes back, no new login
+        self.assertIs(kadmin.connect(TEST_PRINCIPAL, keytab=TEST_KEYTAB), kadm)
+        self.assertIs(kadmin.connect(TEST_PRINCIPAL, keytab=TEST_KEYTAB, check=False), kadm)
+
+        self.assertIsNot(kadmin.connect(TEST_PRINCIPAL, password=TEST_PASSWORD), kadm)
+
+        self.assertRaises(ValueError, kadmin.connect, TEST_PRINCIPAL, keytab=TEST_KEYTAB, password=TEST_PASSWORD)
+        self.assertRaises(ValueError, kadmin.connect, password=TEST_PASSWORD)
+
+        # dropped from the registry: the next connect logs in again
+        self.assertEqual(kadmin.disconnect(kadm), 1)
+        self.assertEqual(kadmin.disconnect(kadm), 0)
+        self.assertIsNot(kadmin.connect(TEST_PRINCIPAL, keytab=TEST_KEYTAB), kadm)
+        self.assertTrue(kadmin.disconnect() >= 1)
+
+    def test_options(self):
+
+        self.assertIsNone(kadmin.get_option("timeout"))
+        self.assertIsNone(kadmin.get_option("admin_server"))
+
+        kadmin.set_option("retries", 2)
+        kadmin.set_option("timeout", 5)
+        try:
+            kadm = kadmin.init_with_keytab(TEST_PRINCIPAL, TEST_KEYTAB)
+            self.assertEqual(kadm.get_option("timeout"), 5.0)
+            self.assertEqual(kadm.get_option("retries"), 2)
+        finally:
+            kadmin.set_option("retries", 0)
+            kadmin.set_option("timeout", None)
+
+        # per handle, applied to the live rpc client
+        kadm.set_option("timeout", 0.5)
+        self.assertEqual(kadm.get_option("timeout"), 0.5)
+        self.assertIsNone(kadmin.get_option("timeout"))
+        self.assertTrue(kadm.principal_exists(TEST_PRINCIPAL))
+
+        self.assertRaises(ValueError, kadm.set_option, "timeout", -1)
+        self.assertRaises(ValueError, kadm.set_option, "kadmind_port", 70000)
+        self.assertRaises(ValueError, kadm.get_option, "shared_context")
+
+
+    def test_controller(self):
+
+        controller = kadmin.Controller(max_concurrency=8, rate=200, retries=2)
+
+        kadmin.set_option("shared_context", False)
+        try:
+            handles = [kadmin.init_with_keytab(TEST_PRINCIPAL, TEST_KEYTAB) for _ in range(4)]
+        finally:
+            kadmin.set_option("shared_context", True)
+
+        for kadm in handles:
+            kadm.controller = controller
+            self.assertIs(kadm.controller, controller)
+
+        def work(kadm):
+            for account in TEST_ACCOUNTS[:25]:
+                kadm.principal_exists(account)
+
+        threads = [threading.Thread(target=work, args=(kadm,)) for kadm in handles]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+
+        stats = controller.stats()
+        self.assertEqual(stats["calls"], 100)
+        self.assertEqual(stats["in_flight"], 0)
+        self.assertTrue(1 <= controller.window <= 8)
+
+        self.assertRaises(TypeError, setattr, handles[0], "controller", object())
+        handles[0].controller = None
+        self.assertIsNone(handles[0].controller)
+
+
+    def test_renewal(self):
+
+        kadm = kadmin.init_with_keytab(TEST_PRINCIPAL, TEST_KEYTAB)
+
+        expires = kadm.expires
+        self.assertTrue(expires is None or expires > time.time())
+
+        # a margin longer than the ticket lifetime renews at once
+        self.assertTrue(kadm.enable_renewal(margin=10 ** 9))
+        time.sleep(2)
+        self.assertTrue(kadm.principal_exists(TEST_PRINCIPAL))
+
+        self.assertTrue(kadm.disable_renewal())
+        self.assertRaises(ValueError, kadm.enable_renewal, margin=-1)
+
+    def test_failover(self):
+
+        # nothing listens on port 1, so only the first server comes up
+        kadm = kadmin.connect(TEST_PRINCIPAL, keytab=TEST_KEYTAB, admin_servers=["localhost", "localhost:1"])
+
+        servers = kadm.servers
+        self.assertEqual([server["admin_server"] for server in servers], ["localhost", "localhost:1"])
+        self.assertTrue(servers[0]["active"] and servers[0]["primary"] and servers[0]["healthy"])
+        self.assertFalse(servers[1]["healthy"] or servers[1]["primary"])
+        self.assertEqual(kadm.get_option("primary_deadline"), 60.0)
+
+        # the dead standby is skipped and the active server kept
+        kadm.set_option("failover_deadline", 5.0)
+        self.assertEqual(kadm.failover(), "localhost")
+        self.assertTrue(kadm.principal_exists(TEST_PRINCIPAL))
+
+        self.assertRaises(ValueError, kadm.failover, "kdc.invalid")
+
+        # writes stay on the primary: the dead standby cannot take them
+        self.assertRaises(kadmin.KAdminError, kadm.promote, "localhost:1")
+        self.assertEqual(kadm.promote(), "localhost")
+        self.assertRaises(ValueError, kadm.promote, "kdc.invalid")
+        self.assertTrue(kadm.servers[0]["calls"] >= 1)
+        self.assertTrue(kadmin.connect(TEST_PRINCIPAL, keytab=TEST_KEYTAB).servers is None)
+
+    def test_replica(self):
+
+        kadm = kadmin.init_with_keytab(TEST_PRINCIPAL, TEST_KEYTAB)
+        self.assertTrue(kadm.replica is None)
+
+        # the tests run on the KDC, so its database doubles as a replica
+        self.assertTrue(kadm.attach_replica())
+
+        self.assertTrue(kadm.principal_exists(TEST_PRINCIPAL))
+        self.assertEqual(kadm.getprinc(TEST_PRINCIPAL).principal, TEST_PRINCIPAL)
+        self.assertTrue(TEST_PRINCIPAL in list(kadm.principals()))
+        self.assertTrue(kadm.replica["reads"] >= 3)
+
+        # a write sends reads to kadmind until it shows up locally
+        delete_test_accounts()
+        kadm.ank(TEST_ACCOUNTS[0])
+        self.assertEqual(kadm.replica["pending"], 1)
+        self.assertTrue(kadm.principal_exists(TEST_ACCOUNTS[0]))
+        kadm.delprinc(TEST_ACCOUNTS[0])
+        self.assertFalse(kadm.principal_exists(TEST_ACCOUNTS[0]))
+
+        self.assertRaises(ValueError, kadm.attach_replica, max_staleness=-1)
+        self.assertTrue(kadm.detach_replica())
+        self.assertTrue(kadm.replica is None)
+
+    def test_fork(self):
+
+        kadm = kadmin.init_with_keytab(TEST_PRINCIPAL, TEST_KEYTAB)
+        self.assertTrue(kadm.principal_exists(TEST_PRINCIPAL))
+
+        pid = os.fork()
+        if not pid:
+            # the inherited handle logs in again before its first call
+            status = 1
+            try:
+                if kadm.principal_exists(TEST_PRINCIPAL) and kadm.getprinc(TEST_PRINCIPAL).principal == TEST_PRINCIPAL:
+                    status = 0
+            finally:
+                os._exit(status)
+
+        status = os.waitpid(pid, 0)[1]
+        self.assertEqual(status, 0)
+
+        # the child left the parent's session alone
+        self.assertTrue(kadm.principal_exists(TEST_PRINCIPAL))
+
+    def test_gateway(self):
+
+        path = "/tmp/pykadmin-gateway-test.sock"
+
+        pid = os.fork()
+        if not pid:
+            try:
+                kadm = kadmin.init_with_keytab(TEST_PRINCIPAL, TEST_KEYTAB)
+                kadmin.gateway(path, kadm, pool=2)
+            finally:
+                os._exit(0)
+
+        try:
+            gateway = None
+            for attempt in range(50):
+                try:
+                    gateway = kadmin.GatewayClient(path)
+                    break
+                except OSError:
+                    time.sleep(0.1)
+
+            self.assertTrue(gateway is not None)
+
+            delete_test_accounts()
+
+            self.assertTrue(gateway.principal_exists(TEST_PRINCIPAL))
+            self.assertEqual(gateway.getprinc(TEST_PRINCIPAL)["principal"], TEST_PRINCIPAL)
+            self.assertTrue(gateway.getprinc(TEST_ACCOUNTS[0]) is None)
+
+            gateway.ank(TEST_ACCOUNTS[0])
+            self.assertTrue(TEST_ACCOUNTS[0] in gateway.principals())
+            gateway.delprinc(TEST_ACCOUNTS[0])
+            self.assertFalse(gateway.principal_exists(TEST_ACCOUNTS[0]))
+
+            gateway.close()
+        finally:
+            os.kill(pid, signal.SIGINT)
+            os.waitpid(pid, 0)
     
     def test_create(self):
        
@@ -183,6 +409,71 @@ class KAdminUnitTests(unittest.TestCase):
 
         delete_test_accounts()
 
+    def test_create_with_attributes(self):
+
+        kadm = self.kadm
+
+        delete_test_accounts()
+
+        kadm.ank(TEST_ACCOUNTS[0], None, maxlife="10 hours", attributes=kadmin.REQUIRES_PRE_AUTH, enctypes="aes256-cts:normal", expire="2030-01-01 00:00:00Z")
+
+        princ = kadm.getprinc(TEST_ACCOUNTS[0])
+        self.assertEqual(princ.maxlife, datetime.timedelta(hours=10))
+        self.assertTrue(princ.attributes & kadmin.REQUIRES_PRE_AUTH)
+
+        # explicit values override the template's
+        kadm.ank(TEST_ACCOUNTS[1], None, template=TEST_ACCOUNTS[0], maxlife="5 hours")
+
+        princ = kadm.getprinc(TEST_ACCOUNTS[1])
+        self.assertEqual(princ.maxlife, datetime.timedelta(hours=5))
+        self.assertTrue(princ.attributes & kadmin.REQUIRES_PRE_AUTH)
+        self.assertEqual(princ.expire, None)
+
+        self.assertRaises(ValueError, kadm.ank, TEST_ACCOUNTS[2], None, enctypes="no-such-enctype")
+        self.assertRaises(kadmin.KAdminError, kadm.ank, TEST_ACCOUNTS[2], None, policy="no-such-policy")
+        self.assertFalse(kadm.principal_exists(TEST_ACCOUNTS[2]))
+
+        delete_test_accounts()
+
+    def test_write_behind(self):
+
+        kadm = kadmin.init_with_keytab(TEST_PRINCIPAL, TEST_KEYTAB)
+
+        delete_test_accounts()
+        kadm.ank(TEST_ACCOUNTS[0])
+
+        # no background writes: only flush() sends the queue
+        kadm.enable_write_behind(delay=0)
+
+        princ = kadm.getprinc(TEST_ACCOUNTS[0])
+        princ.maxlife = datetime.timedelta(hours=10)
+        princ.commit()
+        princ.maxrenewlife = datetime.timedelta(days=2)
+        princ.maxlife = datetime.timedelta(hours=5)
+        princ.commit()
+
+        self.assertEqual(kadm.write_behind["pending"], 1)
+        self.assertEqual(kadm.write_behind["commits"], 2)
+        self.assertNotEqual(kadm.getprinc(TEST_ACCOUNTS[0]).maxlife, datetime.timedelta(hours=5))
+
+        self.assertEqual(kadm.flush(), {TEST_ACCOUNTS[0]: True})
+        self.assertEqual(kadm.write_behind["writes"], 1)
+
+        princ = kadm.getprinc(TEST_ACCOUNTS[0])
+        self.assertEqual(princ.maxlife, datetime.timedelta(hours=5))
+        self.assertEqual(princ.maxrenewlife, datetime.timedelta(days=2))
+
+        # deleted behind the queue's back: the item's result is the error
+        princ.maxlife = datetime.timedelta(hours=1)
+        princ.commit()
+        self.kadm.delprinc(TEST_ACCOUNTS[0])
+
+        results = kadm.disable_write_behind()
+        self.assertTrue(isinstance(results[TEST_ACCOUNTS[0]], kadmin.KAdminError))
+        self.assertTrue(kadm.write_behind is None)
+
+        delete_test_accounts()
+
     def test_delete(self):
         
         kadm = self.kadm
@@ -225,6 +516,25 @@ class KAdminUnitTests(unittest.TestCase):
         account = TEST_ACCOUNTS[0]
 
         self.assertRaises(kadmin.KAdminError, kadm.delprinc, account)
+
+    def test_error_classes(self):
+
+        kadm = self.kadm
+
+        delete_test_accounts()
+
+        self.assertTrue(issubclass(kadmin.UnknownPrincipalError, kadmin.AdminError))
+        self.assertTrue(kadmin.UnknownPrincipalError is kadmin.UnknownPrincipalError)
+        self.assertTrue("UnknownPrincipalError" in dir(kadmin))
+
+        try:
+            kadm.delprinc(TEST_ACCOUNTS[0])
+        except kadmin.UnknownPrincipalError as error:
+            self.assertEqual(error.args[0]["message"], "Principal does not exist")
+        else:
+            self.fail("UnknownPrincipalError not raised")
+
+        self.assertRaises(AttributeError, getattr, kadmin, "NoSuchError")
     
     def test_iteration(self):
 
@@ -280,6 +590,198 @@ class KAdminUnitTests(unittest.TestCase):
         b = kadm.getprinc(account)
 
         self.assertNotEqual(a, b)
+
+    def test_principal_cache(self):
+
+        kadm = self.kadm
+
+        create_test_accounts()
+
+        account = TEST_ACCOUNTS[0]
+
+        kadm.enable_cache(16, 60)
+
+        a = kadm.getprinc(account)
+        b = kadm.getprinc(account)
+
+        self.assertEqual(a, b)
+
+        stats = kadm.cache_stats()
+        self.assertEqual(stats["misses"], 1)
+        self.assertEqual(stats["hits"], 1)
+
+        # writes through the handle drop the cached copy
+        b.randkey()
+        self.assertEqual(kadm.cache_stats()["entries"], 0)
+
+        for account in TEST_ACCOUNTS[:20]:
+            kadm.getprinc(account)
+
+        stats = kadm.cache_stats()
+        self.assertEqual(stats["entries"], 16)
+        self.assertTrue(stats["evictions"] >= 4)
+
+        kadm.disable_cache()
+        self.assertFalse(kadm.cache_stats()["enabled"])
+
+    def test_memoized_attributes(self):
+
+        kadm = self.kadm
+
+        create_test_accounts()
+
+        princ = kadm.getprinc(TEST_ACCOUNTS[0])
+
+        self.assertTrue(princ.principal is princ.principal)
+        self.assertTrue(princ.maxlife is princ.maxlife)
+
+        # setters replace the memoized value
+        princ.maxlife = datetime.timedelta(days=2)
+        self.assertEqual(princ.maxlife, datetime.timedelta(days=2))
+
+        princ.reload()
+        self.assertNotEqual(princ.maxlife, datetime.timedelta(days=2))
+
+    def test_time_format(self):
+
+        kadm = self.kadm
+
+        create_test_accounts()
+
+        princ = kadm.getprinc(TEST_ACCOUNTS[0])
+
+        self.assertEqual(kadm.time_format, "datetime")
+        self.assertTrue(isinstance(princ.mod_date, datetime.datetime))
+
+        kadm.time_format = "epoch"
+
+        try:
+            self.assertTrue(isinstance(princ.mod_date, int))
+            self.assertTrue(isinstance(princ.maxlife, int))
+
+            princ.maxlife = 3600
+            self.assertEqual(princ.maxlife, 3600)
+
+            self.assertRaises(ValueError, setattr, kadm, "time_format", "iso")
+        finally:
+            kadm.time_format = "datetime"
+
+        self.assertEqual(princ.maxlife, datetime.timedelta(seconds=3600))
+
+    def test_date_strings(self):
+
+        kadm = self.kadm
+
+        create_test_accounts()
+
+        princ = kadm.getprinc(TEST_ACCOUNTS[0])
+
+        princ.maxlife = "8 Days"
+        self.assertEqual(princ.maxlife, datetime.timedelta(days=8))
+
+        princ.maxlife = "10:00:00"
+        self.assertEqual(princ.maxlife, datetime.timedelta(hours=10))
+
+        princ.expire = "2030-01-01 00:00:00Z"
+        kadm.time_format = "epoch"
+        try:
+            self.assertEqual(princ.expire, 1893456000)
+        finally:
+            kadm.time_format = "datetime"
+
+        princ.expire = "never"
+        self.assertEqual(princ.expire, None)
+
+        # falls back to the getdate grammar
+        princ.pwexpire = "next monday"
+        self.assertTrue(princ.pwexpire > datetime.datetime.now())
+
+        self.assertRaises(ValueError, setattr, princ, "maxlife", "sometime")
+
+    def test_keys(self):
+
+        kadm = self.kadm
+
+        create_test_accounts()
+
+        princ = kadm.getprinc(TEST_ACCOUNTS[0])
+
+        keys = princ.keys
+        raw = princ.keys_raw
+
+        self.assertEqual(len(raw) % 3, 0)
+        self.assertEqual(len(raw) // 3, sum(len(v) for v in keys.values()))
+        self.assertEqual(set(raw[0::3]), set(keys.keys()))
+
+        # every read gets its own copy
+        self.assertEqual(keys, princ.keys)
+        keys.clear()
+        self.assertNotEqual(princ.keys, {})
+
+    def test_names(self):
+
+        kadm = self.kadm
+
+        create_test_accounts()
+
+        account = TEST_ACCOUNTS[0]
+        name = kadm.name(account)
+
+        self.assertEqual(str(name), account)
+        self.assertEqual(name, account)
+        self.assertEqual(hash(name), hash(account))
+        self.assertEqual(name, kadm.name(account.split("@")[0]))
+
+        self.assertTrue(kadm.principal_exists(name))
+        self.assertEqual(kadm.getprinc(name), kadm.getprinc(account))
+
+        names = list(kadm.principals(names=True))
+        self.assertTrue(all(isinstance(n, kadmin.Name) for n in names))
+        self.assertTrue(name in names)
+
+    def test_exists_many(self):
+
+        kadm = self.kadm
+
+        create_test_accounts()
+
+        names = TEST_ACCOUNTS[:10] + ["missing{0:02d}@EXAMPLE.COM".format(i) for i in range(5)]
+        expected = [True] * 10 + [False] * 5
+
+        for method in ("auto", "lookup", "list"):
+            self.assertEqual(kadm.exists_many(names, method=method), expected)
+
+        self.assertEqual(kadm.exists_many(names, threshold=1), expected)
+
+        # a large realm makes lookups cheaper than listings; a tiny one lists everything
+        for realm_size in (1, 10 ** 7):
+            self.assertEqual(kadm.exists_many(names, threshold=1, realm_size=realm_size), expected)
+
+        bits = bytearray(kadm.exists_many(names, bitmap=True))
+        self.assertEqual([bool(bits[i // 8] & (1 << (i % 8))) for i in range(len(names))], expected)
+
+        self.assertEqual(kadm.exists_many([]), [])
+
+        # listings by prefix keep regexp characters literal and other realms in
+        odd = ["missing.(x)+?@EXAMPLE.COM", "missing*[1]@EXAMPLE.COM", TEST_ACCOUNTS[0].split("@")[0] + "@OTHER.REALM"]
+        self.assertEqual(kadm.exists_many(TEST_ACCOUNTS[:1] + odd, method="list"), [True, False, False, False])
+
+    def test_policy_cache(self):
+
+        kadm = self.kadm
+
+        names = list(kadm.policies())
+
+        self.assertEqual(kadm.enable_policy_cache(), True)
+        self.assertEqual(kadm.refresh_policies(), len(names))
+
+        # one shared object per policy while it is alive
+        for name in names:
+            self.assertTrue(kadm.getpol(name) is kadm.getpol(name))
+
+        self.assertIsNone(kadm.getpol("no_such_policy_exists"))
+
+        kadm.disable_policy_cache()
     
 
 
@@ -450,6 +952,122 @@ class KAdminLocalUnitTests(unittest.TestCase):
 
         self.assertEqual(count[0], size)
 
+    def test_each_iteration_stop(self):
+
+        kadm = self.kadm
+        count = [0]
+
+        def fxn(princ, data):
+            data[0] += 1
+            if data[0] == 2:
+                return kadmin_local.STOP
+
+        kadm.each_principal(fxn, count)
+
+        self.assertEqual(count[0], 2)
+
+    def test_each_iteration_limit(self):
+
+        kadm = self.kadm
+        count = [0]
+
+        def fxn(princ, data):
+            data[0] += 1
+
+        kadm.each_principal(fxn, count, limit=3)
+
+        self.assertEqual(count[0], min(3, database_size()))
+
+    def test_each_iteration_lock_modes(self):
+
+        kadm = self.kadm
+        size = database_size()
+
+        def fxn(princ, data):
+            data[0] += 1
+
+        for mode in ("full", "chunked", "none"):
+            count = [0]
+            kadm.each_principal(fxn, count, lock=mode, chunk=7)
+            self.assertEqual(count[0], size)
+
+        self.assertRaises(ValueError, kadm.each_principal, fxn, [0], lock="bogus")
+
+    def test_each_iteration_callables(self):
+
+        kadm = self.kadm
+        size = database_size()
+
+        class Collector(object):
+            def __init__(self):
+                self.found = []
+            def add(self, princ, data):
+                self.found.append(data)
+
+        # every callable is called as callback(principal, data), data defaulting to None
+        collector = Collector()
+        kadm.each_principal(collector.add)
+        self.assertEqual(collector.found, [None] * size)
+
+        collector = Collector()
+        kadm.each_principal(collector.add, data="tag", limit=1)
+        self.assertEqual(collector.found, ["tag"] * min(1, size))
+
+        found = []
+        kadm.each_principal(functools.partial(lambda sink, princ, data: sink.append(princ), found))
+        self.assertEqual(len(found), size)
+
+    def test_each_iteration_into(self):
+
+        kadm = self.kadm
+        size = database_size()
+
+        create_test_accounts()
+
+        principals = kadm.each_principal(into=list)
+        self.assertEqual(len(principals), database_size())
+
+        by_name = kadm.each_principal(into=dict)
+        self.assertTrue(TEST_ACCOUNTS[0] in by_name)
+
+        names = kadm.each_principal(into=kadmin_local.NameIndex)
+        self.assertEqual(len(names), len(by_name))
+        self.assertTrue(TEST_ACCOUNTS[0] in names)
+        self.assertTrue(kadm.name(TEST_ACCOUNTS[0]) in names)
+        self.assertFalse("missing@EXAMPLE.COM" in names)
+
+        # names that cannot be encoded raise their own error, not MemoryError
+        self.assertRaises(UnicodeEncodeError, lambda: u"m\u00fcller@EXAMPLE.COM" in names)
+        self.assertRaises(UnicodeEncodeError, names.add, u"m\u00fcller@EXAMPLE.COM")
+
+    def test_each_iteration_threads(self):
+
+        kadm = self.kadm
+
+        create_test_accounts()
+
+        # threaded conversion (on klmdb) must agree with the plain scan, in the same order
+        serial = [princ.principal for princ in kadm.each_principal(into=list, threads=0)]
+
+        for threads in (-1, 1, 3):
+            names = [princ.principal for princ in kadm.each_principal(into=list, threads=threads)]
+            self.assertEqual(names, serial)
+
+        found = kadm.each_principal(into=list, threads=2, limit=1)
+        self.assertEqual(len(found), min(1, len(serial)))
+
+    def test_each_iteration_error(self):
+
+        kadm = self.kadm
+        count = [0]
+
+        def fxn(princ, data):
+            data[0] += 1
+            raise ValueError("stop here")
+
+        self.assertRaises(ValueError, kadm.each_principal, fxn, count)
+        self.assertEqual(count[0], 1)
+
     def test_not_exists(self):
         
         kadm = self.kadm